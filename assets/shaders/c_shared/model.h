@@ -51,6 +51,22 @@ struct MeshletCullData
     vec3 coneApex;
 };
 
+// if this is edited, the model version number needs to be bumped in the converter
+// Only generated if the model asked for LODs. Spheres and errors are in the mesh's object space. A meshlet is part of the LOD cut
+// when its own error is acceptable for the view, but its parent's error isn't. The parent is the group of meshlets that this one
+// was simplified into, and parentError is a huge value for meshlets that never got simplified any further
+struct MeshletLODCullData
+{
+    vec3 center; // sphere of the meshlet group that this meshlet was simplified from, or just its own bounds at full detail
+    float radius;
+    vec3 parentCenter;
+    float parentRadius;
+    float error;
+    float parentError;
+    uint lodLevel;
+    uint _pad;
+};
+
 struct VisibleMeshletPayload
 {
     uint meshIdx;
@@ -59,6 +75,9 @@ struct VisibleMeshletPayload
 
 #define MAX_VERTS_PER_MESHLET 64
 #define MAX_TRIS_PER_MESHLET 124
+// The compute culling dispatches one workgroup per meshlet along x, and maxComputeWorkGroupCount[0] is only guaranteed to be 65535.
+// The converter splits up any meshes that could go over this
+#define MAX_MESHLETS_PER_MESH 65535
 
 #define MESH_BUFFER_MESHLETS 0
 #define MESH_BUFFER_MESHLET_CULL_DATA 1
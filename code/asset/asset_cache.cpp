@@ -48,6 +48,7 @@ void Init()
     }
     CreateDirectory( ROOT_DIR + "fastfiles/" );
     CreateDirectory( ROOT_DIR + "shader_preproc/" );
+    CreateDirectory( ROOT_DIR + "spirv/" );
 }
 
 time_t GetAssetTimestamp( AssetType assetType, const std::string& assetCacheName )
@@ -163,20 +164,13 @@ bool CacheAsset( AssetType assetType, const std::string& assetCacheName, BaseAss
     return true;
 }
 
-std::unique_ptr<char[]> GetCachedAssetRaw( AssetType assetType, const std::string& assetCacheName, size_t& numBytes )
+std::string GetCachedAssetPath( AssetType assetType, const std::string& assetCacheName )
 {
-    PGP_ZONE_SCOPEDN( "GetCachedAssetRaw" );
-    numBytes         = 0;
-    std::string path = GetCachedPath( assetType, assetCacheName );
-    Serializer in;
-    if ( !in.OpenForRead( path ) )
-    {
-        return nullptr;
-    }
-    numBytes = in.BytesLeft();
-    std::unique_ptr<char[]> ret( new char[numBytes] );
-    in.Read( ret.get(), numBytes );
-    return ret;
+    return GetCachedPath( assetType, assetCacheName );
 }
 
+std::string GetCacheDirectory( AssetType assetType ) { return ROOT_DIR + assetCacheFolders[assetType]; }
+
+const std::string& GetCacheFileExtension( AssetType assetType ) { return assetCacheFileExtensions[assetType]; }
+
 } // namespace PG::AssetCache
@@ -11,6 +11,8 @@ namespace PG::AssetCache
 void Init();
 time_t GetAssetTimestamp( AssetType assetType, const std::string& assetCacheName );
 bool CacheAsset( AssetType assetType, const std::string& assetCacheName, BaseAsset* asset );
-std::unique_ptr<char[]> GetCachedAssetRaw( AssetType assetType, const std::string& assetCacheName, size_t& numBytes );
+std::string GetCachedAssetPath( AssetType assetType, const std::string& assetCacheName );
+std::string GetCacheDirectory( AssetType assetType );
+const std::string& GetCacheFileExtension( AssetType assetType );
 
 } // namespace PG::AssetCache
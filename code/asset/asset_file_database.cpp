@@ -115,6 +115,17 @@ bool Init()
     return true;
 }
 
+bool Reload()
+{
+    PGP_ZONE_SCOPEDN( "AssetDatabase::Reload" );
+    for ( u32 i = 0; i < ASSET_TYPE_COUNT; ++i )
+    {
+        s_assetInfos[i].clear();
+    }
+
+    return Init();
+}
+
 std::shared_ptr<BaseAssetCreateInfo> FindAssetInfo( AssetType type, const std::string& name )
 {
     auto it = s_assetInfos[type].find( name );
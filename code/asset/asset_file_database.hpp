@@ -9,6 +9,9 @@ namespace PG::AssetDatabase
 
 bool Init();
 
+// Clears all of the parsed asset infos and re-parses every .paf file. Used when the asset files change while running
+bool Reload();
+
 std::shared_ptr<BaseAssetCreateInfo> FindAssetInfo( AssetType type, const std::string& name );
 
 template <typename DerivedAssetCreateInfo>
@@ -168,6 +168,8 @@ bool LoadAssetFromFastFile( Serializer* serializer, AssetType assetType )
     }
     else
     {
+        if constexpr ( std::is_same_v<ActualAssetType, Shader> )
+            AddSkippedShaderSpirvBlob( serializer->GetData(), newAssetEntry.size );
         serializer->Skip( newAssetEntry.size );
         return true;
     }
@@ -213,6 +215,7 @@ bool LoadFastFile( const std::string& ffName, bool debugVersion )
         LOG_ERR( "Failed to open fastfile '%s'", absFilename.c_str() );
         return false;
     }
+    ClearFastfileSpirvBlobs(); // in case the previous fastfile failed to load partway through
 
     while ( serializer.BytesLeft() > 0 )
     {
@@ -232,6 +235,9 @@ bool LoadFastFile( const std::string& ffName, bool debugVersion )
         }
     }
 
+    // the blobs point into the mapped file
+    ClearFastfileSpirvBlobs();
+
     // Note: this takes a surprisingly long time to close the file (50-100ms for sponza_intel)
     // Note2: looks like ::UnmapViewOfFile is the culprit. Cost for removing pages from the
     // address space just seems to be about ~75us per MB, which matches what some others online say
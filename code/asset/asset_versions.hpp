@@ -24,11 +24,11 @@ enum AssetType : u8
 constexpr i32 g_globalAssetVersion = 1; // "New asset metadata"
 
 constexpr i32 g_assetVersions[] = {
-    g_globalAssetVersion + 9,  // ASSET_TYPE_GFX_IMAGE, "New name serialization"
+    g_globalAssetVersion + 13, // ASSET_TYPE_GFX_IMAGE, "Resize back to the stbir filter, box only for mips"
     g_globalAssetVersion + 10, // ASSET_TYPE_MATERIAL,  "New name serialization"
     g_globalAssetVersion + 1,  // ASSET_TYPE_SCRIPT,    "New name serialization"
-    g_globalAssetVersion + 19, // ASSET_TYPE_MODEL,     "Packed UVs"
-    g_globalAssetVersion + 6,  // ASSET_TYPE_SHADER,    "Fixed extension and define usage"
+    g_globalAssetVersion + 23, // ASSET_TYPE_MODEL,     "Per element padding in encoded streams"
+    g_globalAssetVersion + 7,  // ASSET_TYPE_SHADER,    "Spirv hash for deduplicating spirv in fastfiles"
     g_globalAssetVersion + 6,  // ASSET_TYPE_PIPELINE,  "Fixed extension and define usage"
     g_globalAssetVersion + 5,  // ASSET_TYPE_FONT,      "Kerning + switched the edge coloring mode"
 
@@ -94,6 +94,7 @@ bool GfxImageParser::ParseInternal( cjval value, DerivedInfoPtr info )
         { "clampHorizontal", []( cjval v, GfxImageCreateInfo& s ) { s.clampHorizontal = ParseBool( v ); } },
         { "clampVertical",   []( cjval v, GfxImageCreateInfo& s ) { s.clampVertical = ParseBool( v ); } },
         { "filterMode",      []( cjval v, GfxImageCreateInfo& s ) { s.filterMode = GfxImageFilterMode_ParseEnum( v ); } },
+        { "rdoLambda",       []( cjval v, GfxImageCreateInfo& s ) { s.rdoLambda = ParseNumber<f32>( v ); } },
     });
     mapping.ForEachMember( value, IGNORE_LIST, *info );
 
@@ -135,6 +136,9 @@ bool ModelParser::ParseInternal( cjval value, DerivedInfoPtr info )
         { "flipTexCoordsVertically", []( cjval v, ModelCreateInfo& i ) { i.flipTexCoordsVertically = ParseBool( v ); } },
         { "recalculateNormals",      []( cjval v, ModelCreateInfo& i ) { i.recalculateNormals = ParseBool( v ); } },
         { "centerModel",             []( cjval v, ModelCreateInfo& i ) { i.centerModel = ParseBool( v ); } },
+        { "generateMeshletLODs",     []( cjval v, ModelCreateInfo& i ) { i.generateMeshletLODs = ParseBool( v ); } },
+        { "encodeStreams",           []( cjval v, ModelCreateInfo& i ) { i.encodeStreams = ParseBool( v ); } },
+        { "optimizeVertexOrder",     []( cjval v, ModelCreateInfo& i ) { i.optimizeVertexOrder = ParseBool( v ); } },
     });
     mapping.ForEachMember( value, IGNORE_LIST, *info );
 
@@ -314,6 +318,7 @@ bool TexturesetParser::ParseInternal( cjval value, DerivedInfoPtr info )
         { "invertRoughness",        []( cjval v, TexturesetCreateInfo& s ) { s.invertRoughness = ParseBool( v ); } },
         { "roughnessScale",         []( cjval v, TexturesetCreateInfo& s ) { s.roughnessScale = ParseBool( v ); } },
         { "emissiveMap",            []( cjval v, TexturesetCreateInfo& s ) { s.emissiveMap = ParseString( v ); } },
+        { "rdoLambda",              []( cjval v, TexturesetCreateInfo& s ) { s.rdoLambda = ParseNumber<f32>( v ); } },
     });
     mapping.ForEachMember( value, IGNORE_LIST, *info );
 
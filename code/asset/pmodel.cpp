@@ -5,6 +5,8 @@
 #include "shared/logger.hpp"
 #include "shared/serializer.hpp"
 #include "shared/string.hpp"
+#include <algorithm>
+#include <charconv>
 #include <chrono>
 #include <set>
 
@@ -14,26 +16,47 @@ using Clock = high_resolution_clock;
 namespace PG
 {
 
-bool PModel::Vertex::AddBone( u32 boneIdx, f32 weight )
+void PModel::Mesh::Resize( u32 numVertices )
 {
-    if ( numBones < PMODEL_MAX_BONE_WEIGHTS_PER_VERT )
+    positions.resize( numVertices );
+    normals.resize( numVertices );
+    tangents.resize( hasTangents ? numVertices : 0 );
+    bitangents.resize( hasTangents ? numVertices : 0 );
+    uvs.resize( numVertices * numUVChannels );
+    colors.resize( numVertices * numColorChannels );
+    numBones.resize( hasBoneWeights ? numVertices : 0, 0 );
+    boneIndices.resize( hasBoneWeights ? numVertices * PMODEL_MAX_BONE_WEIGHTS_PER_VERT : 0 );
+    boneWeights.resize( hasBoneWeights ? numVertices * PMODEL_MAX_BONE_WEIGHTS_PER_VERT : 0 );
+}
+
+bool PModel::Mesh::AddBone( u32 vIdx, u32 boneIdx, f32 weight )
+{
+    u8& count    = numBones[vIdx];
+    u32* indices = BoneIndices( vIdx );
+    f32* weights = BoneWeights( vIdx );
+    if ( count < PMODEL_MAX_BONE_WEIGHTS_PER_VERT )
     {
-        boneWeights[numBones] = weight;
-        boneIndices[numBones] = boneIdx;
-        ++numBones;
+        weights[count] = weight;
+        indices[count] = boneIdx;
+        ++count;
         return true;
     }
 
-    f32 minWeight = boneWeights[0];
+    f32 minWeight = weights[0];
     u32 minIdx    = 0;
-    for ( u32 slot = 1; slot < numBones; ++slot )
+    for ( u32 slot = 1; slot < count; ++slot )
     {
-        if ( boneWeights[slot] < minWeight )
+        if ( weights[slot] < minWeight )
         {
-            minWeight = boneWeights[slot];
+            minWeight = weights[slot];
             minIdx    = slot;
         }
     }
+    if ( weight > minWeight )
+    {
+        weights[minIdx] = weight;
+        indices[minIdx] = boneIdx;
+    }
 
     return false;
 }
@@ -46,6 +69,106 @@ static std::string GetNameAfterColon( const std::string& line )
     return line.substr( startIdx );
 }
 
+// Versions before CONTIGUOUS_STREAMS interleave all of the vertex attributes, and store as many leading 16 bit indices as possible
+static void LoadLegacyMeshData( Serializer& serializer, PModel::Mesh& mesh )
+{
+    u64 numIndices, num16BitIndices;
+    serializer.Read( numIndices );
+    serializer.Read( num16BitIndices );
+    mesh.indices.resize( numIndices );
+    for ( size_t i = 0; i < num16BitIndices; ++i )
+        mesh.indices[i] = serializer.Read<u16>();
+    serializer.Read( mesh.indices.data() + num16BitIndices, ( numIndices - num16BitIndices ) * sizeof( u32 ) );
+
+    const u32 numVerts = serializer.Read<u32>();
+    mesh.Resize( numVerts );
+    for ( u32 vIdx = 0; vIdx < numVerts; ++vIdx )
+    {
+        serializer.Read( mesh.positions[vIdx] );
+        serializer.Read( mesh.normals[vIdx] );
+        if ( mesh.hasTangents )
+        {
+            serializer.Read( mesh.tangents[vIdx] );
+            serializer.Read( mesh.bitangents[vIdx] );
+        }
+        for ( u32 uvIdx = 0; uvIdx < mesh.numUVChannels; ++uvIdx )
+            serializer.Read( mesh.UV( vIdx, uvIdx ) );
+        for ( u32 cIdx = 0; cIdx < mesh.numColorChannels; ++cIdx )
+            serializer.Read( mesh.Color( vIdx, cIdx ) );
+        if ( mesh.hasBoneWeights )
+        {
+            serializer.Read( mesh.numBones[vIdx] );
+            u32* boneIndices = mesh.BoneIndices( vIdx );
+            f32* boneWeights = mesh.BoneWeights( vIdx );
+            for ( u8 i = 0; i < mesh.numBones[vIdx]; ++i )
+            {
+                serializer.Read( boneIndices[i] );
+                serializer.Read( boneWeights[i] );
+            }
+        }
+    }
+}
+
+// Read and Skip only bounds check in debug builds, so the stream reads below have to check that the file is long enough first.
+// Align can step past the end of a truncated file, which is why the padding is worked out from BytesLeft before and after
+static bool AlignAndCheckBytesLeft( Serializer& serializer, size_t bytes )
+{
+    const size_t bytesLeft = serializer.BytesLeft();
+    serializer.Align( PMODEL_STREAM_ALIGNMENT );
+    const size_t padding = bytesLeft - serializer.BytesLeft();
+    return padding <= bytesLeft && bytes <= bytesLeft - padding;
+}
+
+template <typename T>
+static bool ReadStream( Serializer& serializer, std::vector<T>& stream )
+{
+    if ( !AlignAndCheckBytesLeft( serializer, stream.size() * sizeof( T ) ) )
+        return false;
+
+    serializer.Read( stream.data(), stream.size() * sizeof( T ) );
+    return true;
+}
+
+template <typename T>
+static void WriteStream( Serializer& serializer, const std::vector<T>& stream )
+{
+    serializer.Align( PMODEL_STREAM_ALIGNMENT );
+    serializer.Write( stream.data(), stream.size() * sizeof( T ) );
+}
+
+// Bone streams only store as many slots per vertex as the vertex with the most bones uses, instead of all PMODEL_MAX_BONE_WEIGHTS_PER_VERT
+template <typename T>
+static bool ReadBoneStream( Serializer& serializer, std::vector<T>& stream, u32 numVerts, u32 slotsPerVert )
+{
+    if ( !AlignAndCheckBytesLeft( serializer, static_cast<size_t>( numVerts ) * slotsPerVert * sizeof( T ) ) )
+        return false;
+
+    if ( slotsPerVert == PMODEL_MAX_BONE_WEIGHTS_PER_VERT )
+    {
+        serializer.Read( stream.data(), stream.size() * sizeof( T ) );
+        return true;
+    }
+
+    for ( u32 vIdx = 0; vIdx < numVerts; ++vIdx )
+        serializer.Read( &stream[vIdx * PMODEL_MAX_BONE_WEIGHTS_PER_VERT], slotsPerVert * sizeof( T ) );
+
+    return true;
+}
+
+template <typename T>
+static void WriteBoneStream( Serializer& serializer, const std::vector<T>& stream, u32 numVerts, u32 slotsPerVert )
+{
+    serializer.Align( PMODEL_STREAM_ALIGNMENT );
+    if ( slotsPerVert == PMODEL_MAX_BONE_WEIGHTS_PER_VERT )
+    {
+        serializer.Write( stream.data(), stream.size() * sizeof( T ) );
+        return;
+    }
+
+    for ( u32 vIdx = 0; vIdx < numVerts; ++vIdx )
+        serializer.Write( &stream[vIdx * PMODEL_MAX_BONE_WEIGHTS_PER_VERT], slotsPerVert * sizeof( T ) );
+}
+
 bool PModel::LoadBinary( std::string_view filename )
 {
     Serializer serializer;
@@ -87,59 +210,246 @@ bool PModel::LoadBinary( std::string_view filename )
         serializer.Read( mesh.numColorChannels );
         serializer.Read( mesh.hasTangents );
         serializer.Read( mesh.hasBoneWeights );
+        if ( m_loadedVersionNum < PModelVersionNum::CONTIGUOUS_STREAMS )
+        {
+            LoadLegacyMeshData( serializer, mesh );
+            continue;
+        }
 
-        u64 numIndices, num16BitIndices;
-        serializer.Read( numIndices );
-        serializer.Read( num16BitIndices );
-        mesh.indices.resize( numIndices );
-        for ( size_t i = 0; i < num16BitIndices; ++i )
-            mesh.indices[i] = serializer.Read<u16>();
-        serializer.Read( mesh.indices.data() + num16BitIndices, ( numIndices - num16BitIndices ) * sizeof( u32 ) );
-
-        mesh.vertices.resize( serializer.Read<u32>() );
-        for ( size_t vIdx = 0; vIdx < mesh.vertices.size(); ++vIdx )
-        {
-            Vertex& v = mesh.vertices[vIdx];
-            serializer.Read( v.pos );
-            serializer.Read( v.normal );
-            if ( mesh.hasTangents )
-            {
-                serializer.Read( v.tangent );
-                serializer.Read( v.bitangent );
-            }
-            for ( u32 uvIdx = 0; uvIdx < mesh.numUVChannels; ++uvIdx )
-                serializer.Read( v.uvs[uvIdx] );
-            for ( u32 cIdx = 0; cIdx < mesh.numColorChannels; ++cIdx )
-                serializer.Read( v.colors[cIdx] );
-            if ( mesh.hasBoneWeights )
+        // Every stream is stored back to back and aligned, so each one is a single copy out of the mapped file.
+        // Meshes with less than 64k vertices store 16 bit indices, which are widened straight from the mapped file
+        const u32 numVerts = serializer.Read<u32>();
+        mesh.indices.resize( serializer.Read<u32>() );
+        const u32 boneSlotsPerVert = mesh.hasBoneWeights ? serializer.Read<u8>() : 0;
+        if ( boneSlotsPerVert > PMODEL_MAX_BONE_WEIGHTS_PER_VERT )
+        {
+            LOG_ERR( "PModelb file %s is corrupt: mesh '%s' has %u bone slots per vertex, but the max is %u", filename.data(),
+                mesh.name.c_str(), boneSlotsPerVert, PMODEL_MAX_BONE_WEIGHTS_PER_VERT );
+            return false;
+        }
+        mesh.Resize( numVerts );
+
+        bool streamsRead = true;
+        if ( numVerts <= UINT16_MAX + 1 )
+        {
+            streamsRead = AlignAndCheckBytesLeft( serializer, mesh.indices.size() * sizeof( u16 ) );
+            if ( streamsRead )
             {
-                serializer.Read( v.numBones );
-                for ( u8 i = 0; i < v.numBones; ++i )
-                {
-                    serializer.Read( v.boneIndices[i] );
-                    serializer.Read( v.boneWeights[i] );
-                }
+                const u16* indices16 = reinterpret_cast<const u16*>( serializer.GetData() );
+                for ( size_t i = 0; i < mesh.indices.size(); ++i )
+                    mesh.indices[i] = indices16[i];
+                serializer.Skip( mesh.indices.size() * sizeof( u16 ) );
             }
         }
+        else
+        {
+            streamsRead = ReadStream( serializer, mesh.indices );
+        }
+        streamsRead = streamsRead && ReadStream( serializer, mesh.positions ) && ReadStream( serializer, mesh.normals ) &&
+                      ReadStream( serializer, mesh.tangents ) && ReadStream( serializer, mesh.bitangents ) &&
+                      ReadStream( serializer, mesh.uvs ) && ReadStream( serializer, mesh.colors );
+        if ( streamsRead && mesh.hasBoneWeights )
+        {
+            streamsRead = ReadStream( serializer, mesh.numBones ) &&
+                          ReadBoneStream( serializer, mesh.boneIndices, numVerts, boneSlotsPerVert ) &&
+                          ReadBoneStream( serializer, mesh.boneWeights, numVerts, boneSlotsPerVert );
+        }
+        if ( !streamsRead )
+        {
+            LOG_ERR( "PModelb file %s is truncated: the streams of mesh '%s' run past the end of the file", filename.data(),
+                mesh.name.c_str() );
+            return false;
+        }
     }
 
     return true;
 }
 
+// Line reader over a memory mapped .pmodelt. Lines are returned without the '\n' (or "\r\n"), and reading past the end
+// just returns empty lines, same as std::getline would
+struct TextLineReader
+{
+    const char* pos;
+    const char* end;
+
+    bool AtEnd() const { return pos >= end; }
+
+    std::string_view NextLine()
+    {
+        const char* lineEnd = static_cast<const char*>( memchr( pos, '\n', end - pos ) );
+        if ( !lineEnd )
+            lineEnd = end;
+        std::string_view line( pos, lineEnd - pos );
+        pos = lineEnd < end ? lineEnd + 1 : end;
+        if ( !line.empty() && line.back() == '\r' )
+            line.remove_suffix( 1 );
+
+        return line;
+    }
+};
+
+static bool IsSpace( char c ) { return c == ' ' || c == '\t'; }
+
+// Skips past the first numTokens whitespace separated tokens of the line, like the leading '%s's in the old sscanf formats
+static const char* SkipTokens( std::string_view line, u32 numTokens )
+{
+    const char* p   = line.data();
+    const char* end = p + line.size();
+    for ( u32 i = 0; i < numTokens; ++i )
+    {
+        while ( p < end && IsSpace( *p ) )
+            ++p;
+        while ( p < end && !IsSpace( *p ) )
+            ++p;
+    }
+
+    return p;
+}
+
+// Each of these leaves the value untouched and returns nullptr if there is no number to parse, so that the rest of the line
+// is skipped too, same as sscanf would stop at the first failed conversion
+static const char* ParseF32( const char* p, const char* end, f32& x )
+{
+    while ( p < end && IsSpace( *p ) )
+        ++p;
+    auto [ptr, ec] = std::from_chars( p, end, x );
+    if ( ec == std::errc::result_out_of_range )
+    {
+        // from_chars reports denormals and overflows as out of range without writing them, but sscanf still returns the
+        // denormal (or inf), so parse the few of those with strtof to get the same result
+        std::string token( p, ptr );
+        x = strtof( token.c_str(), nullptr );
+    }
+    else if ( ec != std::errc() )
+    {
+        return nullptr;
+    }
+
+    return ptr;
+}
+
+static const char* ParseU32( const char* p, const char* end, u32& x )
+{
+    while ( p < end && IsSpace( *p ) )
+        ++p;
+    auto [ptr, ec] = std::from_chars( p, end, x );
+
+    return ec == std::errc() ? ptr : nullptr;
+}
+
+static void ParseF32s( std::string_view line, u32 numTagTokens, f32* dst, u32 count )
+{
+    const char* p   = SkipTokens( line, numTagTokens );
+    const char* end = line.data() + line.size();
+    for ( u32 i = 0; i < count && p; ++i )
+        p = ParseF32( p, end, dst[i] );
+}
+
+struct TextVertexCounts
+{
+    u32 numUVs        = 0;
+    u32 numColors     = 0;
+    u32 numTangents   = 0;
+    u32 numBitangents = 0;
+};
+
+// Parses numVerts vertex blocks, the first of which is vertex firstVert, and is at the start of the reader.
+// The mesh needs to already be sized for all of them, so that any number of these can run on separate parts of the mesh at once
+static void ParseTextVertexBlocks( TextLineReader reader, PModel::Mesh& mesh, u32 firstVert, u32 numVerts, TextVertexCounts& counts )
+{
+    for ( u32 vIdx = firstVert; vIdx < firstVert + numVerts; ++vIdx )
+    {
+        reader.NextLine(); // V vIdx
+        u32 numUVs        = 0;
+        u32 numColors     = 0;
+        u32 numTangents   = 0;
+        u32 numBitangents = 0;
+        for ( std::string_view line = reader.NextLine(); !line.empty(); line = reader.NextLine() )
+        {
+            const char c1 = line.size() > 1 ? line[1] : '\0';
+            if ( line[0] == 'p' )
+            {
+                ParseF32s( line, 1, &mesh.positions[vIdx].x, 3 );
+            }
+            else if ( line[0] == 'n' )
+            {
+                ParseF32s( line, 1, &mesh.normals[vIdx].x, 3 );
+            }
+            else if ( line[0] == 't' )
+            {
+                ParseF32s( line, 1, &mesh.tangents[vIdx].x, 3 );
+                ++numTangents;
+            }
+            else if ( line[0] == 'u' && c1 == 'v' )
+            {
+                if ( numUVs < mesh.numUVChannels )
+                    ParseF32s( line, 1, &mesh.UV( vIdx, numUVs ).x, 2 );
+                ++numUVs;
+            }
+            else if ( line[0] == 'c' )
+            {
+                if ( numColors < mesh.numColorChannels )
+                    ParseF32s( line, 1, &mesh.Color( vIdx, numColors ).x, 4 );
+                ++numColors;
+            }
+            else if ( line[0] == 'b' && c1 == 'w' )
+            {
+                const char* end = line.data() + line.size();
+                u32 boneIdx     = 0;
+                f32 weight      = 0;
+                const char* p   = ParseU32( SkipTokens( line, 1 ), end, boneIdx );
+                if ( p )
+                    ParseF32( p, end, weight );
+                mesh.AddBone( vIdx, boneIdx, weight );
+            }
+            else if ( line[0] == 'b' )
+            {
+                ParseF32s( line, 1, &mesh.bitangents[vIdx].x, 3 );
+                ++numBitangents;
+            }
+        }
+
+#if USING( DEBUG_BUILD )
+        if ( numTangents > 1 )
+            LOG_WARN( "Mesh %s vertex %u has more than 1 tangent specified", mesh.name.c_str(), vIdx );
+        if ( numBitangents > 1 )
+            LOG_WARN( "Mesh %s vertex %u has more than 1 bittangent specified", mesh.name.c_str(), vIdx );
+        if ( numTangents && !numBitangents )
+            LOG_WARN( "Mesh %s vertex %u has a tangent specified, but no bitangent", mesh.name.c_str(), vIdx );
+        if ( !numTangents && numBitangents )
+            LOG_WARN( "Mesh %s vertex %u has a bitangent specified, but no tangent", mesh.name.c_str(), vIdx );
+#endif // #if USING( DEBUG_BUILD )
+
+        counts.numUVs += numUVs;
+        counts.numColors += numColors;
+        counts.numTangents += numTangents;
+        counts.numBitangents += numBitangents;
+    }
+}
+
+// How many vertex blocks each thread parses at a time
+static constexpr u32 TEXT_VERTEX_CHUNK_SIZE = 4096u;
+
+// Just mmaps the file and tokenizes it in place with from_chars, instead of copying every line into a string and sscanf'ing it.
+// Each mesh's vertex section is first scanned once to count the vertices and find where every TEXT_VERTEX_CHUNK_SIZE'th one starts,
+// and then the chunks get parsed in parallel straight into the mesh's streams. Follows the exact same rules as the original
+// getline + sscanf parser (kept in model_benchmark to check against), and gives identical results
 bool PModel::LoadText( std::string_view filename )
 {
-    std::ifstream in( filename.data() );
-    if ( !in )
+    Serializer serializer;
+    if ( !serializer.OpenForRead( filename.data() ) )
     {
         LOG_ERR( "Failed to open pmodelt file '%s'", filename.data() );
         return false;
     }
 
-    char tmpBuffer[128];
-    std::string tmp;
-    in >> tmp; // pmodelFormat
-    u16 version;
-    in >> version;
+    const char* fileStart = reinterpret_cast<const char*>( serializer.GetData() );
+    TextLineReader reader{ fileStart, fileStart + serializer.BytesLeft() };
+
+    // pmodelFormat: version
+    std::string_view line = reader.NextLine();
+    u32 version           = 0;
+    ParseU32( SkipTokens( line, 1 ), line.data() + line.size(), version );
     m_loadedVersionNum = PModelVersionNum( version );
     if ( m_loadedVersionNum < PModelVersionNum::LAST_SUPPORTED_VERSION )
     {
@@ -148,141 +458,110 @@ bool PModel::LoadText( std::string_view filename )
         return false;
     }
 
-    auto SkipEmptyLines = []( std::ifstream& inFile, std::string& line )
+    // skip the material list (not actually needed outside of converter)
+    do
     {
-        do
-        {
-            std::getline( inFile, line );
-        } while ( line.empty() );
-    };
-
-    //  skip to material list
-    std::string line;
-    SkipEmptyLines( in, line );
-
-    // parse material list (not actually needed outside of converter)
+        line = reader.NextLine();
+    } while ( line.empty() && !reader.AtEnd() );
     do
     {
-        std::getline( in, line );
+        line = reader.NextLine();
     } while ( !line.empty() );
 
     if ( m_loadedVersionNum >= PModelVersionNum::MODEL_AABB )
     {
         // Model AABB Min: float float float
-        std::getline( in, line );
-        sscanf( line.c_str(), "%s %s %s %f %f %f", tmpBuffer, tmpBuffer, tmpBuffer, &aabbMin.x, &aabbMin.y, &aabbMin.z );
+        ParseF32s( reader.NextLine(), 3, &aabbMin.x, 3 );
         // Model AABB Max: float float float
-        std::getline( in, line );
-        sscanf( line.c_str(), "%s %s %s %f %f %f", tmpBuffer, tmpBuffer, tmpBuffer, &aabbMax.x, &aabbMax.y, &aabbMax.z );
+        ParseF32s( reader.NextLine(), 3, &aabbMax.x, 3 );
     }
 
-    while ( std::getline( in, line ) && line.substr( 0, 4 ) == "Mesh" )
+    std::vector<const char*> chunkStarts;
+    std::vector<TextVertexCounts> chunkCounts;
+    for ( line = reader.NextLine(); line.starts_with( "Mesh" ); line = reader.NextLine() )
     {
-        Mesh& mesh = meshes.emplace_back();
-        mesh.name  = GetNameAfterColon( line );
-        std::getline( in, line );
-        mesh.materialName = GetNameAfterColon( line );
-        std::getline( in, line );
-        sscanf( line.c_str(), "%s %u", tmpBuffer, &mesh.numUVChannels );
-        std::getline( in, line );
-        sscanf( line.c_str(), "%s %u", tmpBuffer, &mesh.numColorChannels );
+        Mesh& mesh        = meshes.emplace_back();
+        mesh.name         = GetNameAfterColon( std::string( line ) );
+        line              = reader.NextLine();
+        mesh.materialName = GetNameAfterColon( std::string( line ) );
+        line              = reader.NextLine();
+        ParseU32( SkipTokens( line, 1 ), line.data() + line.size(), mesh.numUVChannels );
+        line = reader.NextLine();
+        ParseU32( SkipTokens( line, 1 ), line.data() + line.size(), mesh.numColorChannels );
 
         // skip to first vertex
-        SkipEmptyLines( in, line );
-
-        u32 meshNumUVs        = 0;
-        u32 meshNumColors     = 0;
-        u32 meshNumTangents   = 0;
-        u32 meshNumBitangents = 0;
-
-        mesh.vertices.reserve( 65536 );
+        do
+        {
+            line = reader.NextLine();
+        } while ( line.empty() && !reader.AtEnd() );
+
+        // Every vertex block is a 'V' line, followed by its attributes, and then an empty line. The section ends at the first
+        // line after a block that isn't a 'V' line. Bone weights have to be known up front, so that the streams can be sized
+        u32 numVerts        = 0;
+        mesh.hasBoneWeights = false;
+        chunkStarts.clear();
         while ( !line.empty() && line[0] == 'V' )
         {
-            Vertex& v         = mesh.vertices.emplace_back();
-            u32 numUVs        = 0;
-            u32 numColors     = 0;
-            u32 numTangents   = 0;
-            u32 numBitangents = 0;
-
-            std::getline( in, line );
-            while ( !line.empty() )
-            {
-                if ( line[0] == 'p' )
-                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &v.pos.x, &v.pos.y, &v.pos.z );
-                else if ( line[0] == 'n' )
-                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &v.normal.x, &v.normal.y, &v.normal.z );
-                else if ( line[0] == 't' )
-                {
-                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &v.tangent.x, &v.tangent.y, &v.tangent.z );
-                    ++numTangents;
-                }
-                else if ( line[0] == 'u' && line[1] == 'v' )
-                {
-                    sscanf( line.c_str(), "%s %f %f", tmpBuffer, &v.uvs[numUVs].x, &v.uvs[numUVs].y );
-                    ++numUVs;
-                }
-                else if ( line[0] == 'c' )
-                {
-                    sscanf( line.c_str(), "%s %f %f %f %f", tmpBuffer, &v.colors[numColors].x, &v.colors[numColors].y,
-                        &v.colors[numColors].z, &v.colors[numColors].w );
-                    ++numColors;
-                }
-                else if ( line[0] == 'b' && line[1] == 'w' )
-                {
-                    sscanf( line.c_str(), "%s %u %f", tmpBuffer, &v.boneIndices[v.numBones], &v.boneWeights[v.numBones] );
-                    ++v.numBones;
-                }
-                else if ( line[0] == 'b' )
-                {
-                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &v.bitangent.x, &v.bitangent.y, &v.bitangent.z );
-                    ++numBitangents;
-                }
-
-                std::getline( in, line );
-            }
-
-#if USING( DEBUG_BUILD )
-            if ( numTangents > 1 )
-                LOG_WARN( "Mesh %s vertex %u has more than 1 tangent specified", mesh.name.c_str(), (u32)mesh.vertices.size() - 1 );
-            if ( numBitangents > 1 )
-                LOG_WARN( "Mesh %s vertex %u has more than 1 bittangent specified", mesh.name.c_str(), (u32)mesh.vertices.size() - 1 );
-            if ( numTangents && !numBitangents )
-                LOG_WARN( "Mesh %s vertex %u has a tangent specified, but no bitangent", mesh.name.c_str(), (u32)mesh.vertices.size() - 1 );
-            if ( !numTangents && numBitangents )
-                LOG_WARN( "Mesh %s vertex %u has a bitangent specified, but no tangent", mesh.name.c_str(), (u32)mesh.vertices.size() - 1 );
-#endif // #if USING( DEBUG_BUILD )
-
-            meshNumUVs += numUVs;
-            meshNumColors += numColors;
-            meshNumTangents += numTangents;
-            meshNumBitangents += numBitangents;
-            mesh.hasBoneWeights = mesh.hasBoneWeights || ( v.numBones > 0 );
+            if ( numVerts % TEXT_VERTEX_CHUNK_SIZE == 0 )
+                chunkStarts.push_back( line.data() );
+            ++numVerts;
+            for ( line = reader.NextLine(); !line.empty(); line = reader.NextLine() )
+                mesh.hasBoneWeights = mesh.hasBoneWeights || ( line.size() > 1 && line[0] == 'b' && line[1] == 'w' );
+            line = reader.NextLine();
+        }
+        const char* sectionEnd = line.data();
+
+        // Whether the mesh has tangents is only known after all of the vertices are parsed. So the tangent streams
+        // are always filled in, and then dropped if no vertex had any
+        mesh.hasTangents = true;
+        mesh.Resize( numVerts );
+        const i32 numChunks = static_cast<i32>( chunkStarts.size() );
+        chunkCounts.assign( numChunks, {} );
+#pragma omp parallel for schedule( dynamic ) if ( numChunks > 1 )
+        for ( i32 chunk = 0; chunk < numChunks; ++chunk )
+        {
+            const u32 firstVert  = chunk * TEXT_VERTEX_CHUNK_SIZE;
+            const u32 chunkVerts = std::min( TEXT_VERTEX_CHUNK_SIZE, numVerts - firstVert );
+            const char* chunkEnd = chunk + 1 < numChunks ? chunkStarts[chunk + 1] : sectionEnd;
+            TextLineReader chunkReader{ chunkStarts[chunk], chunkEnd };
+            ParseTextVertexBlocks( chunkReader, mesh, firstVert, chunkVerts, chunkCounts[chunk] );
+        }
 
-            std::getline( in, line );
+        TextVertexCounts counts;
+        for ( const TextVertexCounts& chunk : chunkCounts )
+        {
+            counts.numUVs += chunk.numUVs;
+            counts.numColors += chunk.numColors;
+            counts.numTangents += chunk.numTangents;
+            counts.numBitangents += chunk.numBitangents;
         }
 
-        if ( meshNumUVs != mesh.vertices.size() * mesh.numUVChannels )
+        if ( counts.numUVs != numVerts * mesh.numUVChannels )
             LOG_WARN( "Not every vertex in mesh %s specified the expected uvs!", mesh.name.c_str() );
-        if ( meshNumColors != mesh.vertices.size() * mesh.numColorChannels )
+        if ( counts.numColors != numVerts * mesh.numColorChannels )
             LOG_WARN( "Not every vertex in mesh %s specified the expected vertex colors!", mesh.name.c_str() );
-        if ( meshNumTangents && meshNumTangents != mesh.vertices.size() )
+        if ( counts.numTangents && counts.numTangents != numVerts )
             LOG_WARN( "Only some, but not all of the vertices in mesh %s specified tangents!", mesh.name.c_str() );
-        if ( meshNumBitangents && meshNumBitangents != mesh.vertices.size() )
+        if ( counts.numBitangents && counts.numBitangents != numVerts )
             LOG_WARN( "Only some, but not all of the vertices in mesh %s specified bitangents!", mesh.name.c_str() );
 
-        mesh.hasTangents = meshNumTangents > 0 && meshNumBitangents > 0;
+        mesh.hasTangents = counts.numTangents > 0 && counts.numBitangents > 0;
+        if ( !mesh.hasTangents )
+        {
+            mesh.tangents   = {};
+            mesh.bitangents = {};
+        }
 
         PG_ASSERT( line == "Tris:" );
-        std::getline( in, line );
-        mesh.indices.reserve( mesh.vertices.size() * 2 );
-        while ( !line.empty() )
-        {
-            u32 i0, i1, i2;
-            sscanf( line.c_str(), "%u %u %u", &i0, &i1, &i2 );
-            mesh.indices.push_back( i0 );
-            mesh.indices.push_back( i1 );
-            mesh.indices.push_back( i2 );
-            std::getline( in, line );
+        mesh.indices.reserve( numVerts * 2 );
+        for ( line = reader.NextLine(); !line.empty(); line = reader.NextLine() )
+        {
+            const char* end = line.data() + line.size();
+            u32 tri[3]      = {};
+            const char* p   = line.data();
+            for ( u32 i = 0; i < 3 && p; ++i )
+                p = ParseU32( p, end, tri[i] );
+            mesh.indices.insert( mesh.indices.end(), tri, tri + 3 );
         }
     }
     PG_ASSERT( meshes.size() );
@@ -344,7 +623,7 @@ bool PModel::SaveText( std::string_view filename, u32 f32Precision, bool logProg
     std::set<std::string_view> materialSet;
     for ( const PModel::Mesh& mesh : meshes )
     {
-        totalVerts += mesh.vertices.size();
+        totalVerts += mesh.NumVertices();
         totalTris += mesh.indices.size() / 3;
         materialSet.insert( mesh.materialName );
     }
@@ -360,6 +639,7 @@ bool PModel::SaveText( std::string_view filename, u32 f32Precision, bool logProg
     char buffer[1024];
 
     sprintf( buffer, "Model AABB Min: %g %g %g\n", aabbMin.x, aabbMin.y, aabbMin.z );
+    outFile << buffer;
     sprintf( buffer, "Model AABB Max: %g %g %g\n", aabbMax.x, aabbMax.y, aabbMax.z );
     outFile << buffer;
 
@@ -374,28 +654,34 @@ bool PModel::SaveText( std::string_view filename, u32 f32Precision, bool logProg
             m.numUVChannels, m.numColorChannels );
         outFile << buffer;
 
-        PG_ASSERT( m.vertices.size() <= UINT32_MAX );
-        for ( u32 vIdx = 0; vIdx < (u32)m.vertices.size(); ++vIdx )
+        for ( u32 vIdx = 0; vIdx < m.NumVertices(); ++vIdx )
         {
-            const PModel::Vertex& v = m.vertices[vIdx];
-            i32 pos = sprintf( buffer, fmtStrings[POS_AND_NORMAL].c_str(), vIdx, PZ( v.pos.x ), PZ( v.pos.y ), PZ( v.pos.z ),
-                PZ( v.normal.x ), PZ( v.normal.y ), PZ( v.normal.z ) );
+            const vec3& p = m.positions[vIdx];
+            const vec3& n = m.normals[vIdx];
+            i32 pos       = sprintf(
+                buffer, fmtStrings[POS_AND_NORMAL].c_str(), vIdx, PZ( p.x ), PZ( p.y ), PZ( p.z ), PZ( n.x ), PZ( n.y ), PZ( n.z ) );
             if ( m.hasTangents )
             {
-                pos += sprintf( buffer + pos, fmtStrings[TANGENTS].c_str(), PZ( v.tangent.x ), PZ( v.tangent.y ), PZ( v.tangent.z ),
-                    PZ( v.bitangent.x ), PZ( v.bitangent.y ), PZ( v.bitangent.z ) );
+                const vec3& t = m.tangents[vIdx];
+                const vec3& b = m.bitangents[vIdx];
+                pos += sprintf(
+                    buffer + pos, fmtStrings[TANGENTS].c_str(), PZ( t.x ), PZ( t.y ), PZ( t.z ), PZ( b.x ), PZ( b.y ), PZ( b.z ) );
             }
             for ( u32 i = 0; i < m.numUVChannels; ++i )
-                pos += sprintf( buffer + pos, fmtStrings[UV].c_str(), PZ( v.uvs[i].x ), PZ( v.uvs[i].y ) );
+                pos += sprintf( buffer + pos, fmtStrings[UV].c_str(), PZ( m.UV( vIdx, i ).x ), PZ( m.UV( vIdx, i ).y ) );
 
             for ( u32 i = 0; i < m.numColorChannels; ++i )
-                pos += sprintf( buffer + pos, fmtStrings[COLOR].c_str(), PZ( v.colors[i].x ), PZ( v.colors[i].y ), PZ( v.colors[i].z ),
-                    PZ( v.colors[i].w ) );
+            {
+                const vec4& c = m.Color( vIdx, i );
+                pos += sprintf( buffer + pos, fmtStrings[COLOR].c_str(), PZ( c.x ), PZ( c.y ), PZ( c.z ), PZ( c.w ) );
+            }
 
             if ( m.hasBoneWeights )
             {
-                for ( u8 i = 0; i < v.numBones; ++i )
-                    pos += sprintf( buffer + pos, fmtStrings[BONE].c_str(), v.boneIndices[i], PZ( v.boneWeights[i] ) );
+                const u32* boneIndices = m.BoneIndices( vIdx );
+                const f32* boneWeights = m.BoneWeights( vIdx );
+                for ( u8 i = 0; i < m.numBones[vIdx]; ++i )
+                    pos += sprintf( buffer + pos, fmtStrings[BONE].c_str(), boneIndices[i], PZ( boneWeights[i] ) );
             }
 
             pos += sprintf( buffer + pos, "\n" );
@@ -411,7 +697,7 @@ bool PModel::SaveText( std::string_view filename, u32 f32Precision, bool logProg
 
         outFile << '\n';
 
-        vertsWritten += m.vertices.size();
+        vertsWritten += m.NumVertices();
         i32 currentPercent = static_cast<i32>( vertsWritten / (f64)totalVerts * 100 );
         if ( logProgress && currentPercent - lastPercent >= 10 )
         {
@@ -465,44 +751,38 @@ bool PModel::SaveBinary( std::string_view filename ) const
         serializer.Write( mesh.hasTangents );
         serializer.Write( mesh.hasBoneWeights );
 
-        serializer.Write( mesh.indices.size() );
-        // to save some space, try to save as many 16 bit indices as possible initially
-        size_t first32Index = 0;
-        while ( first32Index < mesh.indices.size() && mesh.indices[first32Index] <= UINT16_MAX )
-            ++first32Index;
-
-        serializer.Write( first32Index );
-        for ( size_t i = 0; i < first32Index; ++i )
-            serializer.Write( (u16)mesh.indices[i] );
-        for ( size_t i = first32Index; i < mesh.indices.size(); ++i )
-            serializer.Write( mesh.indices[i] );
-
-        PG_ASSERT( mesh.vertices.size() <= UINT32_MAX );
-        u32 numVerts = (u32)mesh.vertices.size();
+        const u32 numVerts = mesh.NumVertices();
+        PG_ASSERT( mesh.indices.size() <= UINT32_MAX );
         serializer.Write( numVerts );
-        for ( u32 vIdx = 0; vIdx < numVerts; ++vIdx )
+        serializer.Write( (u32)mesh.indices.size() );
+        u8 boneSlotsPerVert = 0;
+        if ( mesh.hasBoneWeights )
         {
-            const Vertex& v = mesh.vertices[vIdx];
-            serializer.Write( v.pos );
-            serializer.Write( v.normal );
-            if ( mesh.hasTangents )
-            {
-                serializer.Write( v.tangent );
-                serializer.Write( v.bitangent );
-            }
-            for ( u32 uvIdx = 0; uvIdx < mesh.numUVChannels; ++uvIdx )
-                serializer.Write( v.uvs[uvIdx] );
-            for ( u32 cIdx = 0; cIdx < mesh.numColorChannels; ++cIdx )
-                serializer.Write( v.colors[cIdx] );
-            if ( mesh.hasBoneWeights )
-            {
-                serializer.Write( v.numBones );
-                for ( u8 i = 0; i < v.numBones; ++i )
-                {
-                    serializer.Write( v.boneIndices[i] );
-                    serializer.Write( v.boneWeights[i] );
-                }
-            }
+            for ( u8 numBones : mesh.numBones )
+                boneSlotsPerVert = std::max( boneSlotsPerVert, numBones );
+            serializer.Write( boneSlotsPerVert );
+        }
+
+        if ( numVerts <= UINT16_MAX + 1 )
+        {
+            std::vector<u16> indices16( mesh.indices.begin(), mesh.indices.end() );
+            WriteStream( serializer, indices16 );
+        }
+        else
+        {
+            WriteStream( serializer, mesh.indices );
+        }
+        WriteStream( serializer, mesh.positions );
+        WriteStream( serializer, mesh.normals );
+        WriteStream( serializer, mesh.tangents );
+        WriteStream( serializer, mesh.bitangents );
+        WriteStream( serializer, mesh.uvs );
+        WriteStream( serializer, mesh.colors );
+        if ( mesh.hasBoneWeights )
+        {
+            WriteStream( serializer, mesh.numBones );
+            WriteBoneStream( serializer, mesh.boneIndices, numVerts, boneSlotsPerVert );
+            WriteBoneStream( serializer, mesh.boneWeights, numVerts, boneSlotsPerVert );
         }
     }
     serializer.Close();
@@ -530,11 +810,10 @@ void PModel::CalculateAABB()
     aabbMax = vec3( -FLT_MAX );
     for ( size_t meshIdx = 0; meshIdx < meshes.size(); ++meshIdx )
     {
-        const Mesh& m = meshes[meshIdx];
-        for ( size_t vIdx = 0; vIdx < m.vertices.size(); ++vIdx )
+        for ( const vec3& pos : meshes[meshIdx].positions )
         {
-            aabbMin = Min( aabbMin, m.vertices[vIdx].pos );
-            aabbMax = Max( aabbMax, m.vertices[vIdx].pos );
+            aabbMin = Min( aabbMin, pos );
+            aabbMax = Max( aabbMax, pos );
         }
     }
 }
@@ -549,7 +828,7 @@ void PModel::PrintInfo( std::string tabLevel ) const
     {
         materialSet.insert( mesh.materialName );
         numTris += mesh.indices.size() / 3;
-        numVerts += mesh.vertices.size();
+        numVerts += mesh.NumVertices();
     }
 
     const char* tab = tabLevel.c_str();
@@ -564,7 +843,7 @@ void PModel::PrintInfo( std::string tabLevel ) const
         LOG( "%sMesh[%zu]: '%s'", tab, meshIdx, m.name.c_str() );
         LOG( "%s    Material: '%s'", tab, m.materialName.c_str() );
         LOG( "%s    Num tris: %zu", tab, m.indices.size() / 3 );
-        LOG( "%s    Num verts: %zu", tab, m.vertices.size() );
+        LOG( "%s    Num verts: %u", tab, m.NumVertices() );
         LOG( "%s    Num uv channels: %u", tab, m.numUVChannels );
         LOG( "%s    Num color channels: %u", tab, m.numUVChannels );
         LOG( "%s    Has tangents: %u", tab, m.hasTangents );
@@ -576,19 +855,18 @@ void PModel::PrintInfo( std::string tabLevel ) const
 
         size_t meshBytes = 0;
         meshBytes += first32Index * sizeof( u16 ) + ( m.indices.size() - first32Index ) * sizeof( u32 );
-        meshBytes += m.vertices.size() * 2 * sizeof( vec3 ) + sizeof( vec3 );
-        if ( m.hasTangents )
-            meshBytes += m.vertices.size() * 2 * sizeof( vec3 );
-        meshBytes += m.vertices.size() * m.numUVChannels * sizeof( vec2 );
-        meshBytes += m.vertices.size() * m.numColorChannels * sizeof( vec4 );
+        meshBytes += m.positions.size() * sizeof( vec3 ) + m.normals.size() * sizeof( vec3 );
+        meshBytes += m.tangents.size() * sizeof( vec3 ) + m.bitangents.size() * sizeof( vec3 );
+        meshBytes += m.uvs.size() * sizeof( vec2 );
+        meshBytes += m.colors.size() * sizeof( vec4 );
+        meshBytes += m.numBones.size() + m.boneIndices.size() * sizeof( u32 ) + m.boneWeights.size() * sizeof( f32 );
 
         vec3 meshAabbMin( FLT_MAX );
         vec3 meshAabbMax( -FLT_MAX );
-        for ( size_t vIdx = 0; vIdx < m.vertices.size(); ++vIdx )
+        for ( const vec3& pos : m.positions )
         {
-            meshAabbMin = Min( meshAabbMin, m.vertices[vIdx].pos );
-            meshAabbMax = Max( meshAabbMax, m.vertices[vIdx].pos );
-            meshBytes += m.vertices[vIdx].numBones * ( sizeof( u32 ) + sizeof( f32 ) );
+            meshAabbMin = Min( meshAabbMin, pos );
+            meshAabbMax = Max( meshAabbMax, pos );
         }
 
         LOG( "%s    AABB: [%f, %f, %f] - [%f %f %f]", tab, meshAabbMin.x, meshAabbMin.y, meshAabbMin.z, meshAabbMax.x, meshAabbMax.y,
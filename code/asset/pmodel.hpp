@@ -13,6 +13,7 @@ enum class PModelVersionNum : u16
     BITANGENT_SIGNS      = 1,
     VERTEX_DATA_TOGETHER = 2,
     MODEL_AABB           = 3,
+    CONTIGUOUS_STREAMS   = 4,
 
     TOTAL,
     CURRENT_VERSION        = TOTAL - 1,
@@ -22,35 +23,49 @@ enum class PModelVersionNum : u16
 #define PMODEL_MAX_UVS_PER_VERT 8u           // AI_MAX_NUMBER_OF_TEXTURECOORDS
 #define PMODEL_MAX_COLORS_PER_VERT 8u        // AI_MAX_NUMBER_OF_COLOR_SETS
 #define PMODEL_MAX_BONE_WEIGHTS_PER_VERT 16u // Assimp's is INT_MAX
+#define PMODEL_STREAM_ALIGNMENT 16u          // alignment of each stream in .pmodelb files, relative to the start of the file
 
 class PModel
 {
 public:
-    struct Vertex
-    {
-        vec3 pos;
-        vec3 normal;
-        vec3 tangent;
-        vec3 bitangent;
-        vec2 uvs[PMODEL_MAX_UVS_PER_VERT];
-        vec4 colors[PMODEL_MAX_COLORS_PER_VERT];
-        f32 boneWeights[PMODEL_MAX_BONE_WEIGHTS_PER_VERT];
-        u32 boneIndices[PMODEL_MAX_BONE_WEIGHTS_PER_VERT];
-        u8 numBones = 0;
-
-        bool AddBone( u32 boneIdx, f32 weight );
-    };
-
+    // Every vertex attribute is its own stream, and only the streams that the mesh actually uses are allocated.
+    // Set the numUVChannels, numColorChannels, hasTangents and hasBoneWeights first, then call Resize( numVertices )
     struct Mesh
     {
         std::string name;
         std::string materialName;
         std::vector<u32> indices;
-        std::vector<Vertex> vertices;
-        u32 numUVChannels;
-        u32 numColorChannels;
-        bool hasTangents;
-        bool hasBoneWeights;
+        std::vector<vec3> positions;
+        std::vector<vec3> normals;
+        std::vector<vec3> tangents;   // empty if !hasTangents
+        std::vector<vec3> bitangents; // empty if !hasTangents
+        std::vector<vec2> uvs;        // numUVChannels per vertex, see UV()
+        std::vector<vec4> colors;     // numColorChannels per vertex, see Color()
+
+        // Empty if !hasBoneWeights. Each vertex has PMODEL_MAX_BONE_WEIGHTS_PER_VERT slots, the first numBones[vIdx] of which are used
+        std::vector<u8> numBones;
+        std::vector<u32> boneIndices;
+        std::vector<f32> boneWeights;
+
+        u32 numUVChannels    = 0;
+        u32 numColorChannels = 0;
+        bool hasTangents     = false;
+        bool hasBoneWeights  = false;
+
+        u32 NumVertices() const { return static_cast<u32>( positions.size() ); }
+        void Resize( u32 numVertices );
+
+        vec2& UV( u32 vIdx, u32 uvSet ) { return uvs[vIdx * numUVChannels + uvSet]; }
+        const vec2& UV( u32 vIdx, u32 uvSet ) const { return uvs[vIdx * numUVChannels + uvSet]; }
+        vec4& Color( u32 vIdx, u32 colorSet ) { return colors[vIdx * numColorChannels + colorSet]; }
+        const vec4& Color( u32 vIdx, u32 colorSet ) const { return colors[vIdx * numColorChannels + colorSet]; }
+        u32* BoneIndices( u32 vIdx ) { return &boneIndices[vIdx * PMODEL_MAX_BONE_WEIGHTS_PER_VERT]; }
+        const u32* BoneIndices( u32 vIdx ) const { return &boneIndices[vIdx * PMODEL_MAX_BONE_WEIGHTS_PER_VERT]; }
+        f32* BoneWeights( u32 vIdx ) { return &boneWeights[vIdx * PMODEL_MAX_BONE_WEIGHTS_PER_VERT]; }
+        const f32* BoneWeights( u32 vIdx ) const { return &boneWeights[vIdx * PMODEL_MAX_BONE_WEIGHTS_PER_VERT]; }
+
+        // Once all of the slots are used, the bone replaces the smallest weight if it's larger. Returns false if any weight was dropped
+        bool AddBone( u32 vIdx, u32 boneIdx, f32 weight );
     };
 
     vec3 aabbMin;
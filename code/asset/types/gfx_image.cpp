@@ -1,8 +1,6 @@
 #include "asset/types/gfx_image.hpp"
 #include "ImageLib/bc_compression.hpp"
 #include "core/image_processing.hpp"
-#include "core/low_discrepancy_sampling.hpp"
-#include "renderer/brdf_functions.hpp"
 #include "shared/assert.hpp"
 #include "shared/logger.hpp"
 #include "shared/math_vec.hpp"
@@ -10,6 +8,7 @@
 #if USING( GPU_DATA )
 #include "renderer/r_globals.hpp"
 #endif // #if USING( GPU_DATA )
+#include <algorithm>
 #include <cstring>
 
 static constexpr CompressionQuality COMPRESSOR_QUALITY = CompressionQuality::MEDIUM;
@@ -102,7 +101,8 @@ static bool Load_Color( GfxImage* gfxImage, const GfxImageCreateInfo* createInfo
     if ( PixelFormatIsCompressed( format ) )
     {
         BCCompressorSettings compressorSettings( compressFormat, COMPRESSOR_QUALITY );
-        img = CompressToBC( img, compressorSettings );
+        compressorSettings.rdoLambda = createInfo->rdoLambda;
+        img                          = CompressToBC( img, compressorSettings );
     }
 
     RawImage2DMipsToGfxImage( *gfxImage, { img }, format );
@@ -156,12 +156,16 @@ static bool Load_AlbedoMetalness( GfxImage* gfxImage, const GfxImageCreateInfo*
             p[3] *= createInfo->compositeScales[1]; // metalnessScale
         } );
 
+    // The alpha channel is metalness, not coverage, so it's just filtered like normal
     MipmapGenerationSettings settings;
+    settings.filter                        = MipFilter::KAISER;
     settings.clampHorizontal               = createInfo->clampHorizontal;
     settings.clampVertical                 = createInfo->clampVertical;
+    settings.srgb                          = true;
     std::vector<RawImage2D> rawMipsFloat32 = RawImage2DFromFloatImages( GenerateMipmaps( composite, settings ) );
 
     BCCompressorSettings compressorSettings( ImageFormat::BC7_UNORM, COMPRESSOR_QUALITY );
+    compressorSettings.rdoLambda           = createInfo->rdoLambda;
     std::vector<RawImage2D> compressedMips = CompressToBC( rawMipsFloat32, compressorSettings );
 
     PixelFormat format = ImageFormatToPixelFormat( compressedMips[0].format, compositeInfo.outputColorSpace == ColorSpace::SRGB );
@@ -241,6 +245,7 @@ static bool Load_NormalRoughness( GfxImage* gfxImage, const GfxImageCreateInfo*
     std::vector<RawImage2D> rawMipsFloat32 = RawImage2DFromFloatImages( f32Mips );
 
     BCCompressorSettings compressorSettings( ImageFormat::BC7_UNORM, COMPRESSOR_QUALITY );
+    compressorSettings.rdoLambda           = createInfo->rdoLambda;
     std::vector<RawImage2D> compressedMips = CompressToBC( rawMipsFloat32, compressorSettings );
 
     PixelFormat format = ImageFormatToPixelFormat( compressedMips[0].format, compositeInfo.outputColorSpace == ColorSpace::SRGB );
@@ -304,79 +309,119 @@ static bool Load_EnvironmentMap( GfxImage* gfxImage, const GfxImageCreateInfo* c
     }
 }
 
+// The transforms below work directly on the channel strided rows. The diagonal flips walk the image in square blocks,
+// so that the mirrored block (which is read down its columns) still fits in the cache
+static constexpr u32 FACE_TRANSFORM_BLOCK_SIZE = 32;
+
+template <u32 NC>
+static void SwapPixels( f32* a, f32* b )
+{
+    for ( u32 c = 0; c < NC; ++c )
+        std::swap( a[c], b[c] );
+}
+
+template <u32 NC>
 static void FlipColumns( FloatImage2D& image )
 {
     for ( u32 row = 0; row < image.height; ++row )
     {
+        f32* rowStart = &image.data[row * image.width * NC];
+        f32* rowEnd   = rowStart + ( image.width - 1 ) * NC;
         for ( u32 col = 0; col < image.width / 2; ++col )
-        {
-            u32 endCol = image.width - col - 1;
-            auto p0    = image.GetFloat4( row, col );
-            auto p1    = image.GetFloat4( row, endCol );
-            image.SetFromFloat4( row, col, p1 );
-            image.SetFromFloat4( row, endCol, p0 );
-        }
+            SwapPixels<NC>( rowStart + col * NC, rowEnd - col * NC );
     }
 }
 
 static void FlipRows( FloatImage2D& image )
 {
+    const u32 rowFloats = image.width * image.numChannels;
     for ( u32 row = 0; row < image.height / 2; ++row )
     {
-        for ( u32 col = 0; col < image.width; ++col )
-        {
-            u32 endRow = image.height - row - 1;
-            auto p0    = image.GetFloat4( row, col );
-            auto p1    = image.GetFloat4( endRow, col );
-            image.SetFromFloat4( row, col, p1 );
-            image.SetFromFloat4( endRow, col, p0 );
-        }
+        f32* top    = &image.data[row * rowFloats];
+        f32* bottom = &image.data[( image.height - row - 1 ) * rowFloats];
+        std::swap_ranges( top, top + rowFloats, bottom );
     }
 }
 
+// Swaps (row, col) with (col, row) for every pixel above the diagonal
+template <u32 NC>
 static void FlipMainDiag( FloatImage2D& image )
 {
     PG_ASSERT( image.width == image.height );
-    for ( u32 row = 0; row < image.height; ++row )
+    const u32 size = image.width;
+    f32* pixels    = image.data.get();
+    for ( u32 blockRow = 0; blockRow < size; blockRow += FACE_TRANSFORM_BLOCK_SIZE )
     {
-        for ( u32 col = row + 1; col < image.width; ++col )
+        const u32 rowEnd = std::min( blockRow + FACE_TRANSFORM_BLOCK_SIZE, size );
+        for ( u32 blockCol = blockRow; blockCol < size; blockCol += FACE_TRANSFORM_BLOCK_SIZE )
         {
-            auto p0 = image.GetFloat4( row, col );
-            auto p1 = image.GetFloat4( col, row );
-            image.SetFromFloat4( row, col, p1 );
-            image.SetFromFloat4( col, row, p0 );
+            const u32 colEnd = std::min( blockCol + FACE_TRANSFORM_BLOCK_SIZE, size );
+            for ( u32 row = blockRow; row < rowEnd; ++row )
+            {
+                for ( u32 col = std::max( blockCol, row + 1 ); col < colEnd; ++col )
+                    SwapPixels<NC>( pixels + ( row * size + col ) * NC, pixels + ( col * size + row ) * NC );
+            }
         }
     }
 }
 
+// Swaps (row, col) with (size - col - 1, size - row - 1) for every pixel above the reverse diagonal
+template <u32 NC>
 static void FlipReverseDiag( FloatImage2D& image )
 {
     PG_ASSERT( image.width == image.height );
-    for ( u32 row = 0; row < image.height; ++row )
+    const u32 size = image.width;
+    f32* pixels    = image.data.get();
+    for ( u32 blockRow = 0; blockRow < size; blockRow += FACE_TRANSFORM_BLOCK_SIZE )
     {
-        for ( u32 col = 0; col < image.height - row - 1; ++col )
+        const u32 rowEnd = std::min( blockRow + FACE_TRANSFORM_BLOCK_SIZE, size );
+        for ( u32 blockCol = 0; blockCol + blockRow < size; blockCol += FACE_TRANSFORM_BLOCK_SIZE )
         {
-            u32 tRow = image.height - col - 1;
-            u32 tCol = image.width - row - 1;
-            auto p0  = image.GetFloat4( row, col );
-            auto p1  = image.GetFloat4( tRow, tCol );
-            image.SetFromFloat4( row, col, p1 );
-            image.SetFromFloat4( tRow, tCol, p0 );
+            const u32 colEnd = std::min( blockCol + FACE_TRANSFORM_BLOCK_SIZE, size );
+            for ( u32 row = blockRow; row < rowEnd; ++row )
+            {
+                for ( u32 col = blockCol; col < colEnd && row + col + 1 < size; ++col )
+                {
+                    f32* p0 = pixels + ( row * size + col ) * NC;
+                    f32* p1 = pixels + ( ( size - col - 1 ) * size + ( size - row - 1 ) ) * NC;
+                    SwapPixels<NC>( p0, p1 );
+                }
+            }
         }
     }
 }
 
+template <u32 NC>
+static void FlipFaceToVk( FloatImage2D& face, i32 faceIdx )
+{
+    switch ( faceIdx )
+    {
+    case FACE_BACK: FlipColumns<NC>( face ); break;
+    case FACE_LEFT: FlipReverseDiag<NC>( face ); break;
+    case FACE_FRONT: FlipRows( face ); break;
+    case FACE_RIGHT: FlipMainDiag<NC>( face ); break;
+    case FACE_TOP: FlipRows( face ); break;
+    case FACE_BOTTOM: FlipColumns<NC>( face ); break;
+    }
+}
+
 static void ConvertPGCubemapToVkCubemap( FloatImageCubemap& cubemap )
 {
     // https://registry.khronos.org/vulkan/specs/1.3/html/chap16.html#_cube_map_face_selection
     // Vulkan cubemap sampling expects left-handed(?) Y-up in when deciding the per-face UVs. Need to
     // rotate/flip the pixels in each face accordingly to account for it
-    FlipColumns( cubemap.faces[0] );
-    FlipReverseDiag( cubemap.faces[1] );
-    FlipRows( cubemap.faces[2] );
-    FlipMainDiag( cubemap.faces[3] );
-    FlipRows( cubemap.faces[4] );
-    FlipColumns( cubemap.faces[5] );
+#pragma omp parallel for
+    for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+    {
+        FloatImage2D& face = cubemap.faces[faceIdx];
+        switch ( cubemap.numChannels )
+        {
+        case 1: FlipFaceToVk<1>( face, faceIdx ); break;
+        case 2: FlipFaceToVk<2>( face, faceIdx ); break;
+        case 3: FlipFaceToVk<3>( face, faceIdx ); break;
+        case 4: FlipFaceToVk<4>( face, faceIdx ); break;
+        }
+    }
 
     // From https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceRange.html
     // the layers of the image view starting at baseArrayLayer correspond to faces in the order +X, -X, +Y, -Y, +Z, -Z
@@ -478,105 +523,47 @@ static bool Load_EnvironmentMapIrradiance( GfxImage* gfxImage, const GfxImageCre
         return false;
     }
 
-    // if the cubemap is a 1x1, it's probably a built-in constant texture, so just do a quick return
-    if ( cubemap.size == 1 )
-    {
-        bool isConstantColor = true;
-        vec4 color           = cubemap.faces[0].GetFloat4( 0 );
-        for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
-        {
-            isConstantColor = isConstantColor && cubemap.faces[faceIdx].GetFloat4( 0 ) == color;
-        }
-
-        if ( isConstantColor )
-        {
-            FloatImageCubemap irradianceMap( 1, cubemap.numChannels );
-            for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
-                irradianceMap.faces[faceIdx].SetFromFloat4( 0, color );
-
-            RawImage2D faces[6];
-            for ( i32 i = 0; i < 6; ++i )
-            {
-                faces[i] = RawImage2DFromFloatImage( irradianceMap.faces[i], ImageFormat::R16_G16_B16_A16_FLOAT );
-            }
-            GfxImageFromCubemap( gfxImage, faces );
-
-            return true;
-        }
-    }
-
-    LOG_WARN( "For the irradianceMap, we are using a low number of samples for now, for faster convert times" );
-    FloatImageCubemap irradianceMap( 32, cubemap.numChannels );
+    // Irradiance is smooth enough that L2 spherical harmonics represent it well (Ramamoorthi and Hanrahan). So just project the
+    // whole cubemap once, instead of integrating a hemisphere per output texel. 'env_map_benchmark --irradiance' compares this
+    // against brute force: ~0.2% average error for a plain sky, but a small, very bright sun rings badly on the side facing away
+    // from it
+    gfxImage->hasIrradianceSH = true;
+    gfxImage->irradianceSH    = ConvolveSH9WithCosineLobe( ProjectCubemapToSH9( cubemap ) );
+    // don't upsample tiny cubemaps, like the built-in 1x1 constant colors
+    FloatImageCubemap irradianceMap( std::min( 32u, cubemap.size ), 3 );
     for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
     {
-#pragma omp parallel for
         for ( i32 dstRow = 0; dstRow < (i32)irradianceMap.size; ++dstRow )
         {
             for ( i32 dstCol = 0; dstCol < (i32)irradianceMap.size; ++dstCol )
             {
-                vec2 faceUV = { ( dstCol + 0.5f ) / irradianceMap.size, ( dstRow + 0.5f ) / irradianceMap.size };
-
-                vec3 normal    = CubemapFaceUVToDirection( faceIdx, faceUV );
-                vec3 tangent   = normal.x < 0.99f ? vec3( 1, 0, 0 ) : vec3( 0, 1, 0 );
-                vec3 bitangent = Normalize( Cross( normal, tangent ) );
-                tangent        = Normalize( Cross( bitangent, normal ) );
-
-                u32 numSamples = 0;
-                vec3 irradiance( 0 );
-
-#if 0
-                for ( i32 skyFaceIdx = 0; skyFaceIdx < 6; ++skyFaceIdx )
-                {
-                    for ( i32 skyRow = 0; skyRow < (i32)cubemap.size; ++skyRow )
-                    {
-                        for ( i32 skyCol = 0; skyCol < (i32)cubemap.size; ++skyCol )
-                        {
-                            vec2 skyFaceUV = { (skyCol + 0.5f) / cubemap.size, (skyRow + 0.5f) / cubemap.size };
-                            vec3 skyDir = CubemapFaceUVToDirection( skyFaceIdx, skyFaceUV );
-                            f32 cosTheta = Dot( normal, skyDir );
-                            if ( cosTheta <= 0.0f )
-                                continue;
-
-                            vec3 radiance = cubemap.Sample( skyDir );
-                            irradiance += radiance * cosTheta;
-                            ++numSamples;
-                        }
-                    }
-                }
-                irradiance *= (PI / numSamples);
-                irradianceMap.faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( irradiance, 0 ) );
-#else
-                constexpr f32 angleDelta = PI / 60.0f;
-                for ( f32 phi = 0; phi < 2 * PI; phi += angleDelta )
-                {
-                    for ( f32 theta = 0; theta < PI / 2; theta += angleDelta )
-                    {
-                        vec3 tangentSpaceDir = { sinf( theta ) * cosf( phi ), sinf( theta ) * sinf( phi ), cosf( theta ) };
-                        vec3 worldSpaceDir   = tangentSpaceDir.x * tangent + tangentSpaceDir.y * bitangent + tangentSpaceDir.z * normal;
-                        vec3 radiance        = cubemap.Sample( worldSpaceDir );
-                        irradiance += radiance * cosf( theta ) * sinf( theta );
-                        ++numSamples;
-                    }
-                }
-
-                irradiance *= ( PI / numSamples );
-                irradianceMap.faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( irradiance, 0 ) );
-#endif
+                vec2 faceUV     = { ( dstCol + 0.5f ) / irradianceMap.size, ( dstRow + 0.5f ) / irradianceMap.size };
+                vec3 irradiance = EvaluateSH9( gfxImage->irradianceSH, CubemapFaceUVToDirection( faceIdx, faceUV ) );
+                irradianceMap.faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( Max( irradiance, vec3( 0 ) ), 0 ) );
             }
         }
     }
 
     ConvertPGCubemapToVkCubemap( irradianceMap );
 
-    RawImage2D faces[6];
-    BCCompressorSettings compressorSettings( ImageFormat::BC6H_U16F, COMPRESSOR_QUALITY );
-    for ( i32 i = 0; i < 6; ++i )
+    // BC6H needs at least one full 4x4 block per face to be worth it
+    if ( irradianceMap.size < 4 )
     {
-        RawImage2D face = RawImage2DFromFloatImage( irradianceMap.faces[i], ImageFormat::R16_G16_B16_FLOAT );
-        faces[i]        = CompressToBC( face, compressorSettings );
+        RawImage2D faces[6];
+        for ( i32 i = 0; i < 6; ++i )
+            faces[i] = RawImage2DFromFloatImage( irradianceMap.faces[i], ImageFormat::R16_G16_B16_A16_FLOAT );
+        GfxImageFromCubemap( gfxImage, faces );
+
+        return true;
     }
 
-    GfxImageFromCubemap( gfxImage, faces );
+    std::vector<RawImage2D> uncompressedFaces( 6 );
+    for ( i32 i = 0; i < 6; ++i )
+        uncompressedFaces[i] = RawImage2DFromFloatImage( irradianceMap.faces[i], ImageFormat::R16_G16_B16_FLOAT );
+
+    BCCompressorSettings compressorSettings( ImageFormat::BC6H_U16F, COMPRESSOR_QUALITY );
+    std::vector<RawImage2D> compressedFaces = CompressToBC( uncompressedFaces, compressorSettings );
+    GfxImageFromCubemap( gfxImage, compressedFaces.data() );
 
     return true;
 }
@@ -618,48 +605,7 @@ static bool Load_EnvironmentMapReflectionProbe( GfxImage* gfxImage, const GfxIma
     constexpr i32 FACE_SIZE  = 64;
     constexpr i32 MIP_LEVELS = 7; // keep in sync with FACE_SIZE
     FloatImageCubemap outputMips[MIP_LEVELS];
-    for ( i32 mipLevel = 0; mipLevel < MIP_LEVELS; ++mipLevel )
-    {
-        const i32 MIP_SIZE      = FACE_SIZE >> mipLevel;
-        outputMips[mipLevel]    = FloatImageCubemap( MIP_SIZE, 3 );
-        f32 perceptualRoughness = mipLevel / static_cast<f32>( MIP_LEVELS - 1 );
-        f32 linearRoughness     = perceptualRoughness * perceptualRoughness;
-        for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
-        {
-#pragma omp parallel for
-            for ( i32 dstRow = 0; dstRow < MIP_SIZE; ++dstRow )
-            {
-                for ( i32 dstCol = 0; dstCol < MIP_SIZE; ++dstCol )
-                {
-                    vec2 faceUV = { ( dstCol + 0.5f ) / MIP_SIZE, ( dstRow + 0.5f ) / MIP_SIZE };
-
-                    vec3 N = CubemapFaceUVToDirection( faceIdx, faceUV );
-                    vec3 R = N;
-                    vec3 V = N;
-
-                    f32 totalWeight = 0;
-                    vec3 prefilteredColor( 0 );
-                    const u32 SAMPLE_COUNT = 1024u;
-                    for ( u32 i = 0u; i < SAMPLE_COUNT; ++i )
-                    {
-                        vec2 Xi = vec2( i / (f32)SAMPLE_COUNT, Hammersley32( i ) );
-                        vec3 H  = ImportanceSampleGGX_D( Xi, N, linearRoughness );
-                        vec3 L  = Normalize( 2.0f * Dot( V, H ) * H - V );
-
-                        f32 NdotL = Max( Dot( N, L ), 0.0f );
-                        if ( NdotL > 0.0f )
-                        {
-                            vec3 radiance = cubemap.Sample( L );
-                            prefilteredColor += radiance * NdotL;
-                            totalWeight += NdotL;
-                        }
-                    }
-                    prefilteredColor = prefilteredColor / totalWeight;
-                    outputMips[mipLevel].faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( prefilteredColor, 0 ) );
-                }
-            }
-        }
-    }
+    PrefilterReflectionProbe( cubemap, outputMips, MIP_LEVELS, FACE_SIZE );
 
     gfxImage->imageType        = ImageType::TYPE_CUBEMAP;
     gfxImage->width            = FACE_SIZE;
@@ -672,18 +618,22 @@ static bool Load_EnvironmentMapReflectionProbe( GfxImage* gfxImage, const GfxIma
     gfxImage->pixels           = static_cast<u8*>( malloc( gfxImage->totalSizeInBytes ) );
     u8* currentFace            = gfxImage->pixels;
 
-    BCCompressorSettings compressorSettings( ImageFormat::BC6H_U16F, COMPRESSOR_QUALITY );
+    // compress every face of every mip at once, they are all tiny
+    std::vector<RawImage2D> uncompressedFaces;
+    uncompressedFaces.reserve( 6 * MIP_LEVELS );
     for ( i32 mipLevel = 0; mipLevel < MIP_LEVELS; ++mipLevel )
     {
         ConvertPGCubemapToVkCubemap( outputMips[mipLevel] );
         for ( i32 i = 0; i < 6; ++i )
-        {
-            RawImage2D face           = RawImage2DFromFloatImage( outputMips[mipLevel].faces[i], ImageFormat::R16_G16_B16_FLOAT );
-            RawImage2D compressedFace = CompressToBC( face, compressorSettings );
+            uncompressedFaces.push_back( RawImage2DFromFloatImage( outputMips[mipLevel].faces[i], ImageFormat::R16_G16_B16_FLOAT ) );
+    }
 
-            memcpy( currentFace, compressedFace.Raw(), compressedFace.TotalBytes() );
-            currentFace += compressedFace.TotalBytes();
-        }
+    BCCompressorSettings compressorSettings( ImageFormat::BC6H_U16F, COMPRESSOR_QUALITY );
+    std::vector<RawImage2D> compressedFaces = CompressToBC( uncompressedFaces, compressorSettings );
+    for ( const RawImage2D& compressedFace : compressedFaces )
+    {
+        memcpy( currentFace, compressedFace.Raw(), compressedFace.TotalBytes() );
+        currentFace += compressedFace.TotalBytes();
     }
 
     return true;
@@ -697,7 +647,8 @@ static bool Load_UI( GfxImage* gfxImage, const GfxImageCreateInfo* createInfo )
         return false;
 
     BCCompressorSettings compressorSettings( ImageFormat::BC7_UNORM, COMPRESSOR_QUALITY );
-    RawImage2D compressed = CompressToBC( img, compressorSettings );
+    compressorSettings.rdoLambda = createInfo->rdoLambda;
+    RawImage2D compressed        = CompressToBC( img, compressorSettings );
 
     PixelFormat format = ImageFormatToPixelFormat( compressed.format, false );
     RawImage2DMipsToGfxImage( *gfxImage, { compressed }, format );
@@ -745,6 +696,9 @@ bool GfxImage::FastfileLoad( Serializer* serializer )
     serializer->Read( clampHorizontal );
     serializer->Read( clampVertical );
     serializer->Read( filterMode );
+    serializer->Read( hasIrradianceSH );
+    if ( hasIrradianceSH )
+        serializer->Read( irradianceSH );
 
 #if USING( GPU_DATA )
     using namespace Gfx;
@@ -793,6 +747,9 @@ bool GfxImage::FastfileSave( Serializer* serializer ) const
     serializer->Write( clampHorizontal );
     serializer->Write( clampVertical );
     serializer->Write( filterMode );
+    serializer->Write( hasIrradianceSH );
+    if ( hasIrradianceSH )
+        serializer->Write( irradianceSH );
     serializer->Write( pixels, totalSizeInBytes );
 
     return true;
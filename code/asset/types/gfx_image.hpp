@@ -47,6 +47,7 @@ struct GfxImageCreateInfo : public BaseAssetCreateInfo
     bool clampHorizontal          = false;
     bool clampVertical            = false;
     GfxImageFilterMode filterMode = GfxImageFilterMode::TRILINEAR;
+    f32 rdoLambda                 = 0.0f; // BC1 and BC7 only. See BCCompressorSettings::rdoLambda, 0 disables it
 
     // for composite maps, like ALBEDO_METALNESS
     f32 compositeScales[4]             = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -74,6 +75,11 @@ struct GfxImage : public BaseAsset
     bool clampVertical;
     GfxImageFilterMode filterMode;
 
+    // Only for ENVIRONMENT_MAP_IRRADIANCE images. Evaluating these gives irradiance / PI, see ConvolveSH9WithCosineLobe.
+    // The pixels are always the cubemap reconstructed from them
+    bool hasIrradianceSH = false;
+    SH9Color irradianceSH;
+
 #if USING( GPU_DATA )
     Gfx::Texture gpuTexture;
 #endif // #if USING( GPU_DATA )
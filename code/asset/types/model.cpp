@@ -11,9 +11,10 @@
 #include <cstring>
 #include <queue>
 
+#include "meshoptimizer/src/meshoptimizer.h"
+
 #if USING( CONVERTER )
 #include "data_structures/queue_static.hpp"
-#include "meshoptimizer/src/meshoptimizer.h"
 #include "shared/oct_encoding.hpp"
 #endif // #if USING( CONVERTER )
 #if USING( GPU_DATA )
@@ -208,19 +209,85 @@ bool CompactMeshletIndices( u32* vertIndices, u32 vertCount, u8* triIndices, u32
     return !anyViolations;
 }
 
+// How scattered a mesh's vertex accesses are, in index order
+struct VertexOrderStats
+{
+    f32 acmr      = 0; // post transform cache misses per triangle, with a 16 entry FIFO cache
+    f32 overfetch = 0; // bytes of positions fetched with 64 byte cache lines / bytes actually used
+};
+
+static VertexOrderStats AnalyzeVertexOrder( const PModel::Mesh& pMesh )
+{
+    VertexOrderStats stats;
+    const size_t numIndices = pMesh.indices.size();
+    stats.acmr      = meshopt_analyzeVertexCache( pMesh.indices.data(), numIndices, pMesh.NumVertices(), 16, 0, 0 ).acmr;
+    stats.overfetch = meshopt_analyzeVertexFetch( pMesh.indices.data(), numIndices, pMesh.NumVertices(), sizeof( vec3 ) ).overfetch;
+
+    return stats;
+}
+
+template <typename T>
+static void RemapVertexStream( std::vector<T>& stream, u32 elementsPerVertex, u32 numVerts, u32 numUsedVerts, const u32* remap )
+{
+    if ( stream.empty() )
+        return;
+
+    meshopt_remapVertexBuffer( stream.data(), stream.data(), numVerts, elementsPerVertex * sizeof( T ), remap );
+    stream.resize( numUsedVerts * elementsPerVertex );
+}
+
+// Reorders the triangles for the vertex cache (and then for overdraw, allowing the cache efficiency to get 5% worse), and then
+// renumbers the vertices in the order the triangles first use them. Any vertices that no triangle uses get dropped.
+// The meshlets already get their own copies of their vertices, so this mostly helps imported meshes that come in a scattered order:
+// meshopt_buildMeshlets seeds from and breaks ties in index order, and every pass after it reads the source vertices per meshlet
+static void OptimizeVertexOrder( PModel::Mesh& pMesh )
+{
+    PGP_ZONE_SCOPEDN( "OptimizeVertexOrder" );
+    u32* indices            = pMesh.indices.data();
+    const size_t numIndices = pMesh.indices.size();
+    const u32 numVerts      = pMesh.NumVertices();
+    meshopt_optimizeVertexCache( indices, indices, numIndices, numVerts );
+    meshopt_optimizeOverdraw( indices, indices, numIndices, &pMesh.positions[0].x, numVerts, sizeof( vec3 ), 1.05f );
+
+    std::vector<u32> remap( numVerts );
+    const u32 numUsedVerts = static_cast<u32>( meshopt_optimizeVertexFetchRemap( remap.data(), indices, numIndices, numVerts ) );
+    meshopt_remapIndexBuffer( indices, indices, numIndices, remap.data() );
+    RemapVertexStream( pMesh.positions, 1, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.normals, 1, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.tangents, 1, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.bitangents, 1, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.uvs, pMesh.numUVChannels, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.colors, pMesh.numColorChannels, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.numBones, 1, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.boneIndices, PMODEL_MAX_BONE_WEIGHTS_PER_VERT, numVerts, numUsedVerts, remap.data() );
+    RemapVertexStream( pMesh.boneWeights, PMODEL_MAX_BONE_WEIGHTS_PER_VERT, numVerts, numUsedVerts, remap.data() );
+}
+
 struct MeshBuildData
 {
     std::vector<meshopt_Meshlet> moMeshlets;
     std::vector<u32> meshletVertices;
     std::vector<u8> meshletTris;
     std::vector<AABB> meshletAABBs;
-    u32 numMeshletVerts        = 0;
-    u32 numMeshletTris         = 0;
-    u32 numMeshlets            = 0;
-    u32 nonCompactibleMeshlets = 0;
+    std::vector<GpuData::MeshletLODCullData> moLODCullDatas; // one per moMeshlet, if generating LODs
+    u32 numMeshletVerts          = 0;
+    u32 numMeshletTris           = 0;
+    u32 numMeshlets              = 0;
+    u32 nonCompactibleMeshlets   = 0;
+    u32 numPreCompactionMeshlets = 0;
+    u32 numZeroNormals           = 0;
+    u32 numZeroTangents          = 0;
+    vec3 largestMeshletExtents   = vec3( 0 );
+    VertexOrderStats vertexOrderBefore; // only filled out if optimizing the vertex order
+    VertexOrderStats vertexOrderAfter;
     bool uvsAreAllUnorm;
+    // Meshes are built in parallel with each other. Only the ones that make up a large part of the model also split their
+    // meshlets across threads, to avoid spinning up a nested thread team for every small mesh
+    bool parallelWithinMesh;
 };
 
+constexpr float MESHLET_CONE_WEIGHT = 0.5f;
+
 static GpuData::Meshlet MoToPGMeshlet( u32 vertCount, u32 triCount, u32& numTotalVerts, u32& numTotalTris )
 {
     GpuData::Meshlet pgMeshlet;
@@ -286,7 +353,7 @@ static void CompactMeshlets( Mesh& m, MeshBuildData& buildData )
     std::vector<u8> subMeshletsPostCompaction( buildData.numMeshlets );
     int numBlocks                  = ROUND_UP_DIV( buildData.numMeshlets, 64 );
     std::atomic<int> extraMeshlets = 0;
-#pragma omp parallel for
+#pragma omp parallel for if ( buildData.parallelWithinMesh )
     for ( int blockIdx = 0; blockIdx < numBlocks; ++blockIdx )
     {
         u32 meshletOffset           = 64 * (u32)blockIdx;
@@ -327,6 +394,8 @@ static void CompactMeshlets( Mesh& m, MeshBuildData& buildData )
         if ( numMeshlets == 1 ) [[likely]]
         {
             m.meshlets.push_back( MoToPGMeshlet( moMeshlet.vertex_count, moMeshlet.triangle_count, numMeshletVerts, numMeshletTris ) );
+            if ( !buildData.moLODCullDatas.empty() )
+                m.meshletLODCullDatas.push_back( buildData.moLODCullDatas[moIdx] );
             auto vertIter = buildData.meshletVertices.begin() + moMeshlet.vertex_offset;
             newMeshletVertices.insert( newMeshletVertices.end(), vertIter, vertIter + moMeshlet.vertex_count );
             auto triIter = buildData.meshletTris.begin() + moMeshlet.triangle_offset;
@@ -347,6 +416,8 @@ static void CompactMeshlets( Mesh& m, MeshBuildData& buildData )
                     newMeshletVertices.end(), submeshlet.vertIndices, submeshlet.vertIndices + submeshlet.vertCount );
                 newMeshletTris.insert( newMeshletTris.end(), submeshlet.triIndices, submeshlet.triIndices + 3 * submeshlet.triCount );
                 m.meshlets.push_back( MoToPGMeshlet( submeshlet.vertCount, submeshlet.triCount, numMeshletVerts, numMeshletTris ) );
+                if ( !buildData.moLODCullDatas.empty() )
+                    m.meshletLODCullDatas.push_back( buildData.moLODCullDatas[moIdx] );
             }
         }
     }
@@ -363,7 +434,7 @@ static void OptimizeMeshletsWithoutCompaction( Mesh& m, MeshBuildData& buildData
 {
     PGP_ZONE_SCOPEDN( "OptimizeMeshletsWithoutCompaction" );
     int numBlocks = ROUND_UP_DIV( buildData.numMeshlets, 64 );
-#pragma omp parallel for
+#pragma omp parallel for if ( buildData.parallelWithinMesh )
     for ( int blockIdx = 0; blockIdx < numBlocks; ++blockIdx )
     {
         u32 meshletOffset = 64 * (u32)blockIdx;
@@ -396,6 +467,521 @@ static void OptimizeMeshletsWithoutCompaction( Mesh& m, MeshBuildData& buildData
     std::swap( buildData.meshletTris, newMeshletTris );
     buildData.numMeshletVerts = numMeshletVerts;
     buildData.numMeshletTris  = numMeshletTris;
+    m.meshletLODCullDatas     = std::move( buildData.moLODCullDatas );
+}
+
+// Meshlets are neighbors if they share any vertex positions. Greedily grows groups of up to MESHLETS_PER_GROUP meshlets,
+// always adding the neighbor that shares the most vertices with the group so far, to keep the group borders short
+static void GroupNeighboringMeshlets( const MeshBuildData& buildData, const std::vector<u32>& positionRemap,
+    const std::vector<u32>& meshletIndices, u32 meshletsPerGroup, std::vector<std::vector<u32>>& groups )
+{
+    const u32 numMeshlets = static_cast<u32>( meshletIndices.size() );
+    std::vector<std::pair<u32, u32>> vertexMeshlets; // ( position, index into meshletIndices )
+    for ( u32 i = 0; i < numMeshlets; ++i )
+    {
+        const meshopt_Meshlet& meshlet = buildData.moMeshlets[meshletIndices[i]];
+        for ( u32 mvIdx = 0; mvIdx < meshlet.vertex_count; ++mvIdx )
+            vertexMeshlets.emplace_back( positionRemap[buildData.meshletVertices[meshlet.vertex_offset + mvIdx]], i );
+    }
+    std::sort( vertexMeshlets.begin(), vertexMeshlets.end() );
+    vertexMeshlets.erase( std::unique( vertexMeshlets.begin(), vertexMeshlets.end() ), vertexMeshlets.end() );
+
+    std::vector<std::vector<u32>> neighbors( numMeshlets ); // one entry per shared vertex
+    for ( size_t rangeStart = 0; rangeStart < vertexMeshlets.size(); )
+    {
+        size_t rangeEnd = rangeStart + 1;
+        while ( rangeEnd < vertexMeshlets.size() && vertexMeshlets[rangeEnd].first == vertexMeshlets[rangeStart].first )
+            ++rangeEnd;
+
+        for ( size_t a = rangeStart; a < rangeEnd; ++a )
+        {
+            for ( size_t b = rangeStart; b < rangeEnd; ++b )
+            {
+                if ( a != b )
+                    neighbors[vertexMeshlets[a].second].push_back( vertexMeshlets[b].second );
+            }
+        }
+        rangeStart = rangeEnd;
+    }
+
+    groups.clear();
+    std::vector<bool> grouped( numMeshlets, false );
+    std::vector<std::pair<u32, u32>> candidates; // ( index into meshletIndices, shared vertices with the group )
+    for ( u32 seed = 0; seed < numMeshlets; ++seed )
+    {
+        if ( grouped[seed] )
+            continue;
+
+        std::vector<u32>& group = groups.emplace_back();
+        group.push_back( seed );
+        grouped[seed] = true;
+        candidates.clear();
+        while ( group.size() < meshletsPerGroup )
+        {
+            for ( u32 n : neighbors[group.back()] )
+            {
+                if ( grouped[n] )
+                    continue;
+                auto it = std::find_if( candidates.begin(), candidates.end(), [n]( const auto& c ) { return c.first == n; } );
+                if ( it == candidates.end() )
+                    candidates.emplace_back( n, 1 );
+                else
+                    ++it->second;
+            }
+
+            u32 best       = UINT32_MAX;
+            u32 bestShared = 0;
+            for ( const auto& [candidate, shared] : candidates )
+            {
+                if ( !grouped[candidate] && shared > bestShared )
+                {
+                    best       = candidate;
+                    bestShared = shared;
+                }
+            }
+            if ( best == UINT32_MAX )
+                break;
+
+            group.push_back( best );
+            grouped[best] = true;
+        }
+
+        for ( u32& idx : group )
+            idx = meshletIndices[idx];
+    }
+}
+
+// Cluster LODs, like Nanite: groups of neighboring meshlets get merged, simplified down to half of their triangles with the group's
+// border locked, and split back up into new meshlets. Since the border is locked, neighboring groups can be drawn at different
+// LODs without any cracks. The new meshlets are grouped and simplified again, until nothing simplifies any further.
+// All of the LOD meshlets are appended after the full detail ones. The error of a group is never less than the errors of the
+// meshlets it was made from, and its sphere encloses theirs, so picking the LOD cut can be done for every meshlet independently
+static void BuildMeshletLODs( const PModel::Mesh& pMesh, MeshBuildData& buildData )
+{
+    PGP_ZONE_SCOPEDN( "BuildMeshletLODs" );
+    constexpr u32 MAX_LOD_LEVELS     = 16;
+    constexpr u32 MESHLETS_PER_GROUP = 4;
+    // groups that can't get rid of at least this many triangles (usually because most of them touch the border) are left as is
+    constexpr f32 MIN_SIMPLIFICATION = 0.15f;
+
+    if ( buildData.numMeshlets == 0 )
+        return;
+
+    // meshopt_buildMeshlets sized everything for the worst case. Trim that off, so that the LOD meshlets can just be appended
+    const meshopt_Meshlet lastMeshlet = buildData.moMeshlets[buildData.numMeshlets - 1];
+    buildData.moMeshlets.resize( buildData.numMeshlets );
+    buildData.meshletVertices.resize( lastMeshlet.vertex_offset + lastMeshlet.vertex_count );
+    buildData.meshletTris.resize( lastMeshlet.triangle_offset + 3 * lastMeshlet.triangle_count );
+
+    const u32 numVerts = static_cast<u32>( pMesh.positions.size() );
+    buildData.moLODCullDatas.resize( buildData.numMeshlets );
+    std::vector<u32> currentLevel( buildData.numMeshlets );
+    for ( u32 meshletIdx = 0; meshletIdx < buildData.numMeshlets; ++meshletIdx )
+    {
+        const meshopt_Meshlet& meshlet = buildData.moMeshlets[meshletIdx];
+
+        meshopt_Bounds bounds = meshopt_computeMeshletBounds( &buildData.meshletVertices[meshlet.vertex_offset],
+            &buildData.meshletTris[meshlet.triangle_offset], meshlet.triangle_count, &pMesh.positions[0].x, numVerts, sizeof( vec3 ) );
+
+        GpuData::MeshletLODCullData& lodData = buildData.moLODCullDatas[meshletIdx];
+        lodData                              = {};
+        lodData.center                       = vec3( bounds.center[0], bounds.center[1], bounds.center[2] );
+        lodData.radius                       = bounds.radius;
+        lodData.error                        = 0;
+        lodData.parentError                  = FLT_MAX;
+        lodData.lodLevel                     = 0;
+        currentLevel[meshletIdx]             = meshletIdx;
+    }
+
+    // Vertices split along uv seams still connect their meshlets
+    std::vector<u32> positionRemap( numVerts );
+    meshopt_generateVertexRemap( positionRemap.data(), nullptr, numVerts, &pMesh.positions[0].x, numVerts, sizeof( vec3 ) );
+
+    // Each group is simplified and re-clustered with just its own vertices, so that the cost doesn't scale with the whole mesh
+    std::vector<u32> globalToLocal( numVerts, UINT32_MAX );
+    std::vector<u32> localToGlobal;
+    std::vector<vec3> localPositions;
+    std::vector<u32> localIndices;
+    std::vector<u32> simplifiedIndices;
+    std::vector<meshopt_Meshlet> newMeshlets;
+    std::vector<u32> newMeshletVertices;
+    std::vector<u8> newMeshletTris;
+    std::vector<std::vector<u32>> groups;
+    std::vector<u32> nextLevel;
+    for ( u32 lodLevel = 1; lodLevel < MAX_LOD_LEVELS && currentLevel.size() > 1; ++lodLevel )
+    {
+        GroupNeighboringMeshlets( buildData, positionRemap, currentLevel, MESHLETS_PER_GROUP, groups );
+        nextLevel.clear();
+        for ( const std::vector<u32>& group : groups )
+        {
+            localToGlobal.clear();
+            localIndices.clear();
+            for ( u32 meshletIdx : group )
+            {
+                const meshopt_Meshlet& meshlet = buildData.moMeshlets[meshletIdx];
+                for ( u32 i = 0; i < 3 * meshlet.triangle_count; ++i )
+                {
+                    u32 globalVIdx = buildData.meshletVertices[meshlet.vertex_offset + buildData.meshletTris[meshlet.triangle_offset + i]];
+                    if ( globalToLocal[globalVIdx] == UINT32_MAX )
+                    {
+                        globalToLocal[globalVIdx] = static_cast<u32>( localToGlobal.size() );
+                        localToGlobal.push_back( globalVIdx );
+                    }
+                    localIndices.push_back( globalToLocal[globalVIdx] );
+                }
+            }
+            localPositions.resize( localToGlobal.size() );
+            for ( size_t localVIdx = 0; localVIdx < localToGlobal.size(); ++localVIdx )
+            {
+                localPositions[localVIdx]               = pMesh.positions[localToGlobal[localVIdx]];
+                globalToLocal[localToGlobal[localVIdx]] = UINT32_MAX;
+            }
+
+            // Only the triangle count limits the simplification. The error it ended up with is what decides when it gets used
+            const size_t numLocalVerts    = localPositions.size();
+            const size_t targetIndexCount = ( localIndices.size() / 6 ) * 3;
+            f32 simplifyError             = 0;
+            simplifiedIndices.resize( localIndices.size() );
+            size_t numSimplifiedIndices = meshopt_simplify( simplifiedIndices.data(), localIndices.data(), localIndices.size(),
+                &localPositions[0].x, numLocalVerts, sizeof( vec3 ), targetIndexCount, FLT_MAX, meshopt_SimplifyLockBorder,
+                &simplifyError );
+            if ( numSimplifiedIndices == 0 || numSimplifiedIndices > ( 1.0f - MIN_SIMPLIFICATION ) * localIndices.size() )
+                continue;
+            simplifyError *= meshopt_simplifyScale( &localPositions[0].x, numLocalVerts, sizeof( vec3 ) );
+
+            AABB childSpheresAABB = {};
+            f32 groupError        = 0;
+            for ( u32 meshletIdx : group )
+            {
+                const GpuData::MeshletLODCullData& child = buildData.moLODCullDatas[meshletIdx];
+                childSpheresAABB.Encompass( child.center - vec3( child.radius ) );
+                childSpheresAABB.Encompass( child.center + vec3( child.radius ) );
+                groupError = Max( groupError, child.error );
+            }
+            groupError += simplifyError;
+            const vec3 groupCenter = childSpheresAABB.Center();
+            f32 groupRadius        = 0;
+            for ( u32 meshletIdx : group )
+            {
+                GpuData::MeshletLODCullData& child = buildData.moLODCullDatas[meshletIdx];
+                groupRadius                        = Max( groupRadius, Length( child.center - groupCenter ) + child.radius );
+            }
+            for ( u32 meshletIdx : group )
+            {
+                GpuData::MeshletLODCullData& child = buildData.moLODCullDatas[meshletIdx];
+                child.parentCenter                 = groupCenter;
+                child.parentRadius                 = groupRadius;
+                child.parentError                  = groupError;
+            }
+
+            size_t maxNewMeshlets = meshopt_buildMeshletsBound( numSimplifiedIndices, MAX_VERTS_PER_MESHLET, MAX_TRIS_PER_MESHLET );
+            newMeshlets.resize( maxNewMeshlets );
+            newMeshletVertices.resize( maxNewMeshlets * MAX_VERTS_PER_MESHLET );
+            newMeshletTris.resize( maxNewMeshlets * MAX_TRIS_PER_MESHLET * 3 );
+            size_t numNewMeshlets = meshopt_buildMeshlets( newMeshlets.data(), newMeshletVertices.data(), newMeshletTris.data(),
+                simplifiedIndices.data(), numSimplifiedIndices, &localPositions[0].x, numLocalVerts, sizeof( vec3 ), MAX_VERTS_PER_MESHLET,
+                MAX_TRIS_PER_MESHLET, MESHLET_CONE_WEIGHT );
+            for ( size_t newIdx = 0; newIdx < numNewMeshlets; ++newIdx )
+            {
+                const meshopt_Meshlet& newMeshlet = newMeshlets[newIdx];
+                meshopt_Meshlet& appended         = buildData.moMeshlets.emplace_back();
+                appended.vertex_offset            = static_cast<u32>( buildData.meshletVertices.size() );
+                appended.triangle_offset          = static_cast<u32>( buildData.meshletTris.size() );
+                appended.vertex_count             = newMeshlet.vertex_count;
+                appended.triangle_count           = newMeshlet.triangle_count;
+                for ( u32 mvIdx = 0; mvIdx < newMeshlet.vertex_count; ++mvIdx )
+                    buildData.meshletVertices.push_back( localToGlobal[newMeshletVertices[newMeshlet.vertex_offset + mvIdx]] );
+                auto triIter = newMeshletTris.begin() + newMeshlet.triangle_offset;
+                buildData.meshletTris.insert( buildData.meshletTris.end(), triIter, triIter + 3 * newMeshlet.triangle_count );
+
+                GpuData::MeshletLODCullData& lodData = buildData.moLODCullDatas.emplace_back();
+                lodData                              = {};
+                lodData.center                       = groupCenter;
+                lodData.radius                       = groupRadius;
+                lodData.error                        = groupError;
+                lodData.parentError                  = FLT_MAX;
+                lodData.lodLevel                     = lodLevel;
+                nextLevel.push_back( static_cast<u32>( buildData.moMeshlets.size() - 1 ) );
+            }
+        }
+
+        if ( nextLevel.empty() )
+            break;
+        std::swap( currentLevel, nextLevel );
+    }
+
+    buildData.numMeshlets = static_cast<u32>( buildData.moMeshlets.size() );
+}
+
+static void CopySubmeshVertex( const PModel::Mesh& src, u32 srcVIdx, PModel::Mesh& dst, u32 dstVIdx )
+{
+    dst.positions[dstVIdx] = src.positions[srcVIdx];
+    dst.normals[dstVIdx]   = src.normals[srcVIdx];
+    if ( src.hasTangents )
+    {
+        dst.tangents[dstVIdx]   = src.tangents[srcVIdx];
+        dst.bitangents[dstVIdx] = src.bitangents[srcVIdx];
+    }
+    for ( u32 uvSet = 0; uvSet < src.numUVChannels; ++uvSet )
+        dst.UV( dstVIdx, uvSet ) = src.UV( srcVIdx, uvSet );
+    for ( u32 colorSet = 0; colorSet < src.numColorChannels; ++colorSet )
+        dst.Color( dstVIdx, colorSet ) = src.Color( srcVIdx, colorSet );
+    if ( src.hasBoneWeights )
+    {
+        dst.numBones[dstVIdx] = src.numBones[srcVIdx];
+        memcpy( dst.BoneIndices( dstVIdx ), src.BoneIndices( srcVIdx ), PMODEL_MAX_BONE_WEIGHTS_PER_VERT * sizeof( u32 ) );
+        memcpy( dst.BoneWeights( dstVIdx ), src.BoneWeights( srcVIdx ), PMODEL_MAX_BONE_WEIGHTS_PER_VERT * sizeof( f32 ) );
+    }
+}
+
+// Copies the given triangles (and only the vertices they use) into their own mesh, keeping their order
+static void ExtractSubmesh( const PModel::Mesh& src, const u32* tris, u32 numTris, std::vector<u32>& vertexRemap, PModel::Mesh& dst )
+{
+    dst.materialName     = src.materialName;
+    dst.numUVChannels    = src.numUVChannels;
+    dst.numColorChannels = src.numColorChannels;
+    dst.hasTangents      = src.hasTangents;
+    dst.hasBoneWeights   = src.hasBoneWeights;
+
+    std::vector<u32> usedVertices;
+    dst.indices.resize( 3 * numTris );
+    for ( u32 i = 0; i < numTris; ++i )
+    {
+        for ( u32 k = 0; k < 3; ++k )
+        {
+            u32 srcVIdx = src.indices[3 * tris[i] + k];
+            if ( vertexRemap[srcVIdx] == UINT32_MAX )
+            {
+                vertexRemap[srcVIdx] = static_cast<u32>( usedVertices.size() );
+                usedVertices.push_back( srcVIdx );
+            }
+            dst.indices[3 * i + k] = vertexRemap[srcVIdx];
+        }
+    }
+
+    dst.Resize( static_cast<u32>( usedVertices.size() ) );
+    for ( u32 dstVIdx = 0; dstVIdx < (u32)usedVertices.size(); ++dstVIdx )
+    {
+        CopySubmeshVertex( src, usedVertices[dstVIdx], dst, dstVIdx );
+        vertexRemap[usedVertices[dstVIdx]] = UINT32_MAX;
+    }
+}
+
+// Only the full detail meshlets go through the culling dispatch, so they're what has to stay under MAX_MESHLETS_PER_MESH.
+// Meshes are split up front assuming this many triangles per meshlet on average. meshopt gets about 85 on a regular grid, but
+// CompactMeshlets breaks up some meshlets, and messier meshes get fewer. Model::Load checks the real count afterwards
+static constexpr u32 ESTIMATED_TRIS_PER_MESHLET = 64;
+
+// Splits pMesh into parts of at most maxTrisPerPart triangles, and appends them to parts. The triangles are split in half at
+// the median centroid along the longest axis until each part is small enough, which keeps the parts spatially compact for
+// culling. The triangles keep their original relative order within each part, since meshopt_buildMeshlets clusters them in
+// index order
+static void SplitMesh( PModel::Mesh& pMesh, u32 maxTrisPerPart, std::vector<PModel::Mesh>& parts )
+{
+    PGP_ZONE_SCOPEDN( "SplitMesh" );
+    const u32 numTris = static_cast<u32>( pMesh.indices.size() / 3 );
+    std::vector<vec3> centroids( numTris );
+    std::vector<u32> triOrder( numTris );
+    for ( u32 triIdx = 0; triIdx < numTris; ++triIdx )
+    {
+        const u32* tri    = &pMesh.indices[3 * triIdx];
+        centroids[triIdx] = ( pMesh.positions[tri[0]] + pMesh.positions[tri[1]] + pMesh.positions[tri[2]] ) / 3.0f;
+        triOrder[triIdx]  = triIdx;
+    }
+
+    std::vector<std::pair<u32, u32>> ranges; // [start, end) ranges of triOrder
+    std::vector<std::pair<u32, u32>> toSplit = { { 0, numTris } };
+    std::vector<u32> median;
+    std::vector<bool> inLowerHalf( numTris, false );
+    while ( !toSplit.empty() )
+    {
+        auto [start, end] = toSplit.back();
+        toSplit.pop_back();
+        if ( end - start <= maxTrisPerPart )
+        {
+            ranges.emplace_back( start, end );
+            continue;
+        }
+
+        AABB centroidAABB = {};
+        for ( u32 i = start; i < end; ++i )
+            centroidAABB.Encompass( centroids[triOrder[i]] );
+        const vec3 extent = centroidAABB.Extent();
+        const u32 axis    = extent.x >= extent.y && extent.x >= extent.z ? 0 : ( extent.y >= extent.z ? 1 : 2 );
+
+        auto CentroidLess = [&]( u32 a, u32 b )
+        { return centroids[a][axis] < centroids[b][axis] || ( centroids[a][axis] == centroids[b][axis] && a < b ); };
+        const u32 mid = start + ( end - start ) / 2;
+        median.assign( triOrder.begin() + start, triOrder.begin() + end );
+        std::nth_element( median.begin(), median.begin() + ( mid - start ), median.end(), CentroidLess );
+        for ( u32 i = 0; i < mid - start; ++i )
+            inLowerHalf[median[i]] = true;
+        std::stable_partition( triOrder.begin() + start, triOrder.begin() + end, [&]( u32 triIdx ) { return inLowerHalf[triIdx]; } );
+        for ( u32 i = 0; i < mid - start; ++i )
+            inLowerHalf[median[i]] = false;
+
+        // upper half first, so that the lower half gets popped next, and the parts come out in order
+        toSplit.emplace_back( mid, end );
+        toSplit.emplace_back( start, mid );
+    }
+
+    LOG( "Splitting mesh '%s' (%u tris) into %zu parts, to stay under %u meshlets per mesh", pMesh.name.c_str(), numTris, ranges.size(),
+        (u32)MAX_MESHLETS_PER_MESH );
+    std::vector<u32> vertexRemap( pMesh.NumVertices(), UINT32_MAX );
+    for ( size_t rangeIdx = 0; rangeIdx < ranges.size(); ++rangeIdx )
+    {
+        PModel::Mesh& part = parts.emplace_back();
+        part.name          = pMesh.name + "_part" + std::to_string( rangeIdx );
+        ExtractSubmesh( pMesh, &triOrder[ranges[rangeIdx].first], ranges[rangeIdx].second - ranges[rangeIdx].first, vertexRemap, part );
+    }
+    pMesh = {};
+}
+
+static void SplitOversizedMeshes( PModel& pmodel )
+{
+    PGP_ZONE_SCOPEDN( "SplitOversizedMeshes" );
+    const u32 maxTrisPerMesh = MAX_MESHLETS_PER_MESH * ESTIMATED_TRIS_PER_MESHLET;
+    bool anyOversized        = false;
+    for ( const PModel::Mesh& pMesh : pmodel.meshes )
+        anyOversized = anyOversized || pMesh.indices.size() / 3 > maxTrisPerMesh;
+    if ( !anyOversized )
+        return;
+
+    std::vector<PModel::Mesh> splitMeshes;
+    for ( PModel::Mesh& pMesh : pmodel.meshes )
+    {
+        if ( pMesh.indices.size() / 3 <= maxTrisPerMesh )
+            splitMeshes.push_back( std::move( pMesh ) );
+        else
+            SplitMesh( pMesh, maxTrisPerMesh, splitMeshes );
+    }
+    pmodel.meshes = std::move( splitMeshes );
+}
+
+// Builds the meshlets of one mesh, along with their cull data and packed triangles. Only writes to m, buildData and meshAABB
+static void BuildMesh( const ModelCreateInfo* createInfo, PModel::Mesh& pMesh, Mesh& m, MeshBuildData& buildData, AABB& meshAABB )
+{
+    if ( createInfo->optimizeVertexOrder )
+    {
+        buildData.vertexOrderBefore = AnalyzeVertexOrder( pMesh );
+        OptimizeVertexOrder( pMesh );
+        buildData.vertexOrderAfter = AnalyzeVertexOrder( pMesh );
+    }
+
+    PGP_MANUAL_ZONEN( __buildMeshlets, "BuildMeshlets" );
+    u64 maxMeshlets = meshopt_buildMeshletsBound( pMesh.indices.size(), MAX_VERTS_PER_MESHLET, MAX_TRIS_PER_MESHLET );
+    buildData.moMeshlets.resize( maxMeshlets );
+    buildData.meshletVertices.resize( maxMeshlets * MAX_VERTS_PER_MESHLET );
+    buildData.meshletTris.resize( maxMeshlets * MAX_TRIS_PER_MESHLET * 3 );
+
+    buildData.numMeshlets = (u32)meshopt_buildMeshlets( buildData.moMeshlets.data(), buildData.meshletVertices.data(),
+        buildData.meshletTris.data(), pMesh.indices.data(), pMesh.indices.size(), &pMesh.positions[0].x, pMesh.positions.size(),
+        sizeof( vec3 ), MAX_VERTS_PER_MESHLET, MAX_TRIS_PER_MESHLET, MESHLET_CONE_WEIGHT );
+    PGP_MANUAL_ZONE_END( __buildMeshlets );
+    if ( createInfo->generateMeshletLODs )
+        BuildMeshletLODs( pMesh, buildData );
+
+#if PACKED_TRIS
+    buildData.numPreCompactionMeshlets = buildData.numMeshlets;
+    CompactMeshlets( m, buildData );
+#else  // #if PACKED_TRIS
+    OptimizeMeshletsWithoutCompaction( m, buildData );
+#endif // #else // #if PACKED_TRIS
+    m.numFullDetailMeshlets = buildData.numMeshlets;
+    if ( !m.meshletLODCullDatas.empty() )
+    {
+        m.numFullDetailMeshlets = 0;
+        while ( m.numFullDetailMeshlets < buildData.numMeshlets && m.meshletLODCullDatas[m.numFullDetailMeshlets].lodLevel == 0 )
+            ++m.numFullDetailMeshlets;
+    }
+
+    PGP_MANUAL_ZONEN( __MeshletBoundsAndTris, "MeshletBoundsAndTris" );
+    m.packedTris.resize( PACKED_TRIS ? buildData.numMeshletTris : ( buildData.numMeshletTris * 3 ) );
+    buildData.meshletAABBs.resize( buildData.numMeshlets );
+    m.meshletCullDatas.resize( buildData.numMeshlets );
+    buildData.uvsAreAllUnorm = true;
+
+    int numBlocks = ROUND_UP_DIV( buildData.numMeshlets, 64 );
+    std::mutex extentsLock;
+#pragma omp parallel for if ( buildData.parallelWithinMesh )
+    for ( int blockIdx = 0; blockIdx < numBlocks; ++blockIdx )
+    {
+        u32 meshletOffset = 64 * (u32)blockIdx;
+        vec3 blockLocalLargestMeshletExtents{ 0 };
+        AABB blockLocalMeshAABB = {};
+        vec2 uvMin( FLT_MAX );
+        vec2 uvMax( -FLT_MAX );
+        for ( u32 localMeshletIdx = 0; localMeshletIdx < 64; ++localMeshletIdx )
+        {
+            u32 meshletIdx = meshletOffset + localMeshletIdx;
+            if ( meshletIdx >= buildData.numMeshlets )
+                break;
+
+            const GpuData::Meshlet& meshlet = m.meshlets[meshletIdx];
+            meshopt_Bounds bounds           = meshopt_computeMeshletBounds( &buildData.meshletVertices[meshlet.vertexOffset],
+                          &buildData.meshletTris[3 * meshlet.triangleOffset], meshlet.triangleCount, &pMesh.positions[0].x,
+                          pMesh.positions.size(), sizeof( vec3 ) );
+
+            AABB& meshletAABB = buildData.meshletAABBs[meshletIdx];
+            meshletAABB       = {};
+            for ( u32 mvIdx = 0; mvIdx < meshlet.vertexCount; ++mvIdx )
+            {
+                u32 globalVIdx = buildData.meshletVertices[meshlet.vertexOffset + mvIdx];
+                meshletAABB.Encompass( pMesh.positions[globalVIdx] );
+
+                if ( pMesh.numUVChannels > 0 )
+                {
+                    uvMin = Min( uvMin, pMesh.UV( globalVIdx, 0 ) );
+                    uvMax = Max( uvMax, pMesh.UV( globalVIdx, 0 ) );
+                }
+            }
+            blockLocalLargestMeshletExtents = Max( blockLocalLargestMeshletExtents, meshletAABB.Extent() );
+            blockLocalMeshAABB.Encompass( meshletAABB );
+
+            GpuData::PackedMeshletCullData& cullData = m.meshletCullDatas[meshletIdx];
+            cullData.position                        = vec3( bounds.center[0], bounds.center[1], bounds.center[2] );
+            cullData.radius                          = bounds.radius;
+            cullData.coneAxis                        = vec3( bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] );
+            cullData.coneCutoff                      = bounds.cone_cutoff;
+            cullData.coneApex                        = vec3( bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2] );
+
+            for ( u32 localTriIdx = 0; localTriIdx < meshlet.triangleCount; ++localTriIdx )
+            {
+                u64 globalMOIdx = 3 * ( meshlet.triangleOffset + localTriIdx );
+                u8vec3 tri      = { buildData.meshletTris[globalMOIdx + 0], buildData.meshletTris[globalMOIdx + 1],
+                         buildData.meshletTris[globalMOIdx + 2] };
+
+#if PACKED_TRIS
+                PG_ASSERT( tri.x < tri.y && tri.x < tri.z );
+
+                u16 packedTri = 0;
+                u8 yDiff      = tri.y - tri.x;
+                u8 zDiff      = tri.z - tri.x;
+                PG_ASSERT( tri.x < 64 && yDiff < 32 && zDiff < 32 );
+                packedTri |= tri.x;
+                packedTri |= yDiff << 6;
+                packedTri |= zDiff << 11;
+                m.packedTris[meshlet.triangleOffset + localTriIdx] = packedTri;
+#else  // #if PACKED_TRIS
+                m.packedTris[globalMOIdx + 0] = tri.x;
+                m.packedTris[globalMOIdx + 1] = tri.y;
+                m.packedTris[globalMOIdx + 2] = tri.z;
+#endif // #else // #if PACKED_TRIS
+            }
+        }
+
+        if ( pMesh.numUVChannels > 0 )
+        {
+            if ( uvMin.x < 0 || uvMin.y < 0.0f || uvMax.x > 1.0f || uvMax.y > 1.0f )
+                buildData.uvsAreAllUnorm = false;
+        }
+
+        extentsLock.lock();
+        buildData.largestMeshletExtents = Max( buildData.largestMeshletExtents, blockLocalLargestMeshletExtents );
+        meshAABB.Encompass( blockLocalMeshAABB );
+        extentsLock.unlock();
+    }
+    PGP_MANUAL_ZONE_END( __MeshletBoundsAndTris );
 }
 
 #endif // #if USING( CONVERTER )
@@ -408,6 +994,7 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
     const ModelCreateInfo* createInfo = (const ModelCreateInfo*)baseInfo;
     SetName( createInfo->name );
     PG_ASSERT( !createInfo->recalculateNormals, "Not implemented with meshlets yet" );
+    encodeStreams = createInfo->encodeStreams;
 
     PModel pmodel;
     if ( !pmodel.Load( GetAbsPath_ModelFilename( createInfo->filename ) ) )
@@ -425,151 +1012,141 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
         vec3 center = modelAABB.Center();
         for ( PModel::Mesh& pMesh : pmodel.meshes )
         {
-            for ( PModel::Vertex& v : pMesh.vertices )
-                v.pos -= center;
+            for ( vec3& pos : pMesh.positions )
+                pos -= center;
         }
         modelAABB.min -= center;
         modelAABB.max -= center;
     }
 
+    SplitOversizedMeshes( pmodel );
+
     u32 numMeshes = static_cast<u32>( pmodel.meshes.size() );
     std::vector<MeshBuildData> meshBuildDatas( numMeshes );
     meshes.resize( numMeshes );
     meshAABBs.resize( numMeshes );
-#if PACKED_VERTS
-    vec3 largestMeshletExtents{ 0 };
-#endif // #if PACKED_VERTS
-#if PACKED_TRIS
-    u32 nonCompactibleMeshlets      = 0;
-    u32 totalMeshletsPreCompaction  = 0;
-    u32 totalMeshletsPostCompaction = 0;
-#endif // #if PACKED_TRIS
+    size_t totalIndices = 0;
     for ( u32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx )
     {
-        Mesh& m                   = meshes[meshIdx];
-        const PModel::Mesh& pMesh = pmodel.meshes[meshIdx];
-        MeshBuildData& buildData  = meshBuildDatas[meshIdx];
-
-        m.name     = pMesh.name;
-        m.material = AssetManager::Get<Material>( pMesh.materialName );
+        // The AssetManager isn't thread safe, so look up the materials before going wide
+        Mesh& m    = meshes[meshIdx];
+        m.name     = pmodel.meshes[meshIdx].name;
+        m.material = AssetManager::Get<Material>( pmodel.meshes[meshIdx].materialName );
         if ( !m.material )
         {
-            LOG_ERR( "No material '%s' found", pMesh.materialName.c_str() );
+            LOG_ERR( "No material '%s' found", pmodel.meshes[meshIdx].materialName.c_str() );
             return false;
         }
+        totalIndices += pmodel.meshes[meshIdx].indices.size();
+    }
 
-        PGP_MANUAL_ZONEN( __buildMeshlets, "BuildMeshlets" );
-        u64 maxMeshlets = meshopt_buildMeshletsBound( pMesh.indices.size(), MAX_VERTS_PER_MESHLET, MAX_TRIS_PER_MESHLET );
-        buildData.moMeshlets.resize( maxMeshlets );
-        buildData.meshletVertices.resize( maxMeshlets * MAX_VERTS_PER_MESHLET );
-        buildData.meshletTris.resize( maxMeshlets * MAX_TRIS_PER_MESHLET * 3 );
-
-        constexpr float CONE_WEIGHT = 0.5f;
-        buildData.numMeshlets       = (u32)meshopt_buildMeshlets( buildData.moMeshlets.data(), buildData.meshletVertices.data(),
-                  buildData.meshletTris.data(), pMesh.indices.data(), pMesh.indices.size(), &pMesh.vertices[0].pos.x, pMesh.vertices.size(),
-                  sizeof( PModel::Vertex ), MAX_VERTS_PER_MESHLET, MAX_TRIS_PER_MESHLET, CONE_WEIGHT );
-        PGP_MANUAL_ZONE_END( __buildMeshlets );
-
-#if PACKED_TRIS
-        totalMeshletsPreCompaction += buildData.numMeshlets;
-        CompactMeshlets( m, buildData );
-        nonCompactibleMeshlets += buildData.nonCompactibleMeshlets;
-        totalMeshletsPostCompaction += buildData.numMeshlets;
-#else  // #if PACKED_TRIS
-        OptimizeMeshletsWithoutCompaction( m, buildData );
-#endif // #else // #if PACKED_TRIS
+    // Start the biggest meshes first, so that one large mesh doesn't end up being the only thing running at the end.
+    // Every mesh only writes to its own Mesh, MeshBuildData and AABB, so the output doesn't depend on the order or thread count
+    std::vector<u32> meshBuildOrder;
+    auto SetBuildOrder = [&]()
+    {
+        numMeshes = static_cast<u32>( pmodel.meshes.size() );
+        meshBuildOrder.resize( numMeshes );
+        for ( u32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx )
+        {
+            meshBuildOrder[meshIdx]                    = meshIdx;
+            meshBuildDatas[meshIdx].parallelWithinMesh = numMeshes == 1 || pmodel.meshes[meshIdx].indices.size() >= totalIndices / 4;
+        }
+        std::stable_sort( meshBuildOrder.begin(), meshBuildOrder.end(),
+            [&]( u32 a, u32 b ) { return pmodel.meshes[a].indices.size() > pmodel.meshes[b].indices.size(); } );
+    };
+    SetBuildOrder();
 
-        PGP_MANUAL_ZONEN( __MeshletBoundsAndTris, "MeshletBoundsAndTris" );
-        m.packedTris.resize( PACKED_TRIS ? buildData.numMeshletTris : ( buildData.numMeshletTris * 3 ) );
-        buildData.meshletAABBs.resize( buildData.numMeshlets );
-        m.meshletCullDatas.resize( buildData.numMeshlets );
-        buildData.uvsAreAllUnorm = true;
+#pragma omp parallel for schedule( dynamic ) if ( numMeshes > 1 )
+    for ( i32 orderIdx = 0; orderIdx < (i32)numMeshes; ++orderIdx )
+    {
+        const u32 meshIdx = meshBuildOrder[orderIdx];
+        BuildMesh( createInfo, pmodel.meshes[meshIdx], meshes[meshIdx], meshBuildDatas[meshIdx], meshAABBs[meshIdx] );
+    }
 
-        int numBlocks = ROUND_UP_DIV( buildData.numMeshlets, 64 );
-        std::mutex extentsLock;
-#pragma omp parallel for
-        for ( int blockIdx = 0; blockIdx < numBlocks; ++blockIdx )
+    // The up front split only estimates the meshlet counts. Any mesh that still went over the limit gets split again, using the
+    // number of triangles per meshlet that it actually got, and only its parts are rebuilt
+    for ( u32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx )
+    {
+        while ( meshes[meshIdx].numFullDetailMeshlets > MAX_MESHLETS_PER_MESH )
         {
-            u32 meshletOffset = 64 * (u32)blockIdx;
-            vec3 blockLocalLargestMeshletExtents{ 0 };
-            AABB blockLocalMeshAABB = {};
-            vec2 uvMin( FLT_MAX );
-            vec2 uvMax( -FLT_MAX );
-            for ( u32 localMeshletIdx = 0; localMeshletIdx < 64; ++localMeshletIdx )
+            // 10% of headroom, since the parts won't all get exactly the same number of triangles per meshlet
+            const u64 numTris                        = pmodel.meshes[meshIdx].indices.size() / 3;
+            const f64 trisPerMeshlet                 = numTris / (f64)meshes[meshIdx].numFullDetailMeshlets;
+            const u32 maxTrisPerPart                 = static_cast<u32>( 0.9 * trisPerMeshlet * MAX_MESHLETS_PER_MESH );
+            Material* material                       = meshes[meshIdx].material;
+            const VertexOrderStats vertexOrderBefore = meshBuildDatas[meshIdx].vertexOrderBefore;
+            std::vector<PModel::Mesh> parts;
+            SplitMesh( pmodel.meshes[meshIdx], maxTrisPerPart, parts );
+            const u32 numParts = static_cast<u32>( parts.size() );
+
+            pmodel.meshes.erase( pmodel.meshes.begin() + meshIdx );
+            pmodel.meshes.insert(
+                pmodel.meshes.begin() + meshIdx, std::make_move_iterator( parts.begin() ), std::make_move_iterator( parts.end() ) );
+            meshes.erase( meshes.begin() + meshIdx );
+            meshes.insert( meshes.begin() + meshIdx, numParts, Mesh() );
+            meshBuildDatas.erase( meshBuildDatas.begin() + meshIdx );
+            meshBuildDatas.insert( meshBuildDatas.begin() + meshIdx, numParts, MeshBuildData() );
+            meshAABBs.erase( meshAABBs.begin() + meshIdx );
+            meshAABBs.insert( meshAABBs.begin() + meshIdx, numParts, AABB() );
+            numMeshes += numParts - 1;
+
+#pragma omp parallel for schedule( dynamic )
+            for ( i32 partIdx = 0; partIdx < (i32)numParts; ++partIdx )
             {
-                u32 meshletIdx = meshletOffset + localMeshletIdx;
-                if ( meshletIdx >= buildData.numMeshlets )
-                    break;
-
-                const GpuData::Meshlet& meshlet = m.meshlets[meshletIdx];
-                meshopt_Bounds bounds           = meshopt_computeMeshletBounds( &buildData.meshletVertices[meshlet.vertexOffset],
-                              &buildData.meshletTris[3 * meshlet.triangleOffset], meshlet.triangleCount, &pMesh.vertices[0].pos.x,
-                              meshlet.vertexCount, sizeof( PModel::Vertex ) );
-
-                AABB& meshletAABB = buildData.meshletAABBs[meshletIdx];
-                meshletAABB       = {};
-                for ( u32 mvIdx = 0; mvIdx < meshlet.vertexCount; ++mvIdx )
-                {
-                    u32 globalVIdx          = buildData.meshletVertices[meshlet.vertexOffset + mvIdx];
-                    const PModel::Vertex& v = pMesh.vertices[globalVIdx];
-                    meshletAABB.Encompass( v.pos );
-
-                    if ( pMesh.numUVChannels > 0 )
-                    {
-                        uvMin = Min( uvMin, v.uvs[0] );
-                        uvMax = Max( uvMax, v.uvs[0] );
-                    }
-                }
-                blockLocalLargestMeshletExtents = Max( blockLocalLargestMeshletExtents, meshletAABB.Extent() );
-                blockLocalMeshAABB.Encompass( meshletAABB );
-
-                GpuData::PackedMeshletCullData& cullData = m.meshletCullDatas[meshletIdx];
-                cullData.position                        = vec3( bounds.center[0], bounds.center[1], bounds.center[2] );
-                cullData.radius                          = bounds.radius;
-                cullData.coneAxis                        = vec3( bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] );
-                cullData.coneCutoff                      = bounds.cone_cutoff;
-                cullData.coneApex                        = vec3( bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2] );
-
-                for ( u32 localTriIdx = 0; localTriIdx < meshlet.triangleCount; ++localTriIdx )
-                {
-                    u64 globalMOIdx = 3 * ( meshlet.triangleOffset + localTriIdx );
-                    u8vec3 tri      = { buildData.meshletTris[globalMOIdx + 0], buildData.meshletTris[globalMOIdx + 1],
-                             buildData.meshletTris[globalMOIdx + 2] };
-
-#if PACKED_TRIS
-                    PG_ASSERT( tri.x < tri.y && tri.x < tri.z );
-
-                    u16 packedTri = 0;
-                    u8 yDiff      = tri.y - tri.x;
-                    u8 zDiff      = tri.z - tri.x;
-                    PG_ASSERT( tri.x < 64 && yDiff < 32 && zDiff < 32 );
-                    packedTri |= tri.x;
-                    packedTri |= yDiff << 6;
-                    packedTri |= zDiff << 11;
-                    m.packedTris[meshlet.triangleOffset + localTriIdx] = packedTri;
-#else  // #if PACKED_TRIS
-                    m.packedTris[globalMOIdx + 0] = tri.x;
-                    m.packedTris[globalMOIdx + 1] = tri.y;
-                    m.packedTris[globalMOIdx + 2] = tri.z;
-#endif // #else // #if PACKED_TRIS
-                }
+                const u32 partMeshIdx        = meshIdx + partIdx;
+                Mesh& m                      = meshes[partMeshIdx];
+                MeshBuildData& buildData     = meshBuildDatas[partMeshIdx];
+                m.name                       = pmodel.meshes[partMeshIdx].name;
+                m.material                   = material;
+                buildData.parallelWithinMesh = pmodel.meshes[partMeshIdx].indices.size() >= totalIndices / 4;
+                BuildMesh( createInfo, pmodel.meshes[partMeshIdx], m, buildData, meshAABBs[partMeshIdx] );
+                // The parts were cut out of a mesh whose vertex order was already optimized
+                buildData.vertexOrderBefore = vertexOrderBefore;
             }
+        }
+    }
+    if ( numMeshes != meshBuildOrder.size() )
+        SetBuildOrder();
 
-            if ( pMesh.numUVChannels > 0 )
-            {
-                if ( uvMin.x < 0 || uvMin.y < 0.0f || uvMax.x > 1.0f || uvMax.y > 1.0f )
-                    buildData.uvsAreAllUnorm = false;
-            }
+    if ( createInfo->optimizeVertexOrder )
+    {
+        // Triangle weighted averages over all of the meshes
+        VertexOrderStats before, after;
+        for ( u32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx )
+        {
+            const f32 weight               = pmodel.meshes[meshIdx].indices.size() / (f32)totalIndices;
+            const MeshBuildData& buildData = meshBuildDatas[meshIdx];
+            before.acmr += weight * buildData.vertexOrderBefore.acmr;
+            before.overfetch += weight * buildData.vertexOrderBefore.overfetch;
+            after.acmr += weight * buildData.vertexOrderAfter.acmr;
+            after.overfetch += weight * buildData.vertexOrderAfter.overfetch;
+        }
+        LOG( "Vertex order optimization for model '%s': ACMR %.3f -> %.3f, position overfetch %.2f -> %.2f", GetName(), before.acmr,
+            after.acmr, before.overfetch, after.overfetch );
+    }
 
-            extentsLock.lock();
 #if PACKED_VERTS
-            largestMeshletExtents = Max( largestMeshletExtents, blockLocalLargestMeshletExtents );
+    vec3 largestMeshletExtents{ 0 };
+#endif // #if PACKED_VERTS
+#if PACKED_TRIS
+    u32 nonCompactibleMeshlets      = 0;
+    u32 totalMeshletsPreCompaction  = 0;
+    u32 totalMeshletsPostCompaction = 0;
+#endif // #if PACKED_TRIS
+#if PACKED_VERTS || PACKED_TRIS
+    for ( const MeshBuildData& buildData : meshBuildDatas )
+    {
+#if PACKED_VERTS
+        largestMeshletExtents = Max( largestMeshletExtents, buildData.largestMeshletExtents );
 #endif // #if PACKED_VERTS
-            meshAABBs[meshIdx].Encompass( blockLocalMeshAABB );
-            extentsLock.unlock();
-        }
-        PGP_MANUAL_ZONE_END( __MeshletBoundsAndTris );
+#if PACKED_TRIS
+        nonCompactibleMeshlets += buildData.nonCompactibleMeshlets;
+        totalMeshletsPreCompaction += buildData.numPreCompactionMeshlets;
+        totalMeshletsPostCompaction += buildData.numMeshlets;
+#endif // #if PACKED_TRIS
     }
+#endif // #if PACKED_VERTS || PACKED_TRIS
 
     PGP_MANUAL_ZONEN( __ExportVerts, "ExportVerts" );
 #if PACKED_VERTS
@@ -587,11 +1164,13 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
     positionDequantizationInfo.globalMin = globalMin;
 #endif // #if PACKED_VERTS
 
-    for ( u32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx )
+#pragma omp parallel for schedule( dynamic ) if ( numMeshes > 1 )
+    for ( i32 orderIdx = 0; orderIdx < (i32)numMeshes; ++orderIdx )
     {
-        Mesh& m                        = meshes[meshIdx];
-        const PModel::Mesh& pMesh      = pmodel.meshes[meshIdx];
-        const MeshBuildData& buildData = meshBuildDatas[meshIdx];
+        const u32 meshIdx         = meshBuildOrder[orderIdx];
+        Mesh& m                   = meshes[meshIdx];
+        const PModel::Mesh& pMesh = pmodel.meshes[meshIdx];
+        MeshBuildData& buildData  = meshBuildDatas[meshIdx];
 
         std::atomic<u32> numZeroNormals  = 0;
         std::atomic<u32> numZeroTangents = 0;
@@ -613,7 +1192,7 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
 #endif // #else // #if PACKED_VERTS
 
         int numBlocks = ROUND_UP_DIV( buildData.numMeshlets, 64 );
-#pragma omp parallel for
+#pragma omp parallel for if ( buildData.parallelWithinMesh )
         for ( int blockIdx = 0; blockIdx < numBlocks; ++blockIdx )
         {
             u32 meshletOffset = 64 * (u32)blockIdx;
@@ -635,27 +1214,29 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
 
                 for ( u32 localVIdx = 0; localVIdx < pgMeshlet.vertexCount; ++localVIdx )
                 {
-                    size_t globalVIdx       = pgMeshlet.vertexOffset + localVIdx;
-                    const PModel::Vertex& v = pMesh.vertices[buildData.meshletVertices[globalVIdx]];
+                    size_t globalVIdx  = pgMeshlet.vertexOffset + localVIdx;
+                    const u32 vIdx     = buildData.meshletVertices[globalVIdx];
+                    const vec3& pos    = pMesh.positions[vIdx];
+                    const vec3& normal = pMesh.normals[vIdx];
 
 #if PACKED_VERTS
-                    uvec3 globalQuantizedValue    = ( v.pos - globalMin ) * quantizationFactor + 0.5f;
+                    uvec3 globalQuantizedValue    = ( pos - globalMin ) * quantizationFactor + 0.5f;
                     uvec3 localQuantizedValue     = globalQuantizedValue - quantizedMeshletOffset;
                     m.packedPositions[globalVIdx] = u16vec3( localQuantizedValue );
 
-                    u32 packedNormal       = OctEncodeSNorm_P( v.normal, BITS_PER_NORMAL / 2 );
+                    u32 packedNormal       = OctEncodeSNorm_P( normal, BITS_PER_NORMAL / 2 );
                     octNormals[globalVIdx] = packedNormal;
 #else  // #if PACKED_VERTS
-                    m.packedPositions[globalVIdx] = v.pos;
-                    m.packedNormals[globalVIdx]   = v.normal;
+                    m.packedPositions[globalVIdx] = pos;
+                    m.packedNormals[globalVIdx]   = normal;
 #endif // #else // #if PACKED_VERTS
 
-                    if ( Length( v.normal ) <= 0.00001f )
+                    if ( Length( normal ) <= 0.00001f )
                         ++numZeroNormals;
 
                     if ( pMesh.numUVChannels > 0 )
                     {
-                        vec2 uv = v.uvs[0];
+                        vec2 uv = pMesh.UV( vIdx, 0 );
                         if ( createInfo->flipTexCoordsVertically )
                             uv.y = 1.0f - uv.y;
 #if PACKED_VERTS
@@ -679,10 +1260,10 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
                     }
                     if ( pMesh.hasTangents )
                     {
-                        vec3 tangent   = v.tangent;
-                        vec3 bitangent = v.bitangent;
+                        vec3 tangent   = pMesh.tangents[vIdx];
+                        vec3 bitangent = pMesh.bitangents[vIdx];
                         vec3 tNormal   = Cross( tangent, bitangent );
-                        bool bSignPos  = Dot( v.normal, tNormal ) > 0.0f;
+                        bool bSignPos  = Dot( normal, tNormal ) > 0.0f;
 #if PACKED_VERTS
                         u32 packedTangent = OctEncodeSNorm_P( tangent, BITS_PER_TANGENT_COMPONENT );
                         packedTangent |= ( bSignPos ? 1u : 0u ) << ( BITS_PER_TANGENT - 1 );
@@ -691,7 +1272,7 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
                         m.packedTangents[globalVIdx] = vec4( tangent, bSignPos ? 1.0f : -1.0f );
 #endif // #else // #if PACKED_VERTS
 
-                        if ( Length( v.tangent ) <= 0.00001f )
+                        if ( Length( tangent ) <= 0.00001f )
                             ++numZeroTangents;
                     }
                 }
@@ -733,15 +1314,22 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
             }
         }
 #endif // #if PACKED_VERTS
-        if ( numZeroNormals.load() )
-            LOG_WARN( "Mesh[%u] '%s' inside of model '%s' has %u normals of length 0", meshIdx, pMesh.name.c_str(),
-                createInfo->name.c_str(), numZeroNormals.load() );
-        if ( numZeroTangents.load() )
-            LOG_WARN( "Mesh[%u] '%s' inside of model '%s' has %u tangents of length 0", meshIdx, pMesh.name.c_str(),
-                createInfo->name.c_str(), numZeroTangents.load() );
+        buildData.numZeroNormals  = numZeroNormals.load();
+        buildData.numZeroTangents = numZeroTangents.load();
     }
     PGP_MANUAL_ZONE_END( __ExportVerts );
 
+    for ( u32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx )
+    {
+        const MeshBuildData& buildData = meshBuildDatas[meshIdx];
+        if ( buildData.numZeroNormals )
+            LOG_WARN( "Mesh[%u] '%s' inside of model '%s' has %u normals of length 0", meshIdx, pmodel.meshes[meshIdx].name.c_str(),
+                createInfo->name.c_str(), buildData.numZeroNormals );
+        if ( buildData.numZeroTangents )
+            LOG_WARN( "Mesh[%u] '%s' inside of model '%s' has %u tangents of length 0", meshIdx, pmodel.meshes[meshIdx].name.c_str(),
+                createInfo->name.c_str(), buildData.numZeroTangents );
+    }
+
 #if PACKED_TRIS
     if ( nonCompactibleMeshlets )
     {
@@ -756,13 +1344,117 @@ bool Model::Load( const BaseAssetCreateInfo* baseInfo )
 #endif // #else // #if USING( CONVERTER )
 }
 
+// meshoptimizer's vertex codec needs the element size to be a multiple of 4 (and at most 256). Streams of 1 or 2 byte elements are
+// encoded as a u32 stream, with the last u32 zero padded, which still keeps each byte column holding the same field. Any other size
+// gets each element zero padded up to a multiple of 4 (6 -> 8) instead, since cutting those into u32s would mix up the fields
+static size_t EncodedElementSize( size_t elementSize ) { return ROUND_UP_TO_MULT( elementSize, 4 ); }
+static bool PadsEachElement( size_t elementSize ) { return elementSize % 4 != 0 && 4 % elementSize != 0; }
+
+static size_t NumEncodedElements( size_t elementSize, u64 numElements )
+{
+    return PadsEachElement( elementSize ) ? numElements : ROUND_UP_DIV( numElements * elementSize, EncodedElementSize( elementSize ) );
+}
+
+// Every stream is its element count, followed by either the raw elements, or the encoded size + encoded bytes.
+// Returns the raw elements, which either point straight into the serializer, or into decodeBuffer if they had to be decoded
+static const void* ReadStream( Serializer* serializer, size_t elementSize, bool encoded, u64& numElements, std::vector<u8>& decodeBuffer )
+{
+    numElements           = serializer->Read<u64>();
+    const size_t numBytes = numElements * elementSize;
+    if ( !encoded )
+    {
+        const void* data = serializer->GetData();
+        serializer->Skip( numBytes );
+        return data;
+    }
+
+    const u64 encodedSize        = serializer->Read<u64>();
+    const u8* encodedData        = serializer->GetData();
+    const size_t encodedElemSize = EncodedElementSize( elementSize );
+    const size_t numEncodedElems = NumEncodedElements( elementSize, numElements );
+    serializer->Skip( encodedSize );
+    decodeBuffer.resize( numEncodedElems * encodedElemSize );
+    if ( meshopt_decodeVertexBuffer( decodeBuffer.data(), numEncodedElems, encodedElemSize, encodedData, encodedSize ) != 0 )
+    {
+        LOG_ERR( "Could not decode a model stream of %llu elements", (unsigned long long)numElements );
+        return nullptr;
+    }
+
+    // Strip the padding in place. Each element only moves towards the front, so it never overwrites one that hasn't moved yet
+    if ( PadsEachElement( elementSize ) )
+    {
+        for ( u64 i = 1; i < numElements; ++i )
+            memmove( &decodeBuffer[i * elementSize], &decodeBuffer[i * encodedElemSize], elementSize );
+    }
+
+    return decodeBuffer.data();
+}
+
+#if !USING( GPU_DATA )
+template <typename T>
+static bool ReadStream( Serializer* serializer, bool encoded, std::vector<T>& stream, std::vector<u8>& decodeBuffer )
+{
+    u64 numElements;
+    const void* data = ReadStream( serializer, sizeof( T ), encoded, numElements, decodeBuffer );
+    if ( !data )
+        return false;
+
+    stream.resize( numElements );
+    memcpy( stream.data(), data, numElements * sizeof( T ) );
+    return true;
+}
+
+template <typename T>
+static void WriteStream( Serializer* serializer, bool encode, const std::vector<T>& stream )
+{
+    serializer->Write( (u64)stream.size() );
+    const size_t numBytes = stream.size() * sizeof( T );
+    if ( !encode )
+    {
+        serializer->Write( stream.data(), numBytes );
+        return;
+    }
+
+    const size_t encodedElemSize = EncodedElementSize( sizeof( T ) );
+    const size_t numEncodedElems = NumEncodedElements( sizeof( T ), stream.size() );
+    const void* elements         = stream.data();
+    std::vector<u8> padded;
+    if ( numEncodedElems * encodedElemSize != numBytes )
+    {
+        padded.resize( numEncodedElems * encodedElemSize, 0 );
+        if ( PadsEachElement( sizeof( T ) ) )
+        {
+            for ( size_t i = 0; i < stream.size(); ++i )
+                memcpy( &padded[i * encodedElemSize], &stream[i], sizeof( T ) );
+        }
+        else
+        {
+            memcpy( padded.data(), stream.data(), numBytes );
+        }
+        elements = padded.data();
+    }
+
+    std::vector<u8> encoded( meshopt_encodeVertexBufferBound( numEncodedElems, encodedElemSize ) );
+    encoded.resize( meshopt_encodeVertexBuffer( encoded.data(), encoded.size(), elements, numEncodedElems, encodedElemSize ) );
+    serializer->Write( (u64)encoded.size() );
+    serializer->Write( encoded.data(), encoded.size() );
+}
+#endif // #if !USING( GPU_DATA )
+
 bool Model::FastfileLoad( Serializer* serializer )
 {
     PGP_ZONE_SCOPED_ASSET( "Model::FastfileLoad" );
     u32 numMeshes = serializer->Read<u32>();
+    serializer->Read( encodeStreams );
     meshAABBs.resize( numMeshes );
     serializer->Read( meshAABBs.data(), numMeshes * sizeof( AABB ) );
     meshes.resize( numMeshes );
+#if USING( GPU_DATA )
+    // The upload requests copy the data right away, so these just get reused for every mesh
+    std::vector<u8> decodedVerts[4], decodedTris, decodedMeshlets, decodedCullDatas;
+#else  // #if USING( GPU_DATA )
+    std::vector<u8> decodeBuffer;
+#endif // #else // #if USING( GPU_DATA )
     for ( Mesh& mesh : meshes )
     {
 #if USING( ASSET_NAMES )
@@ -782,50 +1474,64 @@ bool Model::FastfileLoad( Serializer* serializer )
         }
 
 #if !USING( GPU_DATA )
-        serializer->Read( mesh.packedPositions );
-        serializer->Read( mesh.packedNormals );
-        serializer->Read( mesh.packedTexCoords );
-        serializer->Read( mesh.packedTangents );
-        serializer->Read( mesh.packedTris );
-        serializer->Read( mesh.meshlets );
-        serializer->Read( mesh.meshletCullDatas );
+        bool success = ReadStream( serializer, encodeStreams, mesh.packedPositions, decodeBuffer );
+        success      = success && ReadStream( serializer, encodeStreams, mesh.packedNormals, decodeBuffer );
+        success      = success && ReadStream( serializer, encodeStreams, mesh.packedTexCoords, decodeBuffer );
+        success      = success && ReadStream( serializer, encodeStreams, mesh.packedTangents, decodeBuffer );
+        success      = success && ReadStream( serializer, encodeStreams, mesh.packedTris, decodeBuffer );
+        success      = success && ReadStream( serializer, encodeStreams, mesh.meshlets, decodeBuffer );
+        success      = success && ReadStream( serializer, encodeStreams, mesh.meshletCullDatas, decodeBuffer );
+        serializer->Read( mesh.numFullDetailMeshlets );
+        success = success && ReadStream( serializer, encodeStreams, mesh.meshletLODCullDatas, decodeBuffer );
+        if ( !success )
+            return false;
 #else // #if !USING( GPU_DATA )
-        u64 numVerts        = serializer->Read<u64>();
-        const void* posData = serializer->GetData();
-        u64 posDataSize     = numVerts * ( PACKED_VERTS ? sizeof( u16vec3 ) : sizeof( vec3 ) );
-        serializer->Skip( posDataSize );
-
-        u64 numNormalChunks    = serializer->Read<u64>();
-        const void* normalData = serializer->GetData();
-        u64 normalDataSize     = PACKED_VERTS ? ( numNormalChunks * sizeof( u32 ) ) : ( numVerts * sizeof( vec3 ) );
-        serializer->Skip( normalDataSize );
-
-        u64 numTexCoordChunks = serializer->Read<u64>();
-        const void* uvData    = serializer->GetData();
-        u64 uvDataSize        = numTexCoordChunks * ( PACKED_VERTS ? 1 : sizeof( vec2 ) );
-        serializer->Skip( uvDataSize );
-
-        u64 numTanChunks     = serializer->Read<u64>();
-        const void* tanData  = serializer->GetData();
-        u64 tangentsDataSize = numTanChunks * ( PACKED_VERTS ? sizeof( u32 ) : sizeof( vec4 ) );
-        serializer->Skip( tangentsDataSize );
-
-        u64 numTrisOrIndices = serializer->Read<u64>();
-        const void* triData  = serializer->GetData();
-        u64 triDataSize      = numTrisOrIndices * ( PACKED_TRIS ? sizeof( u16 ) : sizeof( u8 ) );
-        serializer->Skip( triDataSize );
-
-        u64 numMeshlets         = serializer->Read<u64>();
-        const void* meshletData = serializer->GetData();
-        serializer->Skip( numMeshlets * sizeof( GpuData::Meshlet ) );
-        PG_ASSERT( numMeshlets <= 65535,
-            "Compute culling shader assumes maxComputeWorkGroupCount[0] is 65535. Can change shader to support more, or split mesh" );
-
-        const void* meshletCullData = serializer->GetData();
-        serializer->Skip( numMeshlets * sizeof( GpuData::PackedMeshletCullData ) );
+        u64 numVerts;
+        const size_t posSize = PACKED_VERTS ? sizeof( u16vec3 ) : sizeof( vec3 );
+        const void* posData  = ReadStream( serializer, posSize, encodeStreams, numVerts, decodedVerts[0] );
+        u64 posDataSize      = numVerts * posSize;
+
+        u64 numNormalChunks;
+        const size_t normalSize = PACKED_VERTS ? sizeof( u32 ) : sizeof( vec3 );
+        const void* normalData  = ReadStream( serializer, normalSize, encodeStreams, numNormalChunks, decodedVerts[1] );
+        u64 normalDataSize      = PACKED_VERTS ? ( numNormalChunks * sizeof( u32 ) ) : ( numVerts * sizeof( vec3 ) );
+
+        u64 numTexCoordChunks;
+        const void* uvData = ReadStream( serializer, PACKED_VERTS ? 1 : sizeof( vec2 ), encodeStreams, numTexCoordChunks, decodedVerts[2] );
+        u64 uvDataSize     = numTexCoordChunks * ( PACKED_VERTS ? 1 : sizeof( vec2 ) );
+
+        u64 numTanChunks;
+        const size_t tanSize = PACKED_VERTS ? sizeof( u32 ) : sizeof( vec4 );
+        const void* tanData  = ReadStream( serializer, tanSize, encodeStreams, numTanChunks, decodedVerts[3] );
+        u64 tangentsDataSize = numTanChunks * tanSize;
+
+        u64 numTrisOrIndices;
+        const size_t triSize = PACKED_TRIS ? sizeof( u16 ) : sizeof( u8 );
+        const void* triData  = ReadStream( serializer, triSize, encodeStreams, numTrisOrIndices, decodedTris );
+        u64 triDataSize      = numTrisOrIndices * triSize;
+
+        u64 numMeshlets;
+        const void* meshletData = ReadStream( serializer, sizeof( GpuData::Meshlet ), encodeStreams, numMeshlets, decodedMeshlets );
+
+        u64 numCullDatas;
+        const void* meshletCullData =
+            ReadStream( serializer, sizeof( GpuData::PackedMeshletCullData ), encodeStreams, numCullDatas, decodedCullDatas );
+
+        // The LOD meshlets are uploaded with the rest, but until the LOD cut is picked on the GPU only the full detail ones get drawn
+        u32 numFullDetailMeshlets = serializer->Read<u32>();
+        u64 numLODCullDatas       = serializer->Read<u64>();
+        if ( encodeStreams )
+            serializer->Skip( serializer->Read<u64>() );
+        else
+            serializer->Skip( numLODCullDatas * sizeof( GpuData::MeshletLODCullData ) );
+        PG_ASSERT( numFullDetailMeshlets <= MAX_MESHLETS_PER_MESH, "Model::Load should have split this mesh" );
+        PG_ASSERT( numCullDatas == numMeshlets );
+        PG_UNUSED( numCullDatas );
+        if ( !posData || !normalData || !uvData || !tanData || !triData || !meshletData || !meshletCullData )
+            return false;
 
         mesh.numVertices    = static_cast<u32>( numVerts );
-        mesh.numMeshlets    = static_cast<u32>( numMeshlets );
+        mesh.numMeshlets    = numFullDetailMeshlets;
         mesh.hasTexCoords   = numTexCoordChunks != 0;
         mesh.unormTexCoords = numTexCoordChunks == ROUND_UP_TO_MULT( 3 * numVerts, 4 );
         mesh.hasTangents    = numTanChunks != 0;
@@ -889,18 +1595,21 @@ bool Model::FastfileSave( Serializer* serializer ) const
 {
 #if !USING( GPU_DATA )
     serializer->Write( (u32)meshes.size() );
+    serializer->Write( encodeStreams );
     serializer->Write( meshAABBs.data(), meshAABBs.size() * sizeof( AABB ) );
     for ( const Mesh& mesh : meshes )
     {
         serializer->Write<u16>( mesh.name );
         serializer->Write<u16>( mesh.material->GetName() );
-        serializer->Write( mesh.packedPositions );
-        serializer->Write( mesh.packedNormals );
-        serializer->Write( mesh.packedTexCoords );
-        serializer->Write( mesh.packedTangents );
-        serializer->Write( mesh.packedTris );
-        serializer->Write( mesh.meshlets );
-        serializer->Write( mesh.meshletCullDatas.data(), mesh.meshletCullDatas.size() * sizeof( GpuData::PackedMeshletCullData ) );
+        WriteStream( serializer, encodeStreams, mesh.packedPositions );
+        WriteStream( serializer, encodeStreams, mesh.packedNormals );
+        WriteStream( serializer, encodeStreams, mesh.packedTexCoords );
+        WriteStream( serializer, encodeStreams, mesh.packedTangents );
+        WriteStream( serializer, encodeStreams, mesh.packedTris );
+        WriteStream( serializer, encodeStreams, mesh.meshlets );
+        WriteStream( serializer, encodeStreams, mesh.meshletCullDatas );
+        serializer->Write( mesh.numFullDetailMeshlets );
+        WriteStream( serializer, encodeStreams, mesh.meshletLODCullDatas );
     }
     serializer->Write( positionDequantizationInfo );
 #endif // #if !USING( GPU_DATA )
@@ -919,13 +1628,14 @@ void Model::FreeCPU()
 #if !USING( GPU_DATA )
     for ( Mesh& mesh : meshes )
     {
-        mesh.meshletCullDatas = {};
-        mesh.meshlets         = {};
-        mesh.packedPositions  = {};
-        mesh.packedNormals    = {};
-        mesh.packedTexCoords  = {};
-        mesh.packedTangents   = {};
-        mesh.packedTris       = {};
+        mesh.meshletCullDatas    = {};
+        mesh.meshletLODCullDatas = {};
+        mesh.meshlets            = {};
+        mesh.packedPositions     = {};
+        mesh.packedNormals       = {};
+        mesh.packedTexCoords     = {};
+        mesh.packedTangents      = {};
+        mesh.packedTris          = {};
     }
 #endif // #if !USING( GPU_DATA )
 }
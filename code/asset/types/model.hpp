@@ -44,6 +44,9 @@ struct Mesh
 #else
     std::vector<GpuData::Meshlet> meshlets;
     std::vector<GpuData::PackedMeshletCullData> meshletCullDatas;
+    std::vector<GpuData::MeshletLODCullData> meshletLODCullDatas; // empty unless the LODs were generated
+    // The full detail meshlets come first, followed by each simplified LOD level. Only the full detail ones get drawn for now
+    u32 numFullDetailMeshlets;
 #if PACKED_VERTS
     std::vector<u16vec3> packedPositions;
     std::vector<u32> packedNormals;
@@ -70,6 +73,9 @@ struct ModelCreateInfo : public BaseAssetCreateInfo
     bool flipTexCoordsVertically = false;
     bool recalculateNormals      = false;
     bool centerModel             = false;
+    bool generateMeshletLODs     = false;
+    bool encodeStreams           = false;
+    bool optimizeVertexOrder     = false;
 };
 
 std::string GetAbsPath_ModelFilename( const std::string& filename );
@@ -92,6 +98,8 @@ struct Model : public BaseAsset
     std::vector<Mesh> meshes;
     std::vector<AABB> meshAABBs;
     DequantizationInfo positionDequantizationInfo;
+    // If set, FastfileSave compresses every mesh stream with meshoptimizer's vertex codec, and FastfileLoad decodes them
+    bool encodeStreams = false;
 };
 
 } // namespace PG
@@ -10,9 +10,11 @@
 #include "spirv-tools/optimizer.hpp"
 #include "spirv_cross/spirv_cross.hpp"
 #include <fstream>
+#include <unordered_map>
 
 #if USING( CONVERTER )
 #include "converters/shader_converter.hpp"
+#include "xxHash/xxhash.h"
 #endif // #if USING( CONVERTER )
 #if USING( GPU_DATA )
 #include "renderer/debug_marker.hpp"
@@ -41,6 +43,41 @@ std::string GetAbsPath_ShaderFilename( const std::string& filename ) { return PG
 
 #if USING( GPU_STRUCTS )
 
+#if USING( GPU_DATA )
+struct FastfileSpirvBlob
+{
+    const u8* data;
+    u64 sizeInBytes;
+};
+
+// Any shader whose spirv is identical to one earlier in the fastfile gets saved with a spirv size of 0, and looks up the
+// blob by its hash here instead. These just point into the fastfile being loaded (fastfiles are always loaded by a
+// single thread), and get cleared once it's done, so no blobs are kept around after loading
+static thread_local std::unordered_map<u64, FastfileSpirvBlob> s_fastfileSpirvBlobs;
+
+void AddSkippedShaderSpirvBlob( const u8* shaderData, size_t shaderDataSize )
+{
+    // see Shader::FastfileSave for the layout
+    if ( shaderDataSize < 2 * sizeof( u64 ) )
+        return;
+    u64 spirvHash, spirvSizeInBytes;
+    memcpy( &spirvHash, shaderData, sizeof( u64 ) );
+    memcpy( &spirvSizeInBytes, shaderData + sizeof( u64 ), sizeof( u64 ) );
+    if ( spirvSizeInBytes && spirvSizeInBytes <= shaderDataSize - 2 * sizeof( u64 ) )
+        s_fastfileSpirvBlobs.try_emplace( spirvHash, shaderData + shaderDataSize - spirvSizeInBytes, spirvSizeInBytes );
+}
+
+void ClearFastfileSpirvBlobs() { s_fastfileSpirvBlobs.clear(); }
+#else  // #if USING( GPU_DATA )
+void AddSkippedShaderSpirvBlob( const u8* shaderData, size_t shaderDataSize )
+{
+    PG_UNUSED( shaderData );
+    PG_UNUSED( shaderDataSize );
+}
+
+void ClearFastfileSpirvBlobs() {}
+#endif // #else // #if USING( GPU_DATA )
+
 static ShaderStage SpirvCrossShaderStageToPG( spv::ExecutionModel stage )
 {
     switch ( stage )
@@ -110,7 +147,12 @@ static bool CompilePreprocessedShaderToSPIRV(
     // Only seems to crash when using the binaries that come with Vulkan while also linking + using the spirv-cross lib.
     // Maybe spirv-cross and shaderc both link spirv-tools, that might be built differently? Some posts online say it doesnt do much either
     options.SetOptimizationLevel( shaderc_optimization_level_zero ); // shaderc_optimization_level_performance );
+#if USING( CONVERTER )
+    if ( !g_converterConfigOptions.stripShaderDebugInfo )
+        options.SetGenerateDebugInfo();
+#else  // #if USING( CONVERTER )
     options.SetGenerateDebugInfo();
+#endif // #else // #if USING( CONVERTER )
 
     // No entry poi32 info needed, because GLSL mandates that the entry poi32 is always void main()
     shaderc_shader_kind kind             = static_cast<shaderc_shader_kind>( PGShaderStageToShaderc( createInfo.shaderStage ) );
@@ -130,6 +172,108 @@ static bool CompilePreprocessedShaderToSPIRV(
     return true;
 }
 
+#if USING( CONVERTER )
+// Runs spirv-opt's performance or size recipe and/or strips the debug info, as a separate pass after shaderc. See the note
+// in CompilePreprocessedShaderToSPIRV about shaderc's own optimization level. If the optimized spirv doesn't pass
+// validation, the unoptimized spirv is kept instead
+static void OptimizeSpirv( const ShaderCreateInfo& createInfo, std::vector<u32>& spirv )
+{
+    const ConverterConfigOptions& config = g_converterConfigOptions;
+    if ( config.shaderOptimization == ShaderOptimization::NONE && !config.stripShaderDebugInfo )
+        return;
+
+    std::string messages;
+    auto messageConsumer = [&messages]( spv_message_level_t level, const char*, const spv_position_t& position, const char* message )
+    {
+        if ( level <= SPV_MSG_ERROR )
+            messages += "\n  " + std::to_string( position.index ) + ": " + message;
+    };
+
+    spvtools::Optimizer optimizer( SPV_ENV_VULKAN_1_3 );
+    optimizer.SetMessageConsumer( messageConsumer );
+    if ( config.shaderOptimization == ShaderOptimization::PERFORMANCE )
+        optimizer.RegisterPerformancePasses();
+    else if ( config.shaderOptimization == ShaderOptimization::SIZE )
+        optimizer.RegisterSizePasses();
+    if ( config.stripShaderDebugInfo )
+        optimizer.RegisterPass( spvtools::CreateStripDebugInfoPass() );
+
+    std::vector<u32> optimizedSpirv;
+    if ( !optimizer.Run( spirv.data(), spirv.size(), &optimizedSpirv ) )
+    {
+        LOG_WARN( "spirv-opt failed for shader '%s', using the unoptimized spirv instead:%s", createInfo.name.c_str(), messages.c_str() );
+        return;
+    }
+
+    spvtools::ValidatorOptions validatorOptions;
+    validatorOptions.SetScalarBlockLayout( true );
+    spvtools::SpirvTools validator( SPV_ENV_VULKAN_1_3 );
+    validator.SetMessageConsumer( messageConsumer );
+    if ( !validator.Validate( optimizedSpirv.data(), optimizedSpirv.size(), validatorOptions ) )
+    {
+        LOG_WARN( "Optimized spirv for shader '%s' failed validation, using the unoptimized spirv instead:%s", createInfo.name.c_str(),
+            messages.c_str() );
+        return;
+    }
+
+    LOG( "Optimized spirv for shader '%s': %.1f KB -> %.1f KB (%.1f%% smaller)", createInfo.name.c_str(), 4 * spirv.size() / 1024.0f,
+        4 * optimizedSpirv.size() / 1024.0f, 100.0f * ( 1.0f - optimizedSpirv.size() / (float)spirv.size() ) );
+    spirv = std::move( optimizedSpirv );
+}
+#endif // #if USING( CONVERTER )
+
+static bool CompileAndReflectShader(
+    const ShaderCreateInfo& createInfo, const std::string& shaderSource, std::vector<u32>& spirv, ShaderReflectData& reflectData )
+{
+    if ( !CompilePreprocessedShaderToSPIRV( createInfo, shaderSource, spirv ) )
+    {
+        return false;
+    }
+#if USING( CONVERTER )
+    OptimizeSpirv( createInfo, spirv );
+#endif // #if USING( CONVERTER )
+
+    size_t spirvSizeInBytes = 4 * spirv.size();
+    if ( !ReflectShader_ReflectSpirv( createInfo.name, spirv.data(), spirvSizeInBytes, reflectData ) )
+    {
+        LOG_ERR( "Spirv reflection for shader: name '%s', filename '%s' failed", createInfo.name.c_str(), createInfo.filename.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+#if USING( CONVERTER )
+// Identifies everything besides the shader source that affects the compiled spirv. Keep in sync with the options in
+// CompilePreprocessedShaderToSPIRV and OptimizeSpirv, so that the converter's spirv cache gets invalidated when they change
+static std::string GetSpirvCompileOptions()
+{
+    std::string options = "vulkan1.3 glsl O0";
+    options += " spirv-opt" + std::to_string( Underlying( g_converterConfigOptions.shaderOptimization ) );
+    options += g_converterConfigOptions.stripShaderDebugInfo ? " stripped" : " debuginfo";
+
+    return options;
+}
+
+// The debug info embeds the filename, so identical source from two different files can still produce different spirv
+static u64 GetSpirvCacheKey( const ShaderCreateInfo& createInfo, const std::string& shaderSource )
+{
+    const std::string compileOptions = GetSpirvCompileOptions();
+
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset( state, 0 );
+    XXH64_update( state, shaderSource.data(), shaderSource.length() );
+    XXH64_update( state, createInfo.filename.data(), createInfo.filename.length() + 1 );
+    XXH64_update( state, &createInfo.shaderStage, sizeof( createInfo.shaderStage ) );
+    XXH64_update( state, compileOptions.data(), compileOptions.length() );
+    XXH64_update( state, &g_assetVersions[ASSET_TYPE_SHADER], sizeof( g_assetVersions[ASSET_TYPE_SHADER] ) );
+    u64 key = XXH64_digest( state );
+    XXH64_freeState( state );
+
+    return key;
+}
+#endif // #if USING( CONVERTER )
+
 #if USING( GPU_DATA )
 void Shader::CreateShaderModule( const u32* spirv, size_t sizeInBytes )
 {
@@ -189,20 +333,27 @@ bool Shader::Load( const BaseAssetCreateInfo* baseInfo )
     }
 
     std::vector<u32> spirv;
-    if ( !CompilePreprocessedShaderToSPIRV( *createInfo, preproc.outputShader, spirv ) )
+#if USING( CONVERTER )
+    // Lots of permutations have defines that don't change the preprocessed source, so only compile those once
+    const u64 spirvCacheKey = GetSpirvCacheKey( *createInfo, preproc.outputShader );
+    if ( !GetCachedSpirv( spirvCacheKey, spirv, m_reflectionData ) )
     {
-        return false;
+        if ( !CompileAndReflectShader( *createInfo, preproc.outputShader, spirv, m_reflectionData ) )
+        {
+            return false;
+        }
+        AddCachedSpirv( spirvCacheKey, spirv, m_reflectionData );
     }
-
-    size_t spirvSizeInBytes = 4 * spirv.size();
-    if ( !ReflectShader_ReflectSpirv( createInfo->name, spirv.data(), spirvSizeInBytes, m_reflectionData ) )
+#else  // #if USING( CONVERTER )
+    if ( !CompileAndReflectShader( *createInfo, preproc.outputShader, spirv, m_reflectionData ) )
     {
-        LOG_ERR( "Spirv reflection for shader: name '%s', filename '%s' failed", createInfo->name.c_str(), createInfo->filename.c_str() );
         return false;
     }
+#endif // #else // #if USING( CONVERTER )
 
 #if USING( CONVERTER )
-    savedSpirv = std::move( spirv );
+    savedSpirvHash = XXH64( spirv.data(), 4 * spirv.size(), 0 );
+    savedSpirv     = std::move( spirv );
     AddIncludeCacheEntry( createInfo, preproc );
 #endif // #if USING( CONVERTER )
 #if USING( GPU_DATA )
@@ -218,22 +369,48 @@ bool Shader::Load( const BaseAssetCreateInfo* baseInfo )
 
 bool Shader::FastfileLoad( Serializer* serializer )
 {
+    u64 spirvHash;
+    u64 spirvSizeInBytes;
+    serializer->Read( spirvHash );
+    serializer->Read( spirvSizeInBytes );
     serializer->Read( m_reflectionData.workgroupSize );
     serializer->Read( m_reflectionData.pushConstantSize );
     serializer->Read( m_reflectionData.pushConstantOffset );
     serializer->Read( m_reflectionData.extensions );
     serializer->Read( m_reflectionData.capabilities );
     serializer->Read( m_shaderStage );
-    std::vector<u32> spirv;
-    serializer->Read( spirv );
 
 #if USING( GPU_DATA )
+    const u8* spirvData = serializer->GetData();
+    if ( spirvSizeInBytes )
+    {
+        s_fastfileSpirvBlobs.try_emplace( spirvHash, spirvData, spirvSizeInBytes );
+        serializer->Skip( spirvSizeInBytes );
+    }
+    else
+    {
+        auto it = s_fastfileSpirvBlobs.find( spirvHash );
+        if ( it == s_fastfileSpirvBlobs.end() )
+        {
+            LOG_ERR( "Shader '%s' uses spirv blob %016llx, but no earlier shader in the fastfile has it", GetName(),
+                (unsigned long long)spirvHash );
+            return false;
+        }
+        spirvData        = it->second.data;
+        spirvSizeInBytes = it->second.sizeInBytes;
+    }
+
+    // copy it out of the fastfile, since the blob isn't necessarily 4 byte aligned there
+    std::vector<u32> spirv( spirvSizeInBytes / 4 );
+    memcpy( spirv.data(), spirvData, spirvSizeInBytes );
     CreateShaderModule( spirv.data(), 4 * spirv.size() );
     if ( ExtensionsAndFeaturesSupported() && m_handle == VK_NULL_HANDLE )
     {
         return false;
     }
-#endif // #if USING( GPU_DATA )
+#else  // #if USING( GPU_DATA )
+    serializer->Skip( spirvSizeInBytes );
+#endif // #else // #if USING( GPU_DATA )
 
     return true;
 }
@@ -244,13 +421,17 @@ bool Shader::FastfileSave( Serializer* serializer ) const
 #if !USING( CONVERTER )
     PG_ASSERT( false, "Spirv code is only kept around in Converter builds for saving" );
 #else  // #if !USING( CONVERTER )
+    // The FastfileWriter relies on the spirv hash + size being first, and the spirv itself being last, so that it can
+    // drop the spirv from any shaders that share a blob with an earlier shader in the same fastfile
+    serializer->Write( savedSpirvHash );
+    serializer->Write( (u64)( 4 * savedSpirv.size() ) );
     serializer->Write( m_reflectionData.workgroupSize );
     serializer->Write( m_reflectionData.pushConstantSize );
     serializer->Write( m_reflectionData.pushConstantOffset );
     serializer->Write( m_reflectionData.extensions );
     serializer->Write( m_reflectionData.capabilities );
     serializer->Write( m_shaderStage );
-    serializer->Write( savedSpirv );
+    serializer->Write( savedSpirv.data(), 4 * savedSpirv.size() );
 #endif // #else // #if !USING( CONVERTER )
 
     return true;
@@ -270,6 +451,8 @@ bool Shader::Load( const BaseAssetCreateInfo* baseInfo ) { return false; }
 bool Shader::FastfileLoad( Serializer* serializer ) { return false; }
 bool Shader::FastfileSave( Serializer* serializer ) const { return false; }
 void Shader::Free() {}
+void AddSkippedShaderSpirvBlob( const u8* shaderData, size_t shaderDataSize ) {}
+void ClearFastfileSpirvBlobs() {}
 
 #endif // #else // #if USING( GPU_STRUCTS )
 
@@ -34,6 +34,13 @@ struct ShaderCreateInfo : public BaseAssetCreateInfo
 std::string GetShaderCacheName( const std::string& filename, ShaderStage stage, const std::vector<std::string>& defines );
 std::string GetAbsPath_ShaderFilename( const std::string& filename );
 
+// Fastfiles only store each unique spirv blob once (see FastfileWriter). While a fastfile loads, Shader::FastfileLoad
+// remembers where each blob is in the mapped file, so that later shaders with the same spirv can find it. Shaders that
+// get skipped (because they're already loaded) still need to report theirs, since a later shader could reuse it.
+// Clear once the fastfile is done loading, before closing it
+void AddSkippedShaderSpirvBlob( const u8* shaderData, size_t shaderDataSize );
+void ClearFastfileSpirvBlobs();
+
 struct ShaderReflectData
 {
     uvec3 workgroupSize    = uvec3( 0 );
@@ -61,6 +68,7 @@ struct Shader : public BaseAsset
 
 #if USING( CONVERTER )
     std::vector<u32> savedSpirv;
+    u64 savedSpirvHash = 0;
 #endif // #if USING( CONVERTER )
 
 private:
@@ -37,6 +37,8 @@ std::string TexturesetCreateInfo::GetAlbedoMetalnessImageName( bool applyAlbedo,
     HashCombine( hash, metalnessMapName );
     HashCombine( hash, Underlying( metalnessSourceChannel ) );
     HashCombine( hash, metalnessScale );
+    if ( rdoLambda > 0 )
+        HashCombine( hash, rdoLambda );
 
     return cacheName + "~" + std::to_string( hash );
 }
@@ -61,6 +63,8 @@ std::string TexturesetCreateInfo::GetNormalRoughnessImageName( bool applyNormals
     HashCombine( hash, Underlying( roughnessSourceChannel ) );
     HashCombine( hash, invertRoughness );
     HashCombine( hash, roughnessScale );
+    if ( rdoLambda > 0 )
+        HashCombine( hash, rdoLambda );
 
     return cacheName + "~" + std::to_string( hash );
 }
@@ -11,6 +11,7 @@ struct TexturesetCreateInfo : public BaseAssetCreateInfo
     bool clampHorizontal = false;
     bool clampVertical   = false;
     bool flipVertically  = true;
+    f32 rdoLambda        = 0.0f; // Passed on to the albedo, normal and emissive GfxImages. 0 disables RDO
 
     // only set defaults below when there MUST be a texture of that type (only assumed for diffuse + metalness so far)
     std::string albedoMap          = "$white";
@@ -1,12 +1,47 @@
 #include "image_processing.hpp"
+#include "ImageLib/image_strip_reader.hpp"
+#include "core/low_discrepancy_sampling.hpp"
+#include "renderer/brdf_functions.hpp"
 #include "shared/assert.hpp"
 #include "shared/color_spaces.hpp"
 #include "shared/logger.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 namespace PG
 {
 
+// Sources are streamed in bands of this many rows, so only the output image ever has to be fully expanded to floats
+static constexpr u32 COMPOSITE_STRIP_ROWS = 64;
+
+static void CompositeRows( FloatImage2D& outputImg, u32 firstRow, const FloatImage2D& srcRows, const SourceImage& source,
+    ColorSpace srcColorSpace, ColorSpace outputColorSpace )
+{
+    bool convertToLinear = srcColorSpace == ColorSpace::SRGB && outputColorSpace == ColorSpace::LINEAR;
+    bool convertToSRGB   = srcColorSpace == ColorSpace::LINEAR && outputColorSpace == ColorSpace::SRGB;
+    u32 dstPixelOffset   = firstRow * outputImg.width;
+    for ( u32 pixelIndex = 0; pixelIndex < srcRows.width * srcRows.height; ++pixelIndex )
+    {
+        vec4 pixel = srcRows.GetFloat4( pixelIndex );
+
+        // assume that the alpha channel is always linear, in both src and dst images
+        for ( const Remap& remap : source.remaps )
+        {
+            f32 x = pixel[Underlying( remap.from )];
+            if ( remap.from != Channel::A && convertToLinear )
+            {
+                x = PG::GammaSRGBToLinear( x );
+            }
+            if ( remap.to != Channel::A && convertToSRGB )
+            {
+                x = PG::LinearToGammaSRGB( x );
+            }
+
+            outputImg.data[outputImg.numChannels * ( dstPixelOffset + pixelIndex ) + Underlying( remap.to )] = x;
+        }
+    }
+}
+
 FloatImage2D CompositeImage( const CompositeImageInput& input )
 {
     PG_ASSERT( input.compositeType == CompositeType::REMAP );
@@ -21,25 +56,27 @@ FloatImage2D CompositeImage( const CompositeImageInput& input )
 
     ImageLoadFlags imgLoadFlags = input.flipVertically ? ImageLoadFlags::FLIP_VERTICALLY : ImageLoadFlags::DEFAULT;
 
+    // Opening only reads the headers, the pixels are decoded as they get composited. TIFF sources are decoded a strip at a
+    // time, the other formats get fully decoded one source at a time (see ImageStripReader)
     u32 numOutputChannels = 0;
-    FloatImage2D sourceImages[4];
+    ImageStripReader readers[4];
     ColorSpace sourceColorSpaces[4];
     u32 width  = 0;
     u32 height = 0;
     for ( size_t i = 0; i < input.sourceImages.size(); ++i )
     {
-        if ( !sourceImages[i].Load( input.sourceImages[i].filename, imgLoadFlags ) )
+        if ( !readers[i].Open( input.sourceImages[i].filename, imgLoadFlags ) )
         {
             throw std::runtime_error( "Failed to load composite source image" );
         }
         sourceColorSpaces[i] = input.sourceImages[i].colorSpace;
         if ( sourceColorSpaces[i] == ColorSpace::INFER )
         {
-            sourceColorSpaces[i] = sourceImages[i].numChannels > 2 ? ColorSpace::SRGB : ColorSpace::LINEAR;
+            sourceColorSpaces[i] = NumChannels( readers[i].Format() ) > 2 ? ColorSpace::SRGB : ColorSpace::LINEAR;
         }
 
-        width  = Max( width, sourceImages[i].width );
-        height = Max( height, sourceImages[i].height );
+        width  = Max( width, readers[i].Width() );
+        height = Max( height, readers[i].Height() );
 
         for ( const Remap& remap : input.sourceImages[i].remaps )
         {
@@ -51,29 +88,30 @@ FloatImage2D CompositeImage( const CompositeImageInput& input )
     FloatImage2D outputImg( width, height, numOutputChannels );
     for ( size_t i = 0; i < input.sourceImages.size(); ++i )
     {
-        FloatImage2D srcImage = sourceImages[i].Resize( width, height );
-        bool convertToLinear  = sourceColorSpaces[i] == ColorSpace::SRGB && outputColorSpace == ColorSpace::LINEAR;
-        bool convertToSRGB    = sourceColorSpaces[i] == ColorSpace::LINEAR && outputColorSpace == ColorSpace::SRGB;
-        for ( u32 pixelIndex = 0; pixelIndex < width * height; ++pixelIndex )
+        ImageStripReader& reader = readers[i];
+        if ( reader.Width() == width && reader.Height() == height )
         {
-            vec4 pixel = srcImage.GetFloat4( pixelIndex );
-
-            // assume that the alpha channel is always linear, in both src and dst images
-            for ( const Remap& remap : input.sourceImages[i].remaps )
+            for ( u32 firstRow = 0; firstRow < height; firstRow += COMPOSITE_STRIP_ROWS )
             {
-                f32 x = pixel[Underlying( remap.from )];
-                if ( remap.from != Channel::A && convertToLinear )
-                {
-                    x = PG::GammaSRGBToLinear( x );
-                }
-                if ( remap.to != Channel::A && convertToSRGB )
-                {
-                    x = PG::LinearToGammaSRGB( x );
-                }
+                RawImage2D rawRows = reader.ReadRows( firstRow, Min( COMPOSITE_STRIP_ROWS, height - firstRow ) );
+                if ( !rawRows.data )
+                    throw std::runtime_error( "Failed to load composite source image" );
 
-                outputImg.data[outputImg.numChannels * pixelIndex + Underlying( remap.to )] = x;
+                FloatImage2D srcRows = FloatImageFromRawImage2D( rawRows );
+                CompositeRows( outputImg, firstRow, srcRows, input.sourceImages[i], sourceColorSpaces[i], outputColorSpace );
             }
         }
+        else
+        {
+            // Smaller sources (like the 1x1 builtin images) need the whole image to be resized
+            RawImage2D rawImg = reader.ReadRows( 0, reader.Height() );
+            if ( !rawImg.data )
+                throw std::runtime_error( "Failed to load composite source image" );
+
+            FloatImage2D srcImage = FloatImageFromRawImage2D( rawImg ).Resize( width, height );
+            CompositeRows( outputImg, 0, srcImage, input.sourceImages[i], sourceColorSpaces[i], outputColorSpace );
+        }
+        reader.Close();
     }
 
     return outputImg;
@@ -164,4 +202,95 @@ ImageFormat PixelFormatToImageFormat( PixelFormat pixelFormat )
     }
 }
 
+// Filtered importance sampling, from "Real-time Shading with Filtered Importance Sampling" by Krivanek and Colbert. Each
+// sample reads from the mip of the source whose texels cover about the same solid angle as the sample itself does. That
+// gets rid of most of the noise at high roughness, so far fewer samples are needed than when reading the full resolution source
+static constexpr u32 REFLECTION_PROBE_SAMPLE_COUNT = 64;
+
+static vec3 SampleCubemapMips( const std::vector<FloatImageCubemap>& mips, const vec3& dir, f32 lod )
+{
+    lod          = std::clamp( lod, 0.0f, (f32)( mips.size() - 1 ) );
+    i32 lowerMip = static_cast<i32>( lod );
+    i32 upperMip = std::min( lowerMip + 1, (i32)mips.size() - 1 );
+    f32 t        = lod - lowerMip;
+    vec3 lower   = vec3( mips[lowerMip].Sample( dir ) );
+    if ( t == 0.0f || upperMip == lowerMip )
+        return lower;
+
+    return ( 1.0f - t ) * lower + t * vec3( mips[upperMip].Sample( dir ) );
+}
+
+void PrefilterReflectionProbe( const FloatImageCubemap& cubemap, FloatImageCubemap* outputMips, i32 mipLevels, i32 faceSize )
+{
+    std::vector<FloatImageCubemap> sourceMips = { cubemap };
+    while ( sourceMips.back().size > 1 )
+    {
+        const FloatImageCubemap& prevMip = sourceMips.back();
+        FloatImageCubemap mip( prevMip.size / 2, prevMip.numChannels );
+        for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+            mip.faces[faceIdx] = DownsampleImage( prevMip.faces[faceIdx], mip.size, mip.size, MipFilter::BOX, true, true );
+        sourceMips.push_back( mip );
+    }
+    const f32 sourceTexelSolidAngle = 4.0f * PI / ( 6.0f * cubemap.size * cubemap.size );
+
+    // One flat loop over the rows of every face of every mip, so that the threads stay busy even on the tiny low mips
+    std::vector<i32> mipRowOffsets( mipLevels + 1, 0 );
+    for ( i32 mipLevel = 0; mipLevel < mipLevels; ++mipLevel )
+    {
+        outputMips[mipLevel]        = FloatImageCubemap( faceSize >> mipLevel, 3 );
+        mipRowOffsets[mipLevel + 1] = mipRowOffsets[mipLevel] + 6 * ( faceSize >> mipLevel );
+    }
+
+#pragma omp parallel for schedule( dynamic )
+    for ( i32 rowIdx = 0; rowIdx < mipRowOffsets[mipLevels]; ++rowIdx )
+    {
+        i32 mipLevel = 0;
+        while ( rowIdx >= mipRowOffsets[mipLevel + 1] )
+            ++mipLevel;
+        const i32 mipSize             = faceSize >> mipLevel;
+        const i32 faceIdx             = ( rowIdx - mipRowOffsets[mipLevel] ) / mipSize;
+        const i32 dstRow              = ( rowIdx - mipRowOffsets[mipLevel] ) % mipSize;
+        const f32 perceptualRoughness = mipLevel / static_cast<f32>( mipLevels - 1 );
+        const f32 linearRoughness     = perceptualRoughness * perceptualRoughness;
+        for ( i32 dstCol = 0; dstCol < mipSize; ++dstCol )
+        {
+            vec2 faceUV = { ( dstCol + 0.5f ) / mipSize, ( dstRow + 0.5f ) / mipSize };
+
+            vec3 N = CubemapFaceUVToDirection( faceIdx, faceUV );
+            vec3 V = N;
+
+            // a roughness of 0 only reflects a single direction (and the GGX pdf is undefined)
+            if ( mipLevel == 0 )
+            {
+                outputMips[mipLevel].faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( vec3( cubemap.Sample( N ) ), 0 ) );
+                continue;
+            }
+
+            f32 totalWeight = 0;
+            vec3 prefilteredColor( 0 );
+            for ( u32 i = 0u; i < REFLECTION_PROBE_SAMPLE_COUNT; ++i )
+            {
+                vec2 Xi = vec2( i / (f32)REFLECTION_PROBE_SAMPLE_COUNT, Hammersley32( i ) );
+                vec3 H  = ImportanceSampleGGX_D( Xi, N, linearRoughness );
+                vec3 L  = Normalize( 2.0f * Dot( V, H ) * H - V );
+
+                f32 NdotL = Max( Dot( N, L ), 0.0f );
+                if ( NdotL > 0.0f )
+                {
+                    // N == V, so the pdf of L simplifies from D * NdotH / (4 * VdotH) to just D / 4
+                    f32 NdotH            = Max( Dot( N, H ), 0.0f );
+                    f32 pdf              = GGX_D( NdotH, perceptualRoughness ) / 4.0f;
+                    f32 sampleSolidAngle = 1.0f / ( REFLECTION_PROBE_SAMPLE_COUNT * pdf + 0.0001f );
+                    f32 lod              = 0.5f * log2f( sampleSolidAngle / sourceTexelSolidAngle ) + 1.0f;
+
+                    prefilteredColor += SampleCubemapMips( sourceMips, L, lod ) * NdotL;
+                    totalWeight += NdotL;
+                }
+            }
+            prefilteredColor = prefilteredColor / totalWeight;
+            outputMips[mipLevel].faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( prefilteredColor, 0 ) );
+        }
+    }
+}
+
 } // namespace PG
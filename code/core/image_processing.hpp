@@ -51,4 +51,8 @@ FloatImage2D CompositeImage( const CompositeImageInput& input );
 
 ImageFormat PixelFormatToImageFormat( PixelFormat pixelFormat );
 
+// GGX prefiltering for a reflection probe, with filtered importance sampling. Mip i gets a perceptual roughness of
+// i / (mipLevels - 1), and is faceSize >> i wide. outputMips needs mipLevels entries
+void PrefilterReflectionProbe( const FloatImageCubemap& cubemap, FloatImageCubemap* outputMips, i32 mipLevels, i32 faceSize );
+
 } // namespace PG
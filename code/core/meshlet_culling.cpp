@@ -0,0 +1,190 @@
+#include "core/meshlet_culling.hpp"
+#include <algorithm>
+
+namespace PG
+{
+
+static constexpr u32 CULL_BATCH_SIZE = 8;
+
+void MeshletCullStats::Add( const MeshletCullStats& other )
+{
+    numMeshes += other.numMeshes;
+    visibleMeshes += other.visibleMeshes;
+    numMeshlets += other.numMeshlets;
+    frustumCulledMeshlets += other.frustumCulledMeshlets;
+    backfaceCulledMeshlets += other.backfaceCulledMeshlets;
+    visibleMeshlets += other.visibleMeshlets;
+    numTris += other.numTris;
+    visibleTris += other.visibleTris;
+}
+
+// The operations are written out in the same order as the batched version below, so that both always agree exactly
+static bool SphereOutsideFrustum( const Frustum& frustum, const vec3& center, f32 radius )
+{
+    for ( i32 i = 0; i < 6; ++i )
+    {
+        const vec4& plane = frustum.planes[i];
+        f32 dist          = center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w;
+        if ( dist < -radius )
+            return true;
+    }
+
+    return false;
+}
+
+// dot( normalize( d ), axis ) >= cutoff, squared to avoid the sqrt (sqrtf can set errno, which keeps the batched loop from
+// vectorizing). Squaring flips the comparison for negative cutoffs. No branches, also so that the batched version vectorizes.
+// A camera exactly on the apex is never culled, same as on the GPU, where normalize( 0 ) gives NaNs that fail the comparison
+static bool ConeBackfacing( const vec3& cameraPos, const vec3& apex, const vec3& axis, f32 cutoff )
+{
+    vec3 d        = apex - cameraPos;
+    f32 lenSq     = d.x * d.x + d.y * d.y + d.z * d.z;
+    f32 dp        = d.x * axis.x + d.y * axis.y + d.z * axis.z;
+    u32 nonZero   = lenSq > 0;
+    u32 inFront   = dp >= 0;
+    f32 dpSq      = dp * dp;
+    f32 cutoffSq  = cutoff * cutoff * lenSq;
+    u32 positive  = cutoff >= 0;
+    u32 culledPos = positive & inFront & ( dpSq >= cutoffSq );
+    u32 culledNeg = ( positive ^ 1 ) & ( inFront | ( dpSq <= cutoffSq ) );
+    return ( culledPos | culledNeg ) & nonZero;
+}
+
+bool IsMeshletVisible( const MeshletCullView& view, const GpuData::PackedMeshletCullData& cullData )
+{
+    if ( view.frustumCulling && SphereOutsideFrustum( view.frustum, cullData.position, cullData.radius ) )
+        return false;
+
+    if ( view.backfaceCulling && ConeBackfacing( view.cameraPos, cullData.coneApex, cullData.coneAxis, cullData.coneCutoff ) )
+        return false;
+
+    return true;
+}
+
+void MeshletCullBatches::Build( const GpuData::PackedMeshletCullData* cullDatas, u32 inNumMeshlets )
+{
+    numMeshlets = inNumMeshlets;
+    // The padding lanes get zeroes, and are ignored
+    const u32 paddedSize = ROUND_UP_DIV( numMeshlets, CULL_BATCH_SIZE ) * CULL_BATCH_SIZE;
+    for ( std::vector<f32>* stream : { &centerX, &centerY, &centerZ, &radius, &apexX, &apexY, &apexZ, &axisX, &axisY, &axisZ, &cutoff } )
+        stream->assign( paddedSize, 0.0f );
+
+    for ( u32 meshletIdx = 0; meshletIdx < numMeshlets; ++meshletIdx )
+    {
+        const GpuData::PackedMeshletCullData& cullData = cullDatas[meshletIdx];
+        centerX[meshletIdx]                            = cullData.position.x;
+        centerY[meshletIdx]                            = cullData.position.y;
+        centerZ[meshletIdx]                            = cullData.position.z;
+        radius[meshletIdx]                             = cullData.radius;
+        apexX[meshletIdx]                              = cullData.coneApex.x;
+        apexY[meshletIdx]                              = cullData.coneApex.y;
+        apexZ[meshletIdx]                              = cullData.coneApex.z;
+        axisX[meshletIdx]                              = cullData.coneAxis.x;
+        axisY[meshletIdx]                              = cullData.coneAxis.y;
+        axisZ[meshletIdx]                              = cullData.coneAxis.z;
+        cutoff[meshletIdx]                             = cullData.coneCutoff;
+    }
+}
+
+void CullMeshlets(
+    const MeshletCullView& view, const MeshletCullBatches& batches, std::vector<u32>& visibleMeshlets, MeshletCullStats* stats )
+{
+    visibleMeshlets.resize( batches.numMeshlets );
+    u32 numVisible        = 0;
+    u32 numFrustumCulled  = 0;
+    u32 numBackfaceCulled = 0;
+
+    // Every lane is tested, without any early outs, so that each of these loops over the batch vectorizes
+    u32 outside[CULL_BATCH_SIZE], backfacing[CULL_BATCH_SIZE];
+    for ( u32 batchStart = 0; batchStart < batches.numMeshlets; batchStart += CULL_BATCH_SIZE )
+    {
+        const f32* cx = &batches.centerX[batchStart];
+        const f32* cy = &batches.centerY[batchStart];
+        const f32* cz = &batches.centerZ[batchStart];
+        const f32* r  = &batches.radius[batchStart];
+        for ( u32 lane = 0; lane < CULL_BATCH_SIZE; ++lane )
+            outside[lane] = 0;
+        if ( view.frustumCulling )
+        {
+            for ( i32 i = 0; i < 6; ++i )
+            {
+                const vec4 plane = view.frustum.planes[i];
+                for ( u32 lane = 0; lane < CULL_BATCH_SIZE; ++lane )
+                {
+                    f32 dist = cx[lane] * plane.x + cy[lane] * plane.y + cz[lane] * plane.z + plane.w;
+                    outside[lane] |= dist < -r[lane];
+                }
+            }
+        }
+
+        for ( u32 lane = 0; lane < CULL_BATCH_SIZE; ++lane )
+            backfacing[lane] = 0;
+        if ( view.backfaceCulling )
+        {
+            const f32* px     = &batches.apexX[batchStart];
+            const f32* py     = &batches.apexY[batchStart];
+            const f32* pz     = &batches.apexZ[batchStart];
+            const f32* ax     = &batches.axisX[batchStart];
+            const f32* ay     = &batches.axisY[batchStart];
+            const f32* az     = &batches.axisZ[batchStart];
+            const f32* cutoff = &batches.cutoff[batchStart];
+            for ( u32 lane = 0; lane < CULL_BATCH_SIZE; ++lane )
+            {
+                f32 dx           = px[lane] - view.cameraPos.x;
+                f32 dy           = py[lane] - view.cameraPos.y;
+                f32 dz           = pz[lane] - view.cameraPos.z;
+                f32 lenSq        = dx * dx + dy * dy + dz * dz;
+                f32 dp           = dx * ax[lane] + dy * ay[lane] + dz * az[lane];
+                u32 nonZero      = lenSq > 0;
+                u32 inFront      = dp >= 0;
+                f32 dpSq         = dp * dp;
+                f32 cutoffSq     = cutoff[lane] * cutoff[lane] * lenSq;
+                u32 positive     = cutoff[lane] >= 0;
+                u32 culledPos    = positive & inFront & ( dpSq >= cutoffSq );
+                u32 culledNeg    = ( positive ^ 1 ) & ( inFront | ( dpSq <= cutoffSq ) );
+                backfacing[lane] = ( culledPos | culledNeg ) & nonZero & ( outside[lane] ^ 1 );
+            }
+        }
+
+        const u32 batchSize = std::min( CULL_BATCH_SIZE, batches.numMeshlets - batchStart );
+        for ( u32 lane = 0; lane < batchSize; ++lane )
+        {
+            numFrustumCulled += outside[lane];
+            numBackfaceCulled += backfacing[lane];
+            visibleMeshlets[numVisible] = batchStart + lane;
+            numVisible += ( outside[lane] | backfacing[lane] ) ^ 1;
+        }
+    }
+    visibleMeshlets.resize( numVisible );
+
+    if ( stats )
+    {
+        stats->numMeshlets += batches.numMeshlets;
+        stats->frustumCulledMeshlets += numFrustumCulled;
+        stats->backfaceCulledMeshlets += numBackfaceCulled;
+        stats->visibleMeshlets += visibleMeshlets.size();
+    }
+}
+
+void CullMesh( const MeshletCullView& view, const AABB& meshAABB, const GpuData::Meshlet* meshlets, const MeshletCullBatches& batches,
+    std::vector<u32>& visibleMeshlets, MeshletCullStats& stats )
+{
+    stats.numMeshes += 1;
+    for ( u32 meshletIdx = 0; meshletIdx < batches.numMeshlets; ++meshletIdx )
+        stats.numTris += meshlets[meshletIdx].triangleCount;
+
+    if ( view.frustumCulling && !view.frustum.BoxInFrustum( meshAABB ) )
+    {
+        visibleMeshlets.clear();
+        stats.numMeshlets += batches.numMeshlets;
+        stats.frustumCulledMeshlets += batches.numMeshlets;
+        return;
+    }
+
+    stats.visibleMeshes += 1;
+    CullMeshlets( view, batches, visibleMeshlets, &stats );
+    for ( u32 meshletIdx : visibleMeshlets )
+        stats.visibleTris += meshlets[meshletIdx].triangleCount;
+}
+
+} // namespace PG
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "c_shared/model.h"
+#include "core/frustum.hpp"
+#include <vector>
+
+namespace PG
+{
+
+// The frustum planes and camera position are in the mesh's object space. Non uniform scale isn't supported, since the sphere
+// radii would need scaling per plane
+struct MeshletCullView
+{
+    Frustum frustum;
+    vec3 cameraPos;
+    bool frustumCulling  = true;
+    bool backfaceCulling = true;
+};
+
+struct MeshletCullStats
+{
+    u32 numMeshes              = 0;
+    u32 visibleMeshes          = 0;
+    u64 numMeshlets            = 0;
+    u64 frustumCulledMeshlets  = 0; // includes the meshlets of meshes that failed the AABB test
+    u64 backfaceCulledMeshlets = 0;
+    u64 visibleMeshlets        = 0;
+    u64 numTris                = 0;
+    u64 visibleTris            = 0;
+
+    void Add( const MeshletCullStats& other );
+};
+
+// CPU reference for the per meshlet test in cull_meshlets.comp and model.task: a bounding sphere vs frustum plane test,
+// followed by the normal cone backface test
+bool IsMeshletVisible( const MeshletCullView& view, const GpuData::PackedMeshletCullData& cullData );
+
+// Structure of arrays copy of a mesh's meshlet cull data, padded out to whole batches so that the tests in CullMeshlets vectorize.
+// Only needs to be rebuilt when the cull data changes, not for every view
+struct MeshletCullBatches
+{
+    void Build( const GpuData::PackedMeshletCullData* cullDatas, u32 numMeshlets );
+
+    u32 numMeshlets = 0;
+    std::vector<f32> centerX, centerY, centerZ, radius;
+    std::vector<f32> apexX, apexY, apexZ;
+    std::vector<f32> axisX, axisY, axisZ, cutoff;
+};
+
+// Same results as calling IsMeshletVisible on each meshlet. Returns the visible meshlet indices in increasing order
+void CullMeshlets( const MeshletCullView& view, const MeshletCullBatches& batches, std::vector<u32>& visibleMeshlets,
+    MeshletCullStats* stats = nullptr );
+
+// Tests the mesh's AABB with Frustum::BoxInFrustum first, and then its meshlets with CullMeshlets. Only build the batches from the
+// full detail meshlets for meshes with LODs. Adds the mesh, meshlet and triangle counts to stats
+void CullMesh( const MeshletCullView& view, const AABB& meshAABB, const GpuData::Meshlet* meshlets, const MeshletCullBatches& batches,
+    std::vector<u32>& visibleMeshlets, MeshletCullStats& stats );
+
+} // namespace PG
@@ -0,0 +1,31 @@
+#include "core/meshlet_lod.hpp"
+
+namespace PG
+{
+
+f32 ProjectedMeshletError( const MeshletLODView& view, const vec3& center, f32 radius, f32 objectSpaceError )
+{
+    if ( objectSpaceError == FLT_MAX )
+        return FLT_MAX;
+
+    f32 distance        = Max( Length( center - view.cameraPos ) - radius, view.nearPlane );
+    f32 projectionScale = 0.5f * view.screenHeight / tanf( 0.5f * view.vFov );
+    return objectSpaceError / distance * projectionScale;
+}
+
+void SelectMeshletLODs(
+    const MeshletLODView& view, const std::vector<GpuData::MeshletLODCullData>& lodCullDatas, std::vector<u32>& selectedMeshlets )
+{
+    selectedMeshlets.clear();
+    for ( u32 meshletIdx = 0; meshletIdx < (u32)lodCullDatas.size(); ++meshletIdx )
+    {
+        const GpuData::MeshletLODCullData& lodData = lodCullDatas[meshletIdx];
+
+        f32 error       = ProjectedMeshletError( view, lodData.center, lodData.radius, lodData.error );
+        f32 parentError = ProjectedMeshletError( view, lodData.parentCenter, lodData.parentRadius, lodData.parentError );
+        if ( error <= view.errorThresholdInPixels && parentError > view.errorThresholdInPixels )
+            selectedMeshlets.push_back( meshletIdx );
+    }
+}
+
+} // namespace PG
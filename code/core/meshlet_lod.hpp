@@ -0,0 +1,28 @@
+#pragma once
+
+#include "c_shared/model.h"
+#include "shared/math_vec.hpp"
+#include <vector>
+
+namespace PG
+{
+
+// Everything needed to turn a meshlet's object space error into pixels. The camera position is in the mesh's object space
+struct MeshletLODView
+{
+    vec3 cameraPos;
+    f32 vFov;
+    f32 screenHeight;
+    f32 nearPlane;
+    f32 errorThresholdInPixels = 1.0f;
+};
+
+// How many pixels an error of objectSpaceError would cover, at the closest point of the given sphere
+f32 ProjectedMeshletError( const MeshletLODView& view, const vec3& center, f32 radius, f32 objectSpaceError );
+
+// CPU reference for picking the LOD cut. A meshlet is selected when its own error is within the threshold, but its parent's isn't.
+// Every meshlet is tested on its own, like the GPU would. Returns the selected meshlet indices in increasing order
+void SelectMeshletLODs(
+    const MeshletLODView& view, const std::vector<GpuData::MeshletLODCullData>& lodCullDatas, std::vector<u32>& selectedMeshlets );
+
+} // namespace PG
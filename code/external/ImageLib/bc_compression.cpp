@@ -1,195 +1,629 @@
 #include "bc_compression.hpp"
 #include "bc7enc_rdo/bc7e_ispc.h"
+#include "bc7enc_rdo/ert.h"
 #include "bc7enc_rdo/rgbcx.h"
 #include "compressonator/cmp_core/source/cmp_core.h"
 #include "shared/assert.hpp"
 #include "shared/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <omp.h>
+#include <thread>
 #include <vector>
 
+// Compression work from every image, and from every thread calling CompressToBC, goes into one shared pool, split up into
+// fixed size chunks of blocks. The converter already compresses its images from inside of an omp parallel loop, where a
+// nested omp parallel for only runs on the calling thread. So one huge texture would end up compressing on a single core,
+// while the rest sit idle at the end of a convert. The calling threads work on the queue too while waiting for their own
+// images, so nothing is left idle there either.
+// The pool's workers only pick up tasks while fewer than omp_get_max_threads() threads are compressing (callers included).
+// So when the converter's omp team is busy compressing its own images, the workers stay asleep instead of oversubscribing
+// the cores, and they only kick in once the team runs out of images
+static constexpr int BLOCKS_PER_TASK     = 1024; // keep a multiple of BC7_BLOCKS_PER_CALL
+static constexpr int BC7_BLOCKS_PER_CALL = 64;   // bc7e wants an array of 4x4 RGBA blocks, at least 32-64 at a time if possible
+
+// How many bytes back the RDO post process looks for matches to copy. Each task is post processed on its own, so the window
+// never crosses into another task's blocks. LZ4's window is way bigger than this, so this only limits the RDO search time
+static constexpr uint32_t RDO_LOOKBACK_WINDOW_SIZE = 256;
+
+struct CompressionJob
+{
+    const RawImage2D* srcImage;
+    RawImage2D* outputImg;
+    void* bc6Options;
+    std::vector<float> rdoBlockMSEScales; // only when RDO is enabled, see ComputeBlockMSEScales
+};
+
+struct CompressionBatch
+{
+    const BCCompressorSettings* settings;
+    ispc::bc7e_compress_block_params bc7Params;
+    std::vector<CompressionJob> jobs;
+
+    std::atomic<int> tasksRemaining = 0;
+    std::mutex lock;
+    std::condition_variable finished;
+};
+
+struct CompressionTask
+{
+    CompressionBatch* batch;
+    uint32_t jobIndex;
+    int firstBlock;
+    int numBlocks;
+};
+
 template <int FORMAT>
-void Compress_BC_12345( const RawImage2D& srcImage, const BCCompressorSettings& settings, RawImage2D& outputImg )
+static void Compress_BC_12345( const CompressionBatch& batch, const CompressionJob& job, int firstBlock, int numBlocks )
 {
     static_assert( Underlying( CompressionQuality::COUNT ) == 3, "Update the quality level integers below" );
-    const int blocksX       = srcImage.BlocksX();
-    const int blocksY       = srcImage.BlocksY();
-    const int bytesPerBlock = outputImg.BytesPerBlock();
+    const BCCompressorSettings& settings = *batch.settings;
+    const RawImage2D& srcImage           = *job.srcImage;
+    const int blocksX                    = srcImage.BlocksX();
+    const int bytesPerBlock              = job.outputImg->BytesPerBlock();
 
-    rgbcx::init();
     const uint32_t bc1Level = 0 + 9 * Underlying( settings.quality );
     const uint32_t bc4Level = 1 + 5 * Underlying( settings.quality );
     const bool isLowQuality = settings.quality == CompressionQuality::LOWEST;
 
-#pragma omp parallel for
-    for ( int by = 0; by < blocksY; ++by )
+    for ( int blockIdx = firstBlock; blockIdx < firstBlock + numBlocks; ++blockIdx )
     {
-        for ( int bx = 0; bx < blocksX; ++bx )
+        uint8_t src[64];
+        srcImage.GetBlockClamped8Bit( blockIdx % blocksX, blockIdx / blocksX, src );
+        uint8_t* dst = &job.outputImg->data[bytesPerBlock * blockIdx];
+
+        if constexpr ( FORMAT == Underlying( ImageFormat::BC1_UNORM ) )
         {
-            uint8_t src[64];
-            srcImage.GetBlockClamped8Bit( bx, by, src );
-            uint8_t* dst = &outputImg.data[bytesPerBlock * ( by * blocksX + bx )];
+            rgbcx::encode_bc1( bc1Level, dst, src, true, true );
+        }
+        else if constexpr ( FORMAT == Underlying( ImageFormat::BC3_UNORM ) )
+        {
+            if ( isLowQuality )
+                rgbcx::encode_bc3( bc1Level, dst, src );
+            else
+                rgbcx::encode_bc3_hq( bc1Level, dst, src, bc4Level );
+        }
+        else if constexpr ( FORMAT == Underlying( ImageFormat::BC4_UNORM ) || FORMAT == Underlying( ImageFormat::BC4_SNORM ) )
+        {
+            if ( isLowQuality )
+                rgbcx::encode_bc4( dst, &src[settings.bc4SourceChannel] );
+            else
+                rgbcx::encode_bc4_hq( dst, &src[settings.bc4SourceChannel], 4, bc4Level );
+        }
+        else if constexpr ( FORMAT == Underlying( ImageFormat::BC5_UNORM ) || FORMAT == Underlying( ImageFormat::BC5_SNORM ) )
+        {
+            if ( isLowQuality )
+                rgbcx::encode_bc5( dst, src, settings.bc5SourceChannel1, settings.bc5SourceChannel2 );
+            rgbcx::encode_bc5_hq( dst, src, settings.bc5SourceChannel1, settings.bc5SourceChannel2, 4, bc4Level );
+        }
+    }
+}
 
-            if constexpr ( FORMAT == Underlying( ImageFormat::BC1_UNORM ) )
+static void Compress_BC_6( const CompressionBatch& batch, const CompressionJob& job, int firstBlock, int numBlocks )
+{
+    const RawImage2D& srcImage = *job.srcImage;
+    const int blocksX          = srcImage.BlocksX();
+    const int bytesPerBlock    = job.outputImg->BytesPerBlock();
+    const bool isSigned        = batch.settings->format == ImageFormat::BC6H_S16F;
+
+    for ( int blockIdx = firstBlock; blockIdx < firstBlock + numBlocks; ++blockIdx )
+    {
+        float16 blockSrc[48];
+        srcImage.GetBlockClamped16F( blockIdx % blocksX, blockIdx / blocksX, blockSrc );
+
+        // Note1: Compressenator doesn't seem to do any work checks to do any clamping for negative numbers, so do it here
+        // Note2: It's important to not allow for -0.0 with Compressenator's encoder, because it casts the uint16_t directly to a float.
+        // This means that it expects nearby input values to have nearby uint16_t values (at least for unsigned BC6), which is not true
+        // for -0.0 and 0.0. So an easy fix is to just not allow -0.0 (which is 32768 as a uint16_t) in the fp16 input to the BC6
+        // compressor
+        if ( !isSigned )
+        {
+            for ( int i = 0; i < 48; ++i )
             {
-                rgbcx::encode_bc1( bc1Level, dst, src, true, true );
+                if ( blockSrc[i] & 0x8000 )
+                    blockSrc[i] = 0;
             }
-            else if constexpr ( FORMAT == Underlying( ImageFormat::BC3_UNORM ) )
+        }
+        else
+        {
+            for ( int i = 0; i < 48; ++i )
+            {
+                if ( blockSrc[i] == 0x8000 )
+                    blockSrc[i] = 0;
+            }
+        }
+        uint8_t* blockDst = job.outputImg->Raw() + bytesPerBlock * blockIdx;
+        CompressBlockBC6( (uint16_t*)blockSrc, 12, blockDst, job.bc6Options );
+    }
+}
+
+static void Compress_BC_7( const CompressionBatch& batch, const CompressionJob& job, int firstBlock, int numBlocks )
+{
+    const RawImage2D& srcImage = *job.srcImage;
+    const int blocksX          = srcImage.BlocksX();
+    const int bytesPerBlock    = 16;
+
+    struct Block
+    {
+        uint8_t data[64];
+    };
+    Block blocks[BC7_BLOCKS_PER_CALL];
+
+    for ( int chunkStart = firstBlock; chunkStart < firstBlock + numBlocks; chunkStart += BC7_BLOCKS_PER_CALL )
+    {
+        const int chunkBlocks = std::min( BC7_BLOCKS_PER_CALL, firstBlock + numBlocks - chunkStart );
+        for ( int i = 0; i < chunkBlocks; ++i )
+        {
+            const int blockIdx = chunkStart + i;
+            srcImage.GetBlockClamped8Bit( blockIdx % blocksX, blockIdx / blocksX, blocks[i].data );
+        }
+
+        uint64_t* dstBlock = reinterpret_cast<uint64_t*>( job.outputImg->Raw() + chunkStart * bytesPerBlock );
+        uint32_t* srcBlock = reinterpret_cast<uint32_t*>( blocks[0].data );
+        ispc::bc7e_compress_blocks( chunkBlocks, dstBlock, srcBlock, &batch.bc7Params );
+    }
+}
+
+// CompressToBC lets rgbcx use the 3 color modes, so there is no reason to reject trials that use them here
+static bool UnpackBC1BlockForRDO( const void* block, ert::color_rgba* pixels, uint32_t, void* )
+{
+    rgbcx::unpack_bc1( block, pixels, true );
+    return true;
+}
+
+static bool UnpackBC7BlockForRDO( const void* block, ert::color_rgba* pixels, uint32_t, void* )
+{
+    DecompressBC7Block( static_cast<const uint8_t*>( block ), pixels[0].m_c );
+    return true;
+}
+
+// Same as bc7enc_rdo's compute_block_mse_scales. RDO artifacts are the most visible in large, flat regions, like skies and
+// gradients, so blocks in big enough regions of "ultra smooth" blocks get their error scaled up a lot more than ert's own per block
+// smoothness weighting would. Needs the whole image, since those regions can span many tasks. Every other block gets -1, which
+// makes ert fall back to its per block weighting
+static std::vector<float> ComputeBlockMSEScales( const RawImage2D& srcImage )
+{
+    constexpr float ULTRASMOOTH_BLOCK_STD_DEV_THRESHOLD = 2.9f;
+    constexpr float DARK_THRESHOLD                      = 13.0f;
+    constexpr float BRIGHT_THRESHOLD                    = 222.0f;
+    constexpr float ULTRASMOOTH_BLOCK_MSE_SCALE         = 120.0f;
+    constexpr uint32_t ULTRASMOOTH_REGION_MIN_BLOCKS    = 64;
+    constexpr uint32_t MAX_SMOOTH_REGION_CLEANUP_PASSES = 32;
+
+    const int blocksX     = srcImage.BlocksX();
+    const int blocksY     = srcImage.BlocksY();
+    const int totalBlocks = blocksX * blocksY;
+
+    // Blocks that are clearly not ultra smooth (or are too dark or bright for banding to show) start out as true
+    std::vector<uint8_t> notSmooth( totalBlocks );
+    for ( int blockIdx = 0; blockIdx < totalBlocks; ++blockIdx )
+    {
+        uint8_t pixels[64];
+        srcImage.GetBlockClamped8Bit( blockIdx % blocksX, blockIdx / blocksX, pixels );
+
+        // Same integer REC709 luma as bc7enc_rdo
+        float lumaSum   = 0;
+        float sums[3]   = { 0, 0, 0 };
+        float sumsSq[3] = { 0, 0, 0 };
+        for ( int i = 0; i < 16; ++i )
+        {
+            const uint8_t* p = &pixels[4 * i];
+            lumaSum += static_cast<float>( ( 13938u * p[0] + 46869u * p[1] + 4729u * p[2] + 32768u ) >> 16u );
+            for ( int c = 0; c < 3; ++c )
             {
-                if ( isLowQuality )
-                    rgbcx::encode_bc3( bc1Level, dst, src );
-                else
-                    rgbcx::encode_bc3_hq( bc1Level, dst, src, bc4Level );
+                sums[c] += p[c];
+                sumsSq[c] += p[c] * p[c];
             }
-            else if constexpr ( FORMAT == Underlying( ImageFormat::BC4_UNORM ) || FORMAT == Underlying( ImageFormat::BC4_SNORM ) )
+        }
+        float maxStdDev = 0;
+        for ( int c = 0; c < 3; ++c )
+            maxStdDev = std::max( maxStdDev, sqrtf( std::max( 0.0f, 16 * sumsSq[c] - sums[c] * sums[c] ) ) / 16 );
+
+        float yl            = std::clamp( maxStdDev / ULTRASMOOTH_BLOCK_STD_DEV_THRESHOLD, 0.0f, 1.0f );
+        yl                  = yl * yl;
+        const float avgLuma = lumaSum / 16;
+        if ( avgLuma < DARK_THRESHOLD || avgLuma >= BRIGHT_THRESHOLD )
+            yl = 1.0f;
+        notSmooth[blockIdx] = (int)( yl * 255.0f + 0.5f ) >= 255;
+    }
+
+    auto CountNeighbors = [&]( const std::vector<uint8_t>& mask, int bx, int by )
+    {
+        int count = 0;
+        for ( int dy = -1; dy <= 1; ++dy )
+        {
+            for ( int dx = -1; dx <= 1; ++dx )
             {
-                if ( isLowQuality )
-                    rgbcx::encode_bc4( dst, &src[settings.bc4SourceChannel] );
-                else
-                    rgbcx::encode_bc4_hq( dst, &src[settings.bc4SourceChannel], 4, bc4Level );
+                const int x = std::clamp( bx + dx, 0, blocksX - 1 );
+                const int y = std::clamp( by + dy, 0, blocksY - 1 );
+                count += mask[x + y * blocksX];
             }
-            else if constexpr ( FORMAT == Underlying( ImageFormat::BC5_UNORM ) || FORMAT == Underlying( ImageFormat::BC5_SNORM ) )
+        }
+        return count;
+    };
+
+    // Grow the non smooth blocks by one, and then fill in any smooth blocks that are mostly surrounded by non smooth ones
+    std::vector<uint8_t> next( totalBlocks );
+    for ( int blockIdx = 0; blockIdx < totalBlocks; ++blockIdx )
+        next[blockIdx] = CountNeighbors( notSmooth, blockIdx % blocksX, blockIdx / blocksX ) > 0;
+    notSmooth.swap( next );
+    for ( uint32_t pass = 0; pass < MAX_SMOOTH_REGION_CLEANUP_PASSES; ++pass )
+    {
+        bool changed = false;
+        for ( int blockIdx = 0; blockIdx < totalBlocks; ++blockIdx )
+        {
+            next[blockIdx] = notSmooth[blockIdx] || CountNeighbors( notSmooth, blockIdx % blocksX, blockIdx / blocksX ) >= 5;
+            changed        = changed || next[blockIdx] != notSmooth[blockIdx];
+        }
+        notSmooth.swap( next );
+        if ( !changed )
+            break;
+    }
+
+    // Only regions of at least ULTRASMOOTH_REGION_MIN_BLOCKS (4 connected) smooth blocks count
+    std::vector<float> scales( totalBlocks, -1.0f );
+    std::vector<uint8_t> visited( notSmooth );
+    std::vector<int> region, stack;
+    for ( int startIdx = 0; startIdx < totalBlocks; ++startIdx )
+    {
+        if ( visited[startIdx] )
+            continue;
+
+        region.clear();
+        stack.push_back( startIdx );
+        visited[startIdx] = true;
+        while ( !stack.empty() )
+        {
+            const int blockIdx = stack.back();
+            stack.pop_back();
+            region.push_back( blockIdx );
+            const int bx              = blockIdx % blocksX;
+            const int by              = blockIdx / blocksX;
+            const int neighbors[4][2] = { { bx - 1, by }, { bx + 1, by }, { bx, by - 1 }, { bx, by + 1 } };
+            for ( const auto& [x, y] : neighbors )
             {
-                if ( isLowQuality )
-                    rgbcx::encode_bc5( dst, src, settings.bc5SourceChannel1, settings.bc5SourceChannel2 );
-                rgbcx::encode_bc5_hq( dst, src, settings.bc5SourceChannel1, settings.bc5SourceChannel2, 4, bc4Level );
+                if ( x < 0 || y < 0 || x >= blocksX || y >= blocksY || visited[x + y * blocksX] )
+                    continue;
+                visited[x + y * blocksX] = true;
+                stack.push_back( x + y * blocksX );
             }
         }
+
+        if ( region.size() >= ULTRASMOOTH_REGION_MIN_BLOCKS )
+        {
+            for ( int blockIdx : region )
+                scales[blockIdx] = ULTRASMOOTH_BLOCK_MSE_SCALE;
+        }
     }
+
+    return scales;
 }
 
-void Compress_BC_6( const RawImage2D& srcImage, const BCCompressorSettings& settings, RawImage2D& outputImg )
+// Rate distortion optimization: replaces the bits of blocks with runs copied from the nearby, previous blocks whenever the increase
+// in error is worth it, which gives LZ compressors a lot more matches to work with. This is the same ert post process and tuning
+// that bc7enc_rdo's rdo_bc_encoder uses, including its ultra smooth block handling
+static void ReduceEntropy( const CompressionBatch& batch, const CompressionJob& job, int firstBlock, int numBlocks )
 {
-    const int blocksX       = srcImage.BlocksX();
-    const int blocksY       = srcImage.BlocksY();
-    const int bytesPerBlock = outputImg.BytesPerBlock();
+    const RawImage2D& srcImage   = *job.srcImage;
+    const int blocksX            = srcImage.BlocksX();
+    const bool isBC7             = batch.settings->format == ImageFormat::BC7_UNORM;
+    const uint32_t bytesPerBlock = isBC7 ? 16 : 8;
+    const float lambda           = batch.settings->rdoLambda;
 
-    void* options = nullptr;
-    CreateOptionsBC6( &options );
-    SetQualityBC6(
-        options, (float)settings.quality / (float)CompressionQuality::HIGHEST ); // quality is continuous in [0,1], the higher the better
-    bool isSigned = settings.format == ImageFormat::BC6H_S16F;
-    SetSignedBC6( options, isSigned );
+    std::vector<ert::color_rgba> pixels( 16 * numBlocks );
+    for ( int i = 0; i < numBlocks; ++i )
+    {
+        const int blockIdx = firstBlock + i;
+        srcImage.GetBlockClamped8Bit( blockIdx % blocksX, blockIdx / blocksX, pixels[16 * i].m_c );
+    }
 
-#pragma omp parallel for
-    for ( int by = 0; by < blocksY; ++by )
+    ert::reduce_entropy_params params;
+    params.m_lambda                     = lambda;
+    params.m_lookback_window_size       = RDO_LOOKBACK_WINDOW_SIZE;
+    params.m_smooth_block_max_mse_scale = std::lerp( 15.0f, 50.0f, std::min( 1.0f, lambda / ( isBC7 ? 4.0f : 8.0f ) ) );
+    if ( !isBC7 )
+        params.m_color_weights[3] = 0;
+
+    // The ultra smooth scales get stronger with lambda too, and are never weaker than ert's own smooth block weighting
+    std::vector<float> mseScales( job.rdoBlockMSEScales.begin() + firstBlock, job.rdoBlockMSEScales.begin() + firstBlock + numBlocks );
+    for ( float& scale : mseScales )
+    {
+        if ( scale > 0.0f )
+            scale = std::max( params.m_smooth_block_max_mse_scale, scale * std::min( lambda, 3.0f ) );
+    }
+
+    uint32_t numModified = 0;
+    uint8_t* blocks      = job.outputImg->Raw() + firstBlock * bytesPerBlock;
+    ert::reduce_entropy( blocks, numBlocks, bytesPerBlock, bytesPerBlock, 4, 4, isBC7 ? 4 : 3, pixels.data(), params, numModified,
+        isBC7 ? UnpackBC7BlockForRDO : UnpackBC1BlockForRDO, nullptr, &mseScales );
+}
+
+static void RunCompressionTask( const CompressionTask& task )
+{
+    const CompressionBatch& batch = *task.batch;
+    const CompressionJob& job     = batch.jobs[task.jobIndex];
+    switch ( batch.settings->format )
+    {
+    case ImageFormat::BC1_UNORM:
+        Compress_BC_12345<Underlying( ImageFormat::BC1_UNORM )>( batch, job, task.firstBlock, task.numBlocks );
+        break;
+    case ImageFormat::BC3_UNORM:
+        Compress_BC_12345<Underlying( ImageFormat::BC3_UNORM )>( batch, job, task.firstBlock, task.numBlocks );
+        break;
+    case ImageFormat::BC4_UNORM:
+        Compress_BC_12345<Underlying( ImageFormat::BC4_UNORM )>( batch, job, task.firstBlock, task.numBlocks );
+        break;
+    case ImageFormat::BC4_SNORM:
+        Compress_BC_12345<Underlying( ImageFormat::BC4_SNORM )>( batch, job, task.firstBlock, task.numBlocks );
+        break;
+    case ImageFormat::BC5_UNORM:
+        Compress_BC_12345<Underlying( ImageFormat::BC5_UNORM )>( batch, job, task.firstBlock, task.numBlocks );
+        break;
+    case ImageFormat::BC5_SNORM:
+        Compress_BC_12345<Underlying( ImageFormat::BC5_SNORM )>( batch, job, task.firstBlock, task.numBlocks );
+        break;
+    case ImageFormat::BC6H_U16F:
+    case ImageFormat::BC6H_S16F: Compress_BC_6( batch, job, task.firstBlock, task.numBlocks ); break;
+    case ImageFormat::BC7_UNORM: Compress_BC_7( batch, job, task.firstBlock, task.numBlocks ); break;
+    default: break;
+    }
+
+    const ImageFormat format = batch.settings->format;
+    if ( batch.settings->rdoLambda > 0 && ( format == ImageFormat::BC1_UNORM || format == ImageFormat::BC7_UNORM ) )
+        ReduceEntropy( batch, job, task.firstBlock, task.numBlocks );
+}
+
+static void InitEncoders()
+{
+    static std::once_flag s_initialized;
+    std::call_once( s_initialized,
+        []()
+        {
+            rgbcx::init();
+            ispc::bc7e_compress_block_init();
+        } );
+}
+
+class CompressionTaskPool
+{
+public:
+    CompressionTaskPool()
+    {
+        InitEncoders();
+
+        // A single caller does work too, so the workers only need to fill the rest of the threads
+        m_maxBusyThreads     = std::max( 1, omp_get_max_threads() );
+        const int numWorkers = m_maxBusyThreads - 1;
+        for ( int i = 0; i < numWorkers; ++i )
+            m_workers.emplace_back( &CompressionTaskPool::WorkerLoop, this );
+    }
+
+    ~CompressionTaskPool()
     {
-        for ( int bx = 0; bx < blocksX; ++bx )
         {
-            float16 blockSrc[48];
-            srcImage.GetBlockClamped16F( bx, by, blockSrc );
+            std::scoped_lock lock( m_lock );
+            m_shutdown = true;
+        }
+        m_taskAvailable.notify_all();
+        for ( std::thread& worker : m_workers )
+            worker.join();
+    }
+
+    int NumThreads() const { return m_maxBusyThreads; }
 
-            // Note1: Compressenator doesn't seem to do any work checks to do any clamping for negative numbers, so do it here
-            // Note2: It's important to not allow for -0.0 with Compressenator's encoder, because it casts the uint16_t directly to a float.
-            // This means that it expects nearby input values to have nearby uint16_t values (at least for unsigned BC6), which is not true
-            // for -0.0 and 0.0. So an easy fix is to just not allow -0.0 (which is 32768 as a uint16_t) in the fp16 input to the BC6
-            // compressor
-            if ( !isSigned )
+    // Returns once every task in the batch has been completed
+    void Run( CompressionBatch& batch )
+    {
+        int numTasks = 0;
+        {
+            std::scoped_lock lock( m_lock );
+            for ( uint32_t jobIdx = 0; jobIdx < (uint32_t)batch.jobs.size(); ++jobIdx )
             {
-                for ( int i = 0; i < 48; ++i )
+                const int totalBlocks = batch.jobs[jobIdx].srcImage->TotalBlocks();
+                for ( int firstBlock = 0; firstBlock < totalBlocks; firstBlock += BLOCKS_PER_TASK )
                 {
-                    if ( blockSrc[i] & 0x8000 )
-                        blockSrc[i] = 0;
+                    m_tasks.push_back( { &batch, jobIdx, firstBlock, std::min( BLOCKS_PER_TASK, totalBlocks - firstBlock ) } );
+                    ++numTasks;
                 }
             }
-            else
+            batch.tasksRemaining = numTasks;
+        }
+        m_taskAvailable.notify_all();
+
+        while ( batch.tasksRemaining > 0 )
+        {
+            if ( !TryRunTask() )
             {
-                for ( int i = 0; i < 48; ++i )
-                {
-                    if ( blockSrc[i] == 0x8000 )
-                        blockSrc[i] = 0;
-                }
+                // the queue is empty, so the rest of this batch's tasks are already running on other threads
+                std::unique_lock lock( batch.lock );
+                batch.finished.wait( lock, [&batch] { return batch.tasksRemaining == 0; } );
             }
-            uint8_t* blockDst = outputImg.Raw() + bytesPerBlock * ( by * blocksX + bx );
-            CompressBlockBC6( (uint16_t*)blockSrc, 12, blockDst, options );
         }
-    }
-    DestroyOptionsBC6( options );
-}
 
-void Compress_BC_7( const RawImage2D& srcImage, const BCCompressorSettings& settings, RawImage2D& outputImg )
-{
-    const int blocksX       = srcImage.BlocksX();
-    const int blocksY       = srcImage.BlocksY();
-    const int totalBlocks   = blocksX * blocksY;
-    const int bytesPerBlock = 16;
-
-    ispc::bc7e_compress_block_params params;
-    ispc::bc7e_compress_block_init();
-    if ( settings.quality == CompressionQuality::LOWEST )
-        ispc::bc7e_compress_block_params_init_ultrafast( &params, true );
-    else if ( settings.quality == CompressionQuality::MEDIUM )
-        ispc::bc7e_compress_block_params_init_basic( &params, true );
-    else
-        ispc::bc7e_compress_block_params_init_slowest( &params, true );
+        // The thread that finished the last task might still be holding the lock, and the batch is about to go out of scope
+        std::scoped_lock lock( batch.lock );
+    }
 
-    struct Block
+private:
+    // Callers always get to run tasks, since their thread is already occupied by the call either way
+    bool TryRunTask()
     {
-        uint8_t data[64];
-    };
+        CompressionTask task;
+        {
+            std::scoped_lock lock( m_lock );
+            if ( m_tasks.empty() )
+                return false;
+            task = m_tasks.front();
+            m_tasks.pop_front();
+            ++m_busyThreads;
+        }
 
-    // bc7e wants an array of 4x4 RGBA blocks, at least 32-64 at a time if possible
-    std::vector<Block> blocks( totalBlocks );
+        RunCompressionTask( task );
+        FinishTask( *task.batch );
+        return true;
+    }
 
-#pragma omp parallel for
-    for ( int by = 0; by < blocksY; ++by )
+    void FinishTask( CompressionBatch& batch )
     {
-        for ( int bx = 0; bx < blocksX; ++bx )
         {
-            srcImage.GetBlockClamped8Bit( bx, by, blocks[by * blocksX + bx].data );
+            std::scoped_lock lock( m_lock );
+            --m_busyThreads;
         }
+        m_taskAvailable.notify_one(); // a worker might have been waiting on a free thread
+
+        std::scoped_lock lock( batch.lock );
+        if ( --batch.tasksRemaining == 0 )
+            batch.finished.notify_all();
     }
 
-    const int blocksPerChunk = 64;
-    const int chunks         = ( totalBlocks + blocksPerChunk - 1 ) / blocksPerChunk;
-#pragma omp parallel for
-    for ( int chunk = 0; chunk < chunks; ++chunk )
+    void WorkerLoop()
     {
-        uint64_t* dstBlock = reinterpret_cast<uint64_t*>( outputImg.Raw() + chunk * blocksPerChunk * bytesPerBlock );
-        uint32_t numBlocks = std::min( blocksPerChunk, totalBlocks - chunk * blocksPerChunk );
-        uint32_t* srcBlock = reinterpret_cast<uint32_t*>( blocks[chunk * blocksPerChunk].data );
-        ispc::bc7e_compress_blocks( numBlocks, dstBlock, srcBlock, &params );
+        while ( true )
+        {
+            CompressionTask task;
+            {
+                std::unique_lock lock( m_lock );
+                m_taskAvailable.wait( lock, [this] { return m_shutdown || ( !m_tasks.empty() && m_busyThreads < m_maxBusyThreads ); } );
+                if ( m_shutdown )
+                    return;
+                task = m_tasks.front();
+                m_tasks.pop_front();
+                ++m_busyThreads;
+            }
+
+            RunCompressionTask( task );
+            FinishTask( *task.batch );
+        }
     }
+
+    std::mutex m_lock;
+    std::condition_variable m_taskAvailable;
+    std::deque<CompressionTask> m_tasks;
+    std::vector<std::thread> m_workers;
+    int m_maxBusyThreads = 1;
+    int m_busyThreads    = 0; // threads currently running a task, callers included
+    bool m_shutdown      = false;
+};
+
+static CompressionTaskPool& GetCompressionTaskPool()
+{
+    static CompressionTaskPool s_pool;
+    return s_pool;
 }
 
+int GetBCCompressionThreadCount() { return GetCompressionTaskPool().NumThreads(); }
+
 RawImage2D CompressToBC( const RawImage2D& image, const BCCompressorSettings& settings )
 {
-    RawImage2D compressedImg( image.width, image.height, settings.format );
+    return CompressToBC( std::vector<RawImage2D>{ image }, settings )[0];
+}
 
-    bool error = false;
+// Returns false if the format isn't supported. The batch points into images and outputImages
+static bool InitCompressionBatch( const std::vector<RawImage2D>& images, const BCCompressorSettings& settings, CompressionBatch& batch,
+    std::vector<RawImage2D>& outputImages )
+{
     switch ( settings.format )
     {
-    case ImageFormat::BC1_UNORM: Compress_BC_12345<Underlying( ImageFormat::BC1_UNORM )>( image, settings, compressedImg ); break;
+    case ImageFormat::BC1_UNORM:
+    case ImageFormat::BC3_UNORM:
+    case ImageFormat::BC4_UNORM:
+    case ImageFormat::BC4_SNORM:
+    case ImageFormat::BC5_UNORM:
+    case ImageFormat::BC5_SNORM:
+    case ImageFormat::BC6H_U16F:
+    case ImageFormat::BC6H_S16F:
+    case ImageFormat::BC7_UNORM: break;
     case ImageFormat::BC2_UNORM:
         LOG_ERR( "CompressToBC: BC2 is not suppported, please use BC3 instead" );
-        error = true;
-        break;
-    case ImageFormat::BC3_UNORM: Compress_BC_12345<Underlying( ImageFormat::BC3_UNORM )>( image, settings, compressedImg ); break;
-    case ImageFormat::BC4_UNORM: Compress_BC_12345<Underlying( ImageFormat::BC4_UNORM )>( image, settings, compressedImg ); break;
-    case ImageFormat::BC4_SNORM: Compress_BC_12345<Underlying( ImageFormat::BC4_SNORM )>( image, settings, compressedImg ); break;
-    case ImageFormat::BC5_UNORM: Compress_BC_12345<Underlying( ImageFormat::BC5_UNORM )>( image, settings, compressedImg ); break;
-    case ImageFormat::BC5_SNORM: Compress_BC_12345<Underlying( ImageFormat::BC5_SNORM )>( image, settings, compressedImg ); break;
-    case ImageFormat::BC6H_U16F:
-    case ImageFormat::BC6H_S16F: Compress_BC_6( image, settings, compressedImg ); break;
-    case ImageFormat::BC7_UNORM: Compress_BC_7( image, settings, compressedImg ); break;
+        return false;
     default:
         LOG_ERR( "CompressToBC: trying to compress to a format (%u) that is not a BC format", (uint32_t)settings.format );
-        error = true;
+        return false;
     }
 
-    if ( error )
+    batch.settings = &settings;
+    batch.jobs.resize( images.size() );
+    const bool isBC6 = settings.format == ImageFormat::BC6H_U16F || settings.format == ImageFormat::BC6H_S16F;
+    const bool useRDO =
+        settings.rdoLambda > 0 && ( settings.format == ImageFormat::BC1_UNORM || settings.format == ImageFormat::BC7_UNORM );
+    for ( size_t i = 0; i < images.size(); ++i )
     {
-        compressedImg.data = nullptr;
+        outputImages[i]     = RawImage2D( images[i].width, images[i].height, settings.format );
+        CompressionJob& job = batch.jobs[i];
+        job.srcImage        = &images[i];
+        job.outputImg       = &outputImages[i];
+        job.bc6Options      = nullptr;
+        if ( isBC6 )
+        {
+            CreateOptionsBC6( &job.bc6Options );
+            // quality is continuous in [0,1], the higher the better
+            SetQualityBC6( job.bc6Options, (float)settings.quality / (float)CompressionQuality::HIGHEST );
+            SetSignedBC6( job.bc6Options, settings.format == ImageFormat::BC6H_S16F );
+        }
+        if ( useRDO )
+            job.rdoBlockMSEScales = ComputeBlockMSEScales( images[i] );
+    }
+
+    if ( settings.format == ImageFormat::BC7_UNORM )
+    {
+        if ( settings.quality == CompressionQuality::LOWEST )
+            ispc::bc7e_compress_block_params_init_ultrafast( &batch.bc7Params, true );
+        else if ( settings.quality == CompressionQuality::MEDIUM )
+            ispc::bc7e_compress_block_params_init_basic( &batch.bc7Params, true );
+        else
+            ispc::bc7e_compress_block_params_init_slowest( &batch.bc7Params, true );
     }
 
-    return compressedImg;
+    return true;
+}
+
+static void DestroyCompressionBatch( CompressionBatch& batch )
+{
+    for ( CompressionJob& job : batch.jobs )
+    {
+        if ( job.bc6Options )
+            DestroyOptionsBC6( job.bc6Options );
+    }
 }
 
 std::vector<RawImage2D> CompressToBC( const std::vector<RawImage2D>& images, const BCCompressorSettings& settings )
 {
+    CompressionTaskPool& pool = GetCompressionTaskPool();
     std::vector<RawImage2D> outputImages( images.size() );
-    for ( size_t i = 0; i < images.size(); ++i )
+    CompressionBatch batch;
+    if ( !InitCompressionBatch( images, settings, batch, outputImages ) )
+        return std::vector<RawImage2D>( images.size() );
+
+    pool.Run( batch );
+    DestroyCompressionBatch( batch );
+
+    return outputImages;
+}
+
+std::vector<RawImage2D> CompressToBCPerImage( const std::vector<RawImage2D>& images, const BCCompressorSettings& settings )
+{
+    InitEncoders();
+    std::vector<RawImage2D> outputImages( images.size() );
+    CompressionBatch batch;
+    if ( !InitCompressionBatch( images, settings, batch, outputImages ) )
+        return std::vector<RawImage2D>( images.size() );
+
+    for ( uint32_t jobIdx = 0; jobIdx < (uint32_t)batch.jobs.size(); ++jobIdx )
     {
-        outputImages[i] = CompressToBC( images[i], settings );
+        const int totalBlocks = batch.jobs[jobIdx].srcImage->TotalBlocks();
+        const int numTasks    = ( totalBlocks + BLOCKS_PER_TASK - 1 ) / BLOCKS_PER_TASK;
+#pragma omp parallel for
+        for ( int taskIdx = 0; taskIdx < numTasks; ++taskIdx )
+        {
+            const int firstBlock = taskIdx * BLOCKS_PER_TASK;
+            RunCompressionTask( { &batch, jobIdx, firstBlock, std::min( BLOCKS_PER_TASK, totalBlocks - firstBlock ) } );
+        }
     }
+    DestroyCompressionBatch( batch );
 
     return outputImages;
 }
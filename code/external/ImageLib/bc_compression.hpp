@@ -18,9 +18,22 @@ struct BCCompressorSettings
     int bc4SourceChannel       = 0;
     int bc5SourceChannel1      = 0;
     int bc5SourceChannel2      = 1;
+
+    // BC1 and BC7 only. If > 0, the blocks are post processed to be more LZ compressible (rate distortion optimization), at the
+    // cost of some quality. Larger values trade more quality for smaller compressed sizes, roughly in the range of [0.25, 4]
+    float rdoLambda = 0.0f;
 };
 
 // Note: BC6H_U16F works fine, but something seems wrong with Compressenator's BC6H_S16F
+// Both versions are safe to call from multiple threads at once. The blocks of every image get compressed in parallel, by a
+// thread pool that is shared between all callers. So prefer passing all of the mips (or faces) at once, instead of one at a time
 RawImage2D CompressToBC( const RawImage2D& image, const BCCompressorSettings& settings );
 std::vector<RawImage2D> CompressToBC( const std::vector<RawImage2D>& images, const BCCompressorSettings& settings );
+// Same output as CompressToBC, but each image's blocks just get compressed by an omp parallel for, one image at a time, like
+// CompressToBC did before the shared pool. Only meant for comparing the two in bc_benchmark
+std::vector<RawImage2D> CompressToBCPerImage( const std::vector<RawImage2D>& images, const BCCompressorSettings& settings );
+// The most threads that CompressToBC will have compressing at once. Comes from omp_get_max_threads() on the first call
+int GetBCCompressionThreadCount();
 RawImage2D DecompressBC( const RawImage2D& compressedImage );
+// Decodes a single 16 byte BC7 block into 4x4 RGBA8 pixels
+void DecompressBC7Block( const uint8_t* compressedBlock, uint8_t decompressedBlock[64] );
@@ -881,7 +881,7 @@ static uint32_t BC7_Interpolate( uint32_t e0, uint32_t e1, uint8_t bitsPerIndex,
     return ( ( 64 - lerpWeight ) * e0 + lerpWeight * e1 + 32 ) >> 6;
 }
 
-static void Decompress_BC7_Block( const uint8_t* compressedBlock, uint8_t decompressedBlock[64] )
+void DecompressBC7Block( const uint8_t* compressedBlock, uint8_t decompressedBlock[64] )
 {
     uint32_t mode = ctz( *compressedBlock );
     if ( mode > 7 )
@@ -1044,7 +1044,7 @@ void Decompress_BC_Internal( const RawImage2D& compressedImage, RawImage2D& outp
             else if constexpr ( FORMAT == Underlying( ImageFormat::BC6H_S16F ) )
                 Decompress_BC6_Block( compressedBlock, (uint16_t*)decompressedBlock, true );
             else if constexpr ( FORMAT == Underlying( ImageFormat::BC7_UNORM ) )
-                Decompress_BC7_Block( compressedBlock, decompressedBlock );
+                DecompressBC7Block( compressedBlock, decompressedBlock );
 
             uint32_t rowsToCopy = std::min( outputImage.height - 4 * blockY, 4u );
             uint32_t colsToCopy = std::min( outputImage.width - 4 * blockX, 4u );
@@ -826,43 +826,6 @@ std::vector<RawImage2D> RawImage2DFromFloatImages( const std::vector<FloatImage2
     return rawImages;
 }
 
-std::vector<FloatImage2D> GenerateMipmaps( const FloatImage2D& image, const MipmapGenerationSettings& settings )
-{
-    std::vector<FloatImage2D> mips;
-
-    uint32_t numMips = CalculateNumMips( image.width, image.height );
-
-    uint32_t w           = image.width;
-    uint32_t h           = image.height;
-    uint32_t numChannels = image.numChannels;
-    stbir_edge edgeModeU = settings.clampHorizontal ? STBIR_EDGE_CLAMP : STBIR_EDGE_WRAP;
-    stbir_edge edgeModeV = settings.clampVertical ? STBIR_EDGE_CLAMP : STBIR_EDGE_WRAP;
-    for ( uint32_t mipLevel = 0; mipLevel < numMips; ++mipLevel )
-    {
-        FloatImage2D mip( w, h, image.numChannels );
-        if ( mipLevel == 0 )
-        {
-            memcpy( mip.data.get(), image.data.get(), w * h * numChannels * sizeof( float ) );
-        }
-        else
-        {
-            // NOTE!!! With STBIR_EDGE_WRAP and STBIR_FILTER_MITCHELL, im seeing artifacts, at least for non-even dimensioned images.
-            // Both the top and right edges have dark lines near them, and some seemingly garbage pixels
-            int alphaChannel            = STBIR_ALPHA_CHANNEL_NONE;
-            const FloatImage2D& prevMip = mips[mipLevel - 1];
-            stbir_resize( prevMip.data.get(), prevMip.width, prevMip.height, prevMip.width * numChannels * sizeof( float ), mip.data.get(),
-                w, h, w * numChannels * sizeof( float ), STBIR_TYPE_FLOAT, numChannels, alphaChannel, 0, edgeModeU, edgeModeV,
-                STBIR_FILTER_BOX, STBIR_FILTER_BOX, STBIR_COLORSPACE_LINEAR, NULL );
-        }
-
-        mips.push_back( mip );
-        w = Max( 1u, w >> 1 );
-        h = Max( 1u, h >> 1 );
-    }
-
-    return mips;
-}
-
 uint32_t CalculateNumMips( uint32_t width, uint32_t height )
 {
     uint32_t largestDim = Max( width, height );
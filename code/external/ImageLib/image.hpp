@@ -287,6 +287,7 @@ struct FloatImage2D
     // Currently just calls RawImage2DFromFloatImage, and then RawImage2D::Save
     bool Save( const std::string& filename, ImageSaveFlags saveFlags = ImageSaveFlags::DEFAULT ) const;
 
+    // General purpose resize with stbir's default filter. Mip chains should use GenerateMipmaps or DownsampleImage instead
     FloatImage2D Resize( uint32_t newWidth, uint32_t newHeight ) const;
     FloatImage2D Clone() const;
 
@@ -375,14 +376,51 @@ std::vector<RawImage2D> RawImage2DFromFloatImages(
 FloatImageCubemap EquirectangularToCubemap( const FloatImage2D& equiImg );
 FloatImage2D CubemapToEquirectangular( const FloatImageCubemap& cubemap );
 
+// L2 spherical harmonics, 9 RGB coefficients in the order Y00, Y1-1, Y10, Y11, Y2-2, Y2-1, Y20, Y21, Y22
+struct SH9Color
+{
+    vec3 coeffs[9];
+};
+
+// Projects the cubemap onto the SH basis in one pass over the texels, weighting each by its solid angle
+SH9Color ProjectCubemapToSH9( const FloatImageCubemap& cubemap );
+// Convolves radiance SH with the clamped cosine lobe, and divides by PI. Evaluating the result gives irradiance / PI,
+// aka the outgoing radiance of a white lambertian surface with that normal
+SH9Color ConvolveSH9WithCosineLobe( const SH9Color& sh );
+vec3 EvaluateSH9( const SH9Color& sh, const vec3& dir );
+
+enum class MipFilter : uint8_t
+{
+    BOX,     // exact area average. Softest, but never rings
+    KAISER,  // kaiser windowed sinc, radius 3. Sharper, with very little ringing
+    LANCZOS, // lanczos 3. Sharpest, but rings the most
+
+    COUNT
+};
+
 struct MipmapGenerationSettings
 {
+    MipFilter filter     = MipFilter::BOX;
     bool clampHorizontal = false;
     bool clampVertical   = false;
+
+    // Whether the RGB channels are sRGB encoded. They get filtered in linear space, and converted back after
+    bool srgb = false;
+
+    // Rescales the alpha of each mip, so that the fraction of texels with alpha >= alphaCoverageRef matches mip 0's.
+    // Keeps alpha tested foliage, fences, etc from thinning out in the distance. Only for 4 channel images
+    bool preserveAlphaCoverage = false;
+    float alphaCoverageRef     = 0.5f;
 };
 
+// Each mip is downsampled from the previous one with DownsampleImage, so the mips are all multithreaded already
 std::vector<FloatImage2D> GenerateMipmaps( const FloatImage2D& floatImage, const MipmapGenerationSettings& settings );
 
+// Separable, tiled and multithreaded downsample. newWidth and newHeight have to be <= the current dimensions.
+// No color space conversions are done, the filtering happens on whatever values are in the image
+FloatImage2D DownsampleImage(
+    const FloatImage2D& image, uint32_t newWidth, uint32_t newHeight, MipFilter filter, bool clampHorizontal, bool clampVertical );
+
 uint32_t CalculateNumMips( uint32_t width, uint32_t height );
 double FloatImageMSE( const FloatImage2D& img1, const FloatImage2D& img2, uint32_t channelsToCalc = 0b1111 );
 double MSEToPSNR( double mse, double maxValue = 1.0 );
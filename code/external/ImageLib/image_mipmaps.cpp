@@ -0,0 +1,385 @@
+#include "image.hpp"
+#include "shared/assert.hpp"
+#include "shared/color_spaces.hpp"
+#include "shared/math_base.hpp"
+#include <cmath>
+#include <vector>
+
+// Output tiles are filtered independently: first horizontally for every source row the tile's vertical taps touch, into a
+// small scratch buffer, and then vertically straight into the output. Sized so the scratch buffer stays in L2
+static constexpr uint32_t TILE_SIZE           = 64;
+static constexpr uint32_t VERTICAL_CHUNK_SIZE = 16;
+
+static constexpr float KAISER_RADIUS  = 3.0f;
+static constexpr float KAISER_ALPHA   = 4.0f;
+static constexpr float LANCZOS_RADIUS = 3.0f;
+
+static float Sinc( float x )
+{
+    if ( std::abs( x ) < 1e-5f )
+        return 1.0f;
+
+    x *= PI;
+    return std::sin( x ) / x;
+}
+
+// Zeroth order modified bessel function of the first kind, via its power series
+static float BesselI0( float x )
+{
+    float sum  = 1.0f;
+    float term = 1.0f;
+    for ( int k = 1; k < 32 && term > 1e-7f * sum; ++k )
+    {
+        float t = x / ( 2.0f * k );
+        term *= t * t;
+        sum += term;
+    }
+
+    return sum;
+}
+
+static float FilterRadius( MipFilter filter )
+{
+    switch ( filter )
+    {
+    case MipFilter::BOX: return 0.5f;
+    case MipFilter::KAISER: return KAISER_RADIUS;
+    case MipFilter::LANCZOS: return LANCZOS_RADIUS;
+    default: return 0.5f;
+    }
+}
+
+// x is in destination texels
+static float EvaluateFilter( MipFilter filter, float x )
+{
+    if ( filter == MipFilter::KAISER )
+    {
+        float t = x / KAISER_RADIUS;
+        if ( t * t >= 1.0f )
+            return 0;
+
+        return Sinc( x ) * BesselI0( KAISER_ALPHA * std::sqrt( 1.0f - t * t ) ) / BesselI0( KAISER_ALPHA );
+    }
+    else // LANCZOS
+    {
+        if ( std::abs( x ) >= LANCZOS_RADIUS )
+            return 0;
+
+        return Sinc( x ) * Sinc( x / LANCZOS_RADIUS );
+    }
+}
+
+static int ResolveEdge( int index, int size, bool clamp )
+{
+    if ( clamp )
+        return Clamp( index, 0, size - 1 );
+
+    return ( ( index % size ) + size ) % size;
+}
+
+// The taps for each destination texel along one axis. They are always numTaps contiguous source texels starting at
+// firstTap[i], padded with 0 weights. The indices are resolved according to the edge mode ahead of time. Destination
+// texels in [interiorBegin, interiorEnd) don't touch the edges at all, so their taps can be read straight from firstTap
+struct AxisFilter
+{
+    uint32_t numTaps       = 0;
+    uint32_t interiorBegin = 0;
+    uint32_t interiorEnd   = 0;
+    std::vector<int> firstTap;
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+};
+
+static AxisFilter CreateAxisFilter( uint32_t srcSize, uint32_t dstSize, MipFilter filter, bool clamp )
+{
+    AxisFilter axis;
+    axis.firstTap.resize( dstSize );
+    if ( srcSize == dstSize )
+    {
+        axis.numTaps     = 1;
+        axis.interiorEnd = dstSize;
+        axis.indices.resize( dstSize );
+        axis.weights.resize( dstSize, 1.0f );
+        for ( uint32_t i = 0; i < dstSize; ++i )
+        {
+            axis.firstTap[i] = i;
+            axis.indices[i]  = i;
+        }
+
+        return axis;
+    }
+
+    const float scale  = srcSize / (float)dstSize;
+    const float radius = FilterRadius( filter ) * scale;
+    std::vector<int> lastTap( dstSize );
+    for ( uint32_t i = 0; i < dstSize; ++i )
+    {
+        float center     = ( i + 0.5f ) * scale;
+        axis.firstTap[i] = (int)std::floor( center - radius );
+        lastTap[i]       = (int)std::ceil( center + radius ) - 1;
+        axis.numTaps     = Max( axis.numTaps, (uint32_t)( lastTap[i] - axis.firstTap[i] + 1 ) );
+    }
+    for ( uint32_t i = 0; i < dstSize; ++i )
+    {
+        if ( axis.firstTap[i] < 0 )
+            axis.interiorBegin = i + 1;
+        else if ( axis.firstTap[i] + axis.numTaps <= srcSize )
+            axis.interiorEnd = i + 1;
+    }
+    axis.interiorEnd = Max( axis.interiorBegin, axis.interiorEnd );
+
+    axis.indices.resize( dstSize * axis.numTaps );
+    axis.weights.resize( dstSize * axis.numTaps, 0.0f );
+    for ( uint32_t i = 0; i < dstSize; ++i )
+    {
+        float center = ( i + 0.5f ) * scale;
+        float* w     = &axis.weights[i * axis.numTaps];
+        float sum    = 0;
+        for ( uint32_t t = 0; t < axis.numTaps; ++t )
+        {
+            int srcIndex                       = axis.firstTap[i] + (int)t;
+            axis.indices[i * axis.numTaps + t] = ResolveEdge( srcIndex, srcSize, clamp );
+            if ( srcIndex > lastTap[i] )
+                continue;
+
+            if ( filter == MipFilter::BOX )
+            {
+                // exact area coverage, so that odd sized images still average correctly
+                float lo = Max( (float)srcIndex, center - 0.5f * scale );
+                float hi = Min( (float)srcIndex + 1.0f, center + 0.5f * scale );
+                w[t]     = Max( 0.0f, hi - lo );
+            }
+            else
+            {
+                w[t] = EvaluateFilter( filter, ( srcIndex + 0.5f - center ) / scale );
+            }
+            sum += w[t];
+        }
+
+        for ( uint32_t t = 0; t < axis.numTaps; ++t )
+            w[t] /= sum;
+    }
+
+    return axis;
+}
+
+// Written out per channel instead of as a loop, so that the compiler keeps sum in registers and vectorizes it
+template <uint32_t NC>
+static inline void AccumulateTexel( float* sum, const float* p, float w )
+{
+    sum[0] += w * p[0];
+    if constexpr ( NC > 1 )
+        sum[1] += w * p[1];
+    if constexpr ( NC > 2 )
+        sum[2] += w * p[2];
+    if constexpr ( NC > 3 )
+        sum[3] += w * p[3];
+}
+
+template <uint32_t NC>
+static void FilterRowHorizontal( const float* src, float* dst, uint32_t dstX0, uint32_t dstX1, const AxisFilter& axis )
+{
+    const uint32_t numTaps = axis.numTaps;
+    for ( uint32_t x = dstX0; x < dstX1; ++x )
+    {
+        const float* weights = &axis.weights[x * numTaps];
+        float sum[NC]        = {};
+        if ( x >= axis.interiorBegin && x < axis.interiorEnd )
+        {
+            const float* p = src + NC * axis.firstTap[x];
+            for ( uint32_t t = 0; t < numTaps; ++t )
+                AccumulateTexel<NC>( sum, p + NC * t, weights[t] );
+        }
+        else
+        {
+            const uint32_t* indices = &axis.indices[x * numTaps];
+            for ( uint32_t t = 0; t < numTaps; ++t )
+                AccumulateTexel<NC>( sum, src + NC * indices[t], weights[t] );
+        }
+
+        for ( uint32_t c = 0; c < NC; ++c )
+            dst[NC * ( x - dstX0 ) + c] = sum[c];
+    }
+}
+
+template <uint32_t NC>
+static void DownsampleTile( const FloatImage2D& src, FloatImage2D& dst, uint32_t tileX, uint32_t tileY, const AxisFilter& hFilter,
+    const AxisFilter& vFilter, bool clampVertical, std::vector<float>& scratch )
+{
+    const uint32_t x0 = tileX * TILE_SIZE;
+    const uint32_t x1 = Min( x0 + TILE_SIZE, dst.width );
+    const uint32_t y0 = tileY * TILE_SIZE;
+    const uint32_t y1 = Min( y0 + TILE_SIZE, dst.height );
+
+    // The vertical taps are contiguous and monotonic, so this is the full range of source rows needed by the tile.
+    // Rows before/after the image (wrap or clamp) get their own scratch rows too, so they can just be indexed linearly
+    const int firstSrcRow      = vFilter.firstTap[y0];
+    const int lastSrcRow       = vFilter.firstTap[y1 - 1] + (int)vFilter.numTaps - 1;
+    const uint32_t scratchRows = lastSrcRow - firstSrcRow + 1;
+    const uint32_t rowFloats   = NC * ( x1 - x0 );
+    scratch.resize( scratchRows * rowFloats );
+    for ( uint32_t r = 0; r < scratchRows; ++r )
+    {
+        uint32_t srcRow  = ResolveEdge( firstSrcRow + (int)r, src.height, clampVertical );
+        const float* row = &src.data[srcRow * src.width * NC];
+        FilterRowHorizontal<NC>( row, &scratch[r * rowFloats], x0, x1, hFilter );
+    }
+
+    // Accumulating fixed size chunks in a local array, instead of directly into the output row, means there is no
+    // aliasing or loop remainder for the compiler to worry about, so it vectorizes even without -O3
+    const uint32_t numTaps = vFilter.numTaps;
+    for ( uint32_t y = y0; y < y1; ++y )
+    {
+        float* out           = &dst.data[( y * dst.width + x0 ) * NC];
+        const float* weights = &vFilter.weights[y * numTaps];
+        const float* first   = &scratch[( vFilter.firstTap[y] - firstSrcRow ) * rowFloats];
+        uint32_t i           = 0;
+        for ( ; i + VERTICAL_CHUNK_SIZE <= rowFloats; i += VERTICAL_CHUNK_SIZE )
+        {
+            float acc[VERTICAL_CHUNK_SIZE] = {};
+            for ( uint32_t t = 0; t < numTaps; ++t )
+            {
+                const float w   = weights[t];
+                const float* in = first + t * rowFloats + i;
+                for ( uint32_t k = 0; k < VERTICAL_CHUNK_SIZE; ++k )
+                    acc[k] += w * in[k];
+            }
+            for ( uint32_t k = 0; k < VERTICAL_CHUNK_SIZE; ++k )
+                out[i + k] = acc[k];
+        }
+
+        for ( ; i < rowFloats; ++i )
+        {
+            float acc = 0;
+            for ( uint32_t t = 0; t < numTaps; ++t )
+                acc += weights[t] * first[t * rowFloats + i];
+            out[i] = acc;
+        }
+    }
+}
+
+template <uint32_t NC>
+static void DownsampleImageInternal( const FloatImage2D& src, FloatImage2D& dst, MipFilter filter, bool clampH, bool clampV )
+{
+    const AxisFilter hFilter = CreateAxisFilter( src.width, dst.width, filter, clampH );
+    const AxisFilter vFilter = CreateAxisFilter( src.height, dst.height, filter, clampV );
+    const uint32_t tilesX    = ( dst.width + TILE_SIZE - 1 ) / TILE_SIZE;
+    const uint32_t tilesY    = ( dst.height + TILE_SIZE - 1 ) / TILE_SIZE;
+#pragma omp parallel
+    {
+        std::vector<float> scratch;
+#pragma omp for schedule( dynamic )
+        for ( int tileIdx = 0; tileIdx < (int)( tilesX * tilesY ); ++tileIdx )
+        {
+            DownsampleTile<NC>( src, dst, tileIdx % tilesX, tileIdx / tilesX, hFilter, vFilter, clampV, scratch );
+        }
+    }
+}
+
+FloatImage2D DownsampleImage(
+    const FloatImage2D& image, uint32_t newWidth, uint32_t newHeight, MipFilter filter, bool clampHorizontal, bool clampVertical )
+{
+    PG_ASSERT( newWidth && newHeight && newWidth <= image.width && newHeight <= image.height );
+    FloatImage2D output( newWidth, newHeight, image.numChannels );
+    switch ( image.numChannels )
+    {
+    case 1: DownsampleImageInternal<1>( image, output, filter, clampHorizontal, clampVertical ); break;
+    case 2: DownsampleImageInternal<2>( image, output, filter, clampHorizontal, clampVertical ); break;
+    case 3: DownsampleImageInternal<3>( image, output, filter, clampHorizontal, clampVertical ); break;
+    case 4: DownsampleImageInternal<4>( image, output, filter, clampHorizontal, clampVertical ); break;
+    default: PG_ASSERT( false, "Invalid number of channels %u", image.numChannels ); return {};
+    }
+
+    return output;
+}
+
+// Alpha is only treated as linear coverage for 4 channel images. Otherwise every channel is color
+static void ConvertColorSpace( FloatImage2D& image, bool toLinear )
+{
+    const uint32_t numColorChannels = image.numChannels == 4 ? 3 : image.numChannels;
+    const int numPixels             = (int)( image.width * image.height );
+#pragma omp parallel for
+    for ( int i = 0; i < numPixels; ++i )
+    {
+        float* p = &image.data[i * image.numChannels];
+        for ( uint32_t c = 0; c < numColorChannels; ++c )
+            p[c] = toLinear ? PG::GammaSRGBToLinear( p[c] ) : PG::LinearToGammaSRGB( p[c] );
+    }
+}
+
+static float AlphaCoverage( const FloatImage2D& image, float alphaRef, float alphaScale )
+{
+    const int numPixels = (int)( image.width * image.height );
+    int covered         = 0;
+#pragma omp parallel for reduction( + : covered )
+    for ( int i = 0; i < numPixels; ++i )
+    {
+        if ( image.data[4 * i + 3] * alphaScale >= alphaRef )
+            ++covered;
+    }
+
+    return covered / (float)numPixels;
+}
+
+// Binary searches for the alpha scale that gets the mip's coverage closest to the top mip's, like in
+// "Computing Alpha Mipmaps" (Castano)
+static void ScaleAlphaToCoverage( FloatImage2D& image, float alphaRef, float targetCoverage )
+{
+    float lo = 0.0f;
+    float hi = 4.0f;
+    for ( int i = 0; i < 12; ++i )
+    {
+        float mid = 0.5f * ( lo + hi );
+        if ( AlphaCoverage( image, alphaRef, mid ) < targetCoverage )
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    const float alphaScale = 0.5f * ( lo + hi );
+    const int numPixels    = (int)( image.width * image.height );
+    for ( int i = 0; i < numPixels; ++i )
+        image.data[4 * i + 3] = Min( 1.0f, image.data[4 * i + 3] * alphaScale );
+}
+
+std::vector<FloatImage2D> GenerateMipmaps( const FloatImage2D& image, const MipmapGenerationSettings& settings )
+{
+    uint32_t numMips = CalculateNumMips( image.width, image.height );
+    if ( numMips == 0 )
+        return {};
+
+    std::vector<FloatImage2D> mips( numMips );
+    mips[0] = image.Clone();
+
+    const bool preserveCoverage = settings.preserveAlphaCoverage && image.numChannels == 4;
+    const bool needsPostProcess = settings.srgb || preserveCoverage;
+    const float targetCoverage  = preserveCoverage ? AlphaCoverage( image, settings.alphaCoverageRef, 1.0f ) : 0.0f;
+
+    // Each mip is filtered from the previous one, in linear space and before the alpha scaling. When neither is needed,
+    // the filtered mips are the final ones and don't need any extra copies
+    FloatImage2D prevMip = mips[0];
+    if ( settings.srgb )
+    {
+        prevMip = image.Clone();
+        ConvertColorSpace( prevMip, true );
+    }
+
+    uint32_t w = image.width;
+    uint32_t h = image.height;
+    for ( uint32_t mipLevel = 1; mipLevel < numMips; ++mipLevel )
+    {
+        w = Max( 1u, w >> 1 );
+        h = Max( 1u, h >> 1 );
+
+        FloatImage2D filtered = DownsampleImage( prevMip, w, h, settings.filter, settings.clampHorizontal, settings.clampVertical );
+        mips[mipLevel]        = needsPostProcess ? filtered.Clone() : filtered;
+        if ( settings.srgb )
+            ConvertColorSpace( mips[mipLevel], false );
+        if ( preserveCoverage )
+            ScaleAlphaToCoverage( mips[mipLevel], settings.alphaCoverageRef, targetCoverage );
+
+        prevMip = filtered;
+    }
+
+    return mips;
+}
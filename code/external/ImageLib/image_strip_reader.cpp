@@ -0,0 +1,237 @@
+#include "image_strip_reader.hpp"
+#include "shared/filesystem.hpp"
+#include "shared/logger.hpp"
+#include "stb/stb_image.h"
+#include "tiffio.h"
+#include "tinyexr/tinyexr.h"
+#include <algorithm>
+#include <cstring>
+
+ImageStripReader::~ImageStripReader() { Close(); }
+
+bool ImageStripReader::Open( const std::string& filename, ImageLoadFlags loadFlags )
+{
+    Close();
+    m_filename  = filename;
+    m_loadFlags = loadFlags;
+    if ( IsImageFilenameBuiltin( filename ) )
+    {
+        if ( !m_fullImage.Load( filename, loadFlags ) )
+            return false;
+
+        m_width  = m_fullImage.width;
+        m_height = m_fullImage.height;
+        m_format = m_fullImage.format;
+        return true;
+    }
+
+    std::string ext = GetFileExtension( filename );
+    if ( ext == ".tif" || ext == ".tiff" )
+        return OpenTiff();
+
+    if ( ext == ".exr" )
+    {
+        // Not streamed, ReadRows decodes the whole image with RawImage2D::Load. This just gets its size and format up front:
+        // LoadEXR always returns RGBA floats for the data window
+        EXRVersion version;
+        EXRHeader header;
+        InitEXRHeader( &header );
+        const char* err = nullptr;
+        if ( ParseEXRVersionFromFile( &version, filename.c_str() ) != TINYEXR_SUCCESS ||
+             ParseEXRHeaderFromFile( &header, &version, filename.c_str(), &err ) != TINYEXR_SUCCESS )
+        {
+            LOG_ERR( "ImageStripReader: could not parse the EXR header of '%s'", filename.c_str() );
+            if ( err )
+            {
+                LOG_ERR( "\tTinyexr error '%s'", err );
+                FreeEXRErrorMessage( err );
+            }
+            return false;
+        }
+        m_width  = header.data_window.max_x - header.data_window.min_x + 1;
+        m_height = header.data_window.max_y - header.data_window.min_y + 1;
+        m_format = ImageFormat::R32_G32_B32_A32_FLOAT;
+        FreeEXRHeader( &header );
+        return true;
+    }
+
+    FILE* file = fopen( filename.c_str(), "rb" );
+    if ( file == NULL )
+    {
+        LOG_ERR( "ImageStripReader: Could not open file '%s'", filename.c_str() );
+        return false;
+    }
+
+    // Same formats that RawImage2D::Load picks for stb images
+    int w, h, numChannels;
+    bool success = stbi_info_from_file( file, &w, &h, &numChannels );
+    if ( success )
+    {
+        ImageFormat startFormat = ImageFormat::R8_UNORM;
+        if ( ext == ".hdr" )
+            startFormat = ImageFormat::R32_FLOAT;
+        else if ( stbi_is_16_bit_from_file( file ) )
+            startFormat = ImageFormat::R16_UNORM;
+
+        m_width  = static_cast<uint32_t>( w );
+        m_height = static_cast<uint32_t>( h );
+        m_format = static_cast<ImageFormat>( Underlying( startFormat ) + numChannels - 1 );
+    }
+    else
+    {
+        LOG_ERR( "ImageStripReader: could not read the header of '%s'", filename.c_str() );
+    }
+    fclose( file );
+
+    return success;
+}
+
+bool ImageStripReader::OpenTiff()
+{
+    m_tif = TIFFOpen( m_filename.c_str(), "rb" );
+    if ( !m_tif )
+    {
+        LOG_ERR( "ImageStripReader: could not open TIF '%s'", m_filename.c_str() );
+        return false;
+    }
+
+    uint16_t config;
+    TIFFGetFieldDefaulted( m_tif, TIFFTAG_PLANARCONFIG, &config );
+    if ( config != PLANARCONFIG_CONTIG )
+    {
+        LOG_ERR( "Separate planar TIF images not currently supported (image '%s')", m_filename.c_str() );
+        Close();
+        return false;
+    }
+
+    uint16_t numChannels, numBitsPerChannel;
+    TIFFGetFieldDefaulted( m_tif, TIFFTAG_SAMPLESPERPIXEL, &numChannels );
+    TIFFGetFieldDefaulted( m_tif, TIFFTAG_BITSPERSAMPLE, &numBitsPerChannel );
+    if ( numBitsPerChannel != 8 && numBitsPerChannel != 16 && numBitsPerChannel != 32 )
+    {
+        LOG_ERR( "%u bit TIF images not currently supported (image '%s')", numBitsPerChannel, m_filename.c_str() );
+        Close();
+        return false;
+    }
+
+    TIFFGetField( m_tif, TIFFTAG_IMAGEWIDTH, &m_width );
+    TIFFGetField( m_tif, TIFFTAG_IMAGELENGTH, &m_height );
+
+    ImageFormat format = ImageFormat::R8_UNORM;
+    if ( numBitsPerChannel == 16 )
+        format = ImageFormat::R16_UNORM;
+    else if ( numBitsPerChannel == 32 )
+        format = ImageFormat::R32_FLOAT;
+    m_format = static_cast<ImageFormat>( Underlying( format ) + numChannels - 1 );
+
+    m_tiled = TIFFIsTiled( m_tif );
+    if ( m_tiled )
+    {
+        TIFFGetField( m_tif, TIFFTAG_TILEWIDTH, &m_tileWidth );
+        TIFFGetField( m_tif, TIFFTAG_TILELENGTH, &m_rowsPerBand );
+        m_tileData.resize( TIFFTileSize( m_tif ) );
+    }
+    else
+    {
+        TIFFGetFieldDefaulted( m_tif, TIFFTAG_ROWSPERSTRIP, &m_rowsPerBand );
+        m_rowsPerBand = std::min( m_rowsPerBand, m_height );
+    }
+    m_bandData.resize( m_rowsPerBand * BytesPerRow() );
+
+    return true;
+}
+
+void ImageStripReader::Close()
+{
+    if ( m_tif )
+    {
+        TIFFClose( m_tif );
+        m_tif = nullptr;
+    }
+    m_fullImage   = {};
+    m_currentBand = UINT32_MAX;
+    m_bandData    = {};
+    m_tileData    = {};
+}
+
+bool ImageStripReader::LoadTiffBand( uint32_t band )
+{
+    if ( band == m_currentBand )
+        return true;
+
+    m_currentBand = UINT32_MAX;
+    if ( !m_tiled )
+    {
+        if ( TIFFReadEncodedStrip( m_tif, band, m_bandData.data(), (tsize_t)-1 ) == -1 )
+        {
+            LOG_ERR( "TIFFReadEncodedStrip error while processing TIF '%s'", m_filename.c_str() );
+            return false;
+        }
+        m_currentBand = band;
+        return true;
+    }
+
+    // Edge tiles are still full sized in the file, they just get cropped here
+    const uint32_t bytesPerPixel = ::BitsPerPixel( m_format ) / 8;
+    const uint32_t firstRow      = band * m_rowsPerBand;
+    const uint32_t numRows       = std::min( m_rowsPerBand, m_height - firstRow );
+    const size_t bytesPerRow     = BytesPerRow();
+    for ( uint32_t x = 0; x < m_width; x += m_tileWidth )
+    {
+        ttile_t tile = TIFFComputeTile( m_tif, x, firstRow, 0, 0 );
+        if ( TIFFReadEncodedTile( m_tif, tile, m_tileData.data(), (tsize_t)-1 ) == -1 )
+        {
+            LOG_ERR( "TIFFReadEncodedTile error while processing TIF '%s'", m_filename.c_str() );
+            return false;
+        }
+
+        const size_t bytesToCopy = std::min( m_tileWidth, m_width - x ) * bytesPerPixel;
+        for ( uint32_t r = 0; r < numRows; ++r )
+        {
+            memcpy( &m_bandData[r * bytesPerRow + x * bytesPerPixel], &m_tileData[r * m_tileWidth * bytesPerPixel], bytesToCopy );
+        }
+    }
+    m_currentBand = band;
+
+    return true;
+}
+
+bool ImageStripReader::ReadRows( uint32_t firstRow, uint32_t numRows, uint8_t* dst )
+{
+    if ( firstRow + numRows > m_height )
+    {
+        LOG_ERR( "ImageStripReader: rows [%u, %u) are out of range for '%s'", firstRow, firstRow + numRows, m_filename.c_str() );
+        return false;
+    }
+
+    const size_t bytesPerRow = BytesPerRow();
+    if ( !m_tif )
+    {
+        if ( !m_fullImage.data && !m_fullImage.Load( m_filename, m_loadFlags ) )
+            return false;
+
+        memcpy( dst, m_fullImage.Raw() + firstRow * bytesPerRow, numRows * bytesPerRow );
+        return true;
+    }
+
+    const bool flip = IsSet( m_loadFlags, ImageLoadFlags::FLIP_VERTICALLY );
+    for ( uint32_t row = firstRow; row < firstRow + numRows; ++row )
+    {
+        uint32_t fileRow = flip ? m_height - row - 1 : row;
+        if ( !LoadTiffBand( fileRow / m_rowsPerBand ) )
+            return false;
+
+        memcpy( dst + ( row - firstRow ) * bytesPerRow, &m_bandData[( fileRow % m_rowsPerBand ) * bytesPerRow], bytesPerRow );
+    }
+
+    return true;
+}
+
+RawImage2D ImageStripReader::ReadRows( uint32_t firstRow, uint32_t numRows )
+{
+    RawImage2D rows( m_width, numRows, m_format );
+    if ( !ReadRows( firstRow, numRows, rows.Raw() ) )
+        return {};
+
+    return rows;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "image.hpp"
+
+struct tiff;
+
+// Reads an image a band of rows at a time, so that huge source images don't need to be fully decoded in memory.
+// Only TIFFs are actually streamed: striped and tiled TIFFs are decoded incrementally, keeping only the strip (or row of
+// tiles) with the current rows around. Neither tinyexr nor stb_image can decode part of an image, so EXRs, every stb format
+// and the builtin images fall back to decoding the whole image on the first ReadRows, and copying rows out of that. They
+// take as much memory as RawImage2D::Load, so huge sources should be TIFFs.
+// Open only reads the headers either way. Rows are returned in the file's format, with the same orientation that
+// RawImage2D::Load would give for the same load flags
+class ImageStripReader
+{
+public:
+    ImageStripReader() = default;
+    ~ImageStripReader();
+
+    ImageStripReader( const ImageStripReader& )            = delete;
+    ImageStripReader& operator=( const ImageStripReader& ) = delete;
+
+    bool Open( const std::string& filename, ImageLoadFlags loadFlags = ImageLoadFlags::DEFAULT );
+    // Frees the decoded strip, or fully decoded image
+    void Close();
+
+    // dst needs to be at least numRows * BytesPerRow() bytes
+    bool ReadRows( uint32_t firstRow, uint32_t numRows, uint8_t* dst );
+    // Returns a width x numRows image of just those rows, or an empty image on failure
+    RawImage2D ReadRows( uint32_t firstRow, uint32_t numRows );
+
+    uint32_t Width() const { return m_width; }
+    uint32_t Height() const { return m_height; }
+    ImageFormat Format() const { return m_format; }
+    size_t BytesPerRow() const { return m_width * ::BitsPerPixel( m_format ) / 8; }
+    // False if the whole image has to be decoded at once
+    bool IsStreaming() const { return m_tif != nullptr; }
+
+private:
+    bool OpenTiff();
+    bool LoadTiffBand( uint32_t band );
+
+    std::string m_filename;
+    ImageLoadFlags m_loadFlags = ImageLoadFlags::DEFAULT;
+    uint32_t m_width           = 0;
+    uint32_t m_height          = 0;
+    ImageFormat m_format       = ImageFormat::INVALID;
+
+    // Fallback for non streamable formats, loaded with RawImage2D::Load on the first ReadRows
+    RawImage2D m_fullImage;
+
+    tiff* m_tif            = nullptr;
+    bool m_tiled           = false;
+    uint32_t m_rowsPerBand = 0; // rows per strip, or the tile height
+    uint32_t m_tileWidth   = 0;
+    uint32_t m_currentBand = UINT32_MAX;
+    std::vector<uint8_t> m_bandData;
+    std::vector<uint8_t> m_tileData;
+};
@@ -82,19 +82,23 @@ FloatImageCubemap EquirectangularToCubemap( const FloatImage2D& equiImg )
     cubemap.size        = Max( 1u, equiImg.width / 4u );
     cubemap.numChannels = equiImg.numChannels;
     for ( uint32_t i = 0; i < 6; ++i )
-    {
         cubemap.faces[i] = FloatImage2D( cubemap.size, cubemap.size, cubemap.numChannels );
 
+    // one parallel loop over the rows of all the faces, instead of one per face
+    const uint32_t numChannels = cubemap.numChannels;
 #pragma omp parallel for
-        for ( int r = 0; r < (int)cubemap.size; ++r )
+    for ( int faceRow = 0; faceRow < 6 * (int)cubemap.size; ++faceRow )
+    {
+        const int faceIdx = faceRow / cubemap.size;
+        const int r       = faceRow % cubemap.size;
+        float* dst        = &cubemap.faces[faceIdx].data[r * cubemap.size * numChannels];
+        for ( int c = 0; c < (int)cubemap.size; ++c )
         {
-            for ( int c = 0; c < (int)cubemap.size; ++c )
-            {
-                vec2 localUV = { ( c + 0.5f ) / (float)cubemap.size, ( r + 0.5f ) / (float)cubemap.size };
-                vec3 dir     = CubemapFaceUVToDirection( i, localUV );
-                vec2 equiUV  = DirectionToEquirectangularUV( dir );
-                cubemap.faces[i].SetFromFloat4( r, c, equiImg.Sample( equiUV, true, true ) );
-            }
+            vec2 localUV = { ( c + 0.5f ) / (float)cubemap.size, ( r + 0.5f ) / (float)cubemap.size };
+            vec3 dir     = CubemapFaceUVToDirection( faceIdx, localUV );
+            vec4 pixel   = equiImg.Sample( DirectionToEquirectangularUV( dir ), true, true );
+            for ( uint32_t chan = 0; chan < numChannels; ++chan )
+                dst[c * numChannels + chan] = pixel[chan];
         }
     }
 
@@ -107,16 +111,93 @@ FloatImage2D CubemapToEquirectangular( const FloatImageCubemap& cubemap )
 #pragma omp parallel for
     for ( int r = 0; r < (int)equiImg.height; ++r )
     {
+        const uint32_t numChannels = equiImg.numChannels;
+        float* dst                 = &equiImg.data[r * equiImg.width * numChannels];
         for ( int c = 0; c < (int)equiImg.width; ++c )
         {
             vec2 equiUV = { ( c + 0.5f ) / (float)equiImg.width, ( r + 0.5f ) / (float)equiImg.height };
             vec3 dir    = EquirectangularUVToDirection( equiUV );
-            vec2 newUV  = DirectionToEquirectangularUV( dir );
+#if USING( DEVELOPMENT_BUILD )
+            vec2 newUV = DirectionToEquirectangularUV( dir );
             PG_ASSERT( r == static_cast<int>( newUV.y * equiImg.height ) );
             PG_ASSERT( c == static_cast<int>( newUV.x * equiImg.width ) );
-            equiImg.SetFromFloat4( r, c, cubemap.Sample( dir ) );
+#endif // #if USING( DEVELOPMENT_BUILD )
+            vec4 pixel = cubemap.Sample( dir );
+            for ( uint32_t chan = 0; chan < numChannels; ++chan )
+                dst[c * numChannels + chan] = pixel[chan];
         }
     }
 
     return equiImg;
 }
+
+static void EvaluateSH9Basis( const vec3& dir, float basis[9] )
+{
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * dir.y;
+    basis[2] = 0.488603f * dir.z;
+    basis[3] = 0.488603f * dir.x;
+    basis[4] = 1.092548f * dir.x * dir.y;
+    basis[5] = 1.092548f * dir.y * dir.z;
+    basis[6] = 0.315392f * ( 3.0f * dir.z * dir.z - 1.0f );
+    basis[7] = 1.092548f * dir.x * dir.z;
+    basis[8] = 0.546274f * ( dir.x * dir.x - dir.y * dir.y );
+}
+
+SH9Color ProjectCubemapToSH9( const FloatImageCubemap& cubemap )
+{
+    SH9Color sh           = {};
+    double totalWeight    = 0;
+    const float texelSize = 2.0f / cubemap.size;
+    for ( int faceIdx = 0; faceIdx < 6; ++faceIdx )
+    {
+        for ( int r = 0; r < (int)cubemap.size; ++r )
+        {
+            for ( int c = 0; c < (int)cubemap.size; ++c )
+            {
+                // solid angle of the texel, for a face spanning [-1, 1]: dA / (1 + u^2 + v^2)^(3/2)
+                vec2 localUV = { ( c + 0.5f ) / (float)cubemap.size, ( r + 0.5f ) / (float)cubemap.size };
+                vec2 st      = 2.0f * localUV - vec2( 1.0f );
+                float tmp    = 1.0f + st.x * st.x + st.y * st.y;
+                float weight = texelSize * texelSize / ( tmp * sqrtf( tmp ) );
+
+                float basis[9];
+                EvaluateSH9Basis( CubemapFaceUVToDirection( faceIdx, localUV ), basis );
+                vec3 radiance = vec3( cubemap.faces[faceIdx].GetFloat4( r, c ) );
+                for ( int i = 0; i < 9; ++i )
+                    sh.coeffs[i] += ( weight * basis[i] ) * radiance;
+                totalWeight += weight;
+            }
+        }
+    }
+
+    // the texel solid angles only approximately sum to 4pi, so normalize them
+    const float normalization = static_cast<float>( 4.0 * PI / totalWeight );
+    for ( int i = 0; i < 9; ++i )
+        sh.coeffs[i] *= normalization;
+
+    return sh;
+}
+
+SH9Color ConvolveSH9WithCosineLobe( const SH9Color& sh )
+{
+    // Ramamoorthi and Hanrahan's A_l (pi, 2pi/3, pi/4), already divided by pi
+    // https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf
+    constexpr float bandScales[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    SH9Color convolved;
+    for ( int i = 0; i < 9; ++i )
+        convolved.coeffs[i] = bandScales[i] * sh.coeffs[i];
+
+    return convolved;
+}
+
+vec3 EvaluateSH9( const SH9Color& sh, const vec3& dir )
+{
+    float basis[9];
+    EvaluateSH9Basis( dir, basis );
+    vec3 result( 0 );
+    for ( int i = 0; i < 9; ++i )
+        result += basis[i] * sh.coeffs[i];
+
+    return result;
+}
@@ -9,3 +9,7 @@ vec3 EquirectangularUVToDirection( const vec2& uv );
 
 FloatImageCubemap EquirectangularToCubemap( const FloatImage2D& equiImg );
 FloatImage2D CubemapToEquirectangular( const FloatImageCubemap& cubemap );
+
+SH9Color ProjectCubemapToSH9( const FloatImageCubemap& cubemap );
+SH9Color ConvolveSH9WithCosineLobe( const SH9Color& sh );
+vec3 EvaluateSH9( const SH9Color& sh, const vec3& dir );
@@ -0,0 +1,408 @@
+#include "ImageLib/bc_compression.hpp"
+#include "getopt/getopt.h"
+#include "lz4/lz4hc.h"
+#include "shared/logger.hpp"
+#include "shared/lz4_compressor.hpp"
+#include "shared/random.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <omp.h>
+
+using namespace PG;
+
+static void DisplayHelp()
+{
+    auto msg =
+        "Usage: bc_benchmark [options]\n"
+        "Compresses a synthetic set of textures the same way the converter does, with one omp thread per texture, and reports the "
+        "wall time. Both with the shared compression task pool, and with the old per image omp parallel fors. No external assets are "
+        "needed\n"
+        "Options\n"
+        "  --help         Print this message and exit\n"
+        "  --image        Image to use for the RDO report instead of a synthetic one, and to add to the --report corpus\n"
+        "  --large        Number of large textures. Default: 3\n"
+        "  --largesize    Width and height of the large textures. Default: 8192\n"
+        "  --rdo          RDO lambda to report the BC1 and BC7 bits per texel (before and after LZ4) and PSNR for, next to\n"
+        "                 the same image without RDO. 0 skips the report. Default: 0\n"
+        "  --report       Instead of the benchmark above, compress a fixed corpus of synthetic images with every BC format\n"
+        "                 and quality level, and report the speed and the MSE + PSNR of each channel\n"
+        "  --small        Number of small textures. Default: 200\n"
+        "  --smallsize    Width and height of the small textures. Default: 256\n"
+        "\n";
+
+    LOG( "%s", msg );
+}
+
+struct BenchmarkSettings
+{
+    u32 numLarge  = 3;
+    u32 largeSize = 8192;
+    u32 numSmall  = 200;
+    u32 smallSize = 256;
+    f32 rdoLambda = 0.0f;
+    std::string inputImage;
+    bool qualityReport = false;
+};
+
+static bool ParseCommandLineArgs( int argc, char** argv, BenchmarkSettings& settings )
+{
+    static struct option long_options[] = {
+        {"help",      no_argument,       0, 'h'},
+        {"image",     required_argument, 0, 'i'},
+        {"large",     required_argument, 0, 'l'},
+        {"largesize", required_argument, 0, 'L'},
+        {"rdo",       required_argument, 0, 'r'},
+        {"report",    no_argument,       0, 'R'},
+        {"small",     required_argument, 0, 's'},
+        {"smallsize", required_argument, 0, 'S'},
+        {0,           0,                 0, 0  }
+    };
+
+    i32 option_index = 0;
+    i32 c            = -1;
+    while ( ( c = getopt_long( argc, argv, "hi:l:L:r:Rs:S:", long_options, &option_index ) ) != -1 )
+    {
+        switch ( c )
+        {
+        case 'h': DisplayHelp(); return false;
+        case 'i': settings.inputImage = optarg; break;
+        case 'l': settings.numLarge = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 'L': settings.largeSize = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 'r': settings.rdoLambda = strtof( optarg, nullptr ); break;
+        case 'R': settings.qualityReport = true; break;
+        case 's': settings.numSmall = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 'S': settings.smallSize = (u32)strtoul( optarg, nullptr, 10 ); break;
+        default: LOG_ERR( "Invalid option, try 'bc_benchmark --help' for more information" ); return false;
+        }
+    }
+
+    if ( !settings.largeSize || !settings.smallSize )
+    {
+        LOG_ERR( "Texture sizes must be positive" );
+        return false;
+    }
+
+    return true;
+}
+
+// Smooth gradients with some noise on top, so that the compressors can't take any early outs for constant blocks
+static RawImage2D GenerateSyntheticImage( u32 width, u32 height, u64 seed )
+{
+    RawImage2D img( width, height, ImageFormat::R8_G8_B8_A8_UNORM );
+    Random::RNG rng( seed );
+    u8* pixels = img.Raw();
+    for ( u32 row = 0; row < height; ++row )
+    {
+        for ( u32 col = 0; col < width; ++col )
+        {
+            u32 noise = rng.UniformUInt32();
+            u8* pixel = pixels + 4 * ( row * width + col );
+            pixel[0]  = (u8)( 255 * col / width + ( noise & 0xF ) );
+            pixel[1]  = (u8)( 255 * row / height + ( ( noise >> 4 ) & 0xF ) );
+            pixel[2]  = (u8)( ( row ^ col ) + ( ( noise >> 8 ) & 0x1F ) );
+            pixel[3]  = (u8)( 128 + ( ( noise >> 16 ) & 0x3F ) );
+        }
+    }
+
+    return img;
+}
+
+// Compresses every texture from an outer omp loop, like ConvertAssets does. Returns the wall time in seconds
+static f64 TimeCompression(
+    const std::vector<std::vector<RawImage2D>>& textures, const BCCompressorSettings& compressorSettings, bool usePool )
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+#pragma omp parallel for schedule( dynamic )
+    for ( i32 i = 0; i < (i32)textures.size(); ++i )
+    {
+        std::vector<RawImage2D> compressedMips =
+            usePool ? CompressToBC( textures[i], compressorSettings ) : CompressToBCPerImage( textures[i], compressorSettings );
+    }
+
+    return std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - startTime ).count();
+}
+
+// The mips don't need to be real downsamples of each other, they just need the right sizes
+static std::vector<RawImage2D> GenerateSyntheticMips( u32 size, u64 seed )
+{
+    std::vector<RawImage2D> mips;
+    for ( u32 mipSize = size; mipSize >= 1; mipSize /= 2 )
+        mips.push_back( GenerateSyntheticImage( mipSize, mipSize, seed * 32 + mips.size() ) );
+
+    return mips;
+}
+
+// Size of the synthetic images that the RDO and quality reports use
+static constexpr u32 REPORT_IMAGE_SIZE = 1024;
+
+struct RDOStats
+{
+    f64 bitsPerTexel;
+    f64 lz4BitsPerTexel;
+    f64 lz4hcBitsPerTexel;
+    f64 psnr;
+};
+
+static f64 LZ4BitsPerTexel( const RawImage2D& compressed, bool highCompression )
+{
+    i32 compressedSize = 0;
+    const char* src    = reinterpret_cast<const char*>( compressed.Raw() );
+    char* lz4Data      = highCompression ? LZ4CompressBufferHC( src, compressed.TotalBytes(), LZ4HC_CLEVEL_DEFAULT, compressedSize )
+                                         : LZ4CompressBuffer( src, compressed.TotalBytes(), compressedSize );
+    free( lz4Data );
+
+    return 8.0 * compressedSize / ( (f64)compressed.width * compressed.height );
+}
+
+static RDOStats MeasureRDO( const RawImage2D& image, const FloatImage2D& floatImage, ImageFormat format, f32 rdoLambda )
+{
+    BCCompressorSettings compressorSettings( format, CompressionQuality::MEDIUM );
+    compressorSettings.rdoLambda = rdoLambda;
+    RawImage2D compressed        = CompressToBC( image, compressorSettings );
+
+    RDOStats stats;
+    stats.bitsPerTexel      = 8.0 * compressed.TotalBytes() / ( (f64)image.width * image.height );
+    stats.lz4BitsPerTexel   = LZ4BitsPerTexel( compressed, false );
+    stats.lz4hcBitsPerTexel = LZ4BitsPerTexel( compressed, true );
+
+    // BC1 has no alpha, so only compare RGB for it
+    FloatImage2D decompressed = FloatImageFromRawImage2D( DecompressBC( compressed ) );
+    stats.psnr = MSEToPSNR( FloatImageMSE( floatImage, decompressed, format == ImageFormat::BC1_UNORM ? 0b1110 : 0b1111 ) );
+
+    return stats;
+}
+
+static void LogRDOReport( const BenchmarkSettings& settings )
+{
+    RawImage2D image;
+    if ( settings.inputImage.empty() )
+    {
+        image = GenerateSyntheticImage( REPORT_IMAGE_SIZE, REPORT_IMAGE_SIZE, 0 );
+    }
+    else if ( !image.Load( settings.inputImage ) )
+    {
+        LOG_ERR( "Could not load the RDO report image '%s'", settings.inputImage.c_str() );
+        return;
+    }
+    image                         = image.Convert( ImageFormat::R8_G8_B8_A8_UNORM );
+    const FloatImage2D floatImage = FloatImageFromRawImage2D( image );
+
+    LOG( "RDO report for %s (%ux%u):", settings.inputImage.empty() ? "a synthetic image" : settings.inputImage.c_str(), image.width,
+        image.height );
+    for ( ImageFormat format : { ImageFormat::BC1_UNORM, ImageFormat::BC7_UNORM } )
+    {
+        const char* formatName = format == ImageFormat::BC1_UNORM ? "BC1" : "BC7";
+        const RDOStats base    = MeasureRDO( image, floatImage, format, 0.0f );
+        const RDOStats rdo     = MeasureRDO( image, floatImage, format, settings.rdoLambda );
+        for ( const RDOStats* stats : { &base, &rdo } )
+        {
+            LOG( "  %s, lambda %.2f: %.2f bits/texel, %.2f after LZ4, %.2f after LZ4HC. PSNR: %.2f dB", formatName,
+                stats == &base ? 0.0f : settings.rdoLambda, stats->bitsPerTexel, stats->lz4BitsPerTexel, stats->lz4hcBitsPerTexel,
+                stats->psnr );
+        }
+        LOG( "  %s RDO: LZ4HC size %.1f%% smaller, for %.2f dB less PSNR", formatName,
+            100.0 * ( 1.0 - rdo.lz4hcBitsPerTexel / base.lz4hcBitsPerTexel ), base.psnr - rdo.psnr );
+    }
+}
+
+// Low frequency shapes without any noise, like most painted or baked textures. Lets the encoders show how well they handle
+// smooth gradients, which is where the block artifacts are the most visible
+static RawImage2D GenerateSmoothImage( u32 width, u32 height )
+{
+    RawImage2D img( width, height, ImageFormat::R8_G8_B8_A8_UNORM );
+    for ( u32 row = 0; row < height; ++row )
+    {
+        for ( u32 col = 0; col < width; ++col )
+        {
+            const f32 u = col / (f32)width;
+            const f32 v = row / (f32)height;
+            vec4 pixel;
+            pixel.x = 0.5f + 0.5f * sinf( 6.0f * u + 2.0f * v );
+            pixel.y = 0.5f + 0.5f * cosf( 9.0f * v - 3.0f * u * v );
+            pixel.z = u * v;
+            pixel.w = 0.5f + 0.5f * sinf( 20.0f * ( u - 0.5f ) * ( v - 0.5f ) );
+            img.SetPixelFromFloat4( row, col, pixel );
+        }
+    }
+
+    return img;
+}
+
+// Tangent space normals of a bumpy height field, packed into [0, 1] like the converter packs normal maps, with a smooth roughness in alpha
+static RawImage2D GenerateNormalMapImage( u32 width, u32 height )
+{
+    RawImage2D img( width, height, ImageFormat::R8_G8_B8_A8_UNORM );
+    for ( u32 row = 0; row < height; ++row )
+    {
+        for ( u32 col = 0; col < width; ++col )
+        {
+            const f32 u  = 40.0f * col / width;
+            const f32 v  = 40.0f * row / height;
+            const f32 dx = 0.6f * cosf( u ) * sinf( 0.5f * v );
+            const f32 dy = 0.3f * sinf( u ) * cosf( 0.5f * v );
+            vec3 normal  = Normalize( vec3( -dx, -dy, 1.0f ) );
+            img.SetPixelFromFloat4( row, col, vec4( 0.5f * normal + vec3( 0.5f ), 0.25f + 0.5f * fabsf( sinf( 0.1f * u ) ) ) );
+        }
+    }
+
+    return img;
+}
+
+struct ReportImage
+{
+    std::string name;
+    RawImage2D image;
+};
+
+struct ReportFormat
+{
+    const char* name;
+    ImageFormat format;
+    u32 numChannels; // how many of the source channels the format stores
+};
+
+static std::vector<ReportImage> GetReportCorpus( const BenchmarkSettings& settings )
+{
+    std::vector<ReportImage> corpus;
+    corpus.push_back( { "synthetic noisy", GenerateSyntheticImage( REPORT_IMAGE_SIZE, REPORT_IMAGE_SIZE, 0 ) } );
+    corpus.push_back( { "synthetic smooth", GenerateSmoothImage( REPORT_IMAGE_SIZE, REPORT_IMAGE_SIZE ) } );
+    corpus.push_back( { "synthetic normal map", GenerateNormalMapImage( REPORT_IMAGE_SIZE, REPORT_IMAGE_SIZE ) } );
+    if ( !settings.inputImage.empty() )
+    {
+        RawImage2D image;
+        if ( image.Load( settings.inputImage ) )
+            corpus.push_back( { settings.inputImage, image.Convert( ImageFormat::R8_G8_B8_A8_UNORM ) } );
+        else
+            LOG_ERR( "Could not load the report image '%s', skipping it", settings.inputImage.c_str() );
+    }
+
+    return corpus;
+}
+
+// The first numChannels channels of the image, as floats
+static FloatImage2D GetChannels( const RawImage2D& image, u32 numChannels )
+{
+    const bool isFloat       = IsFormat16BitFloat( image.format );
+    const ImageFormat format = isFloat ? ImageFormat::R16_FLOAT : ImageFormat::R8_UNORM;
+    return FloatImageFromRawImage2D( image.Convert( static_cast<ImageFormat>( Underlying( format ) + numChannels - 1 ) ) );
+}
+
+static void LogQualityReport( const BenchmarkSettings& settings )
+{
+    // BC2 isn't supported by CompressToBC, and the SNORM variants + BC6H_S16F aren't used by the converter
+    const ReportFormat formats[] = {
+        {"BC1",  ImageFormat::BC1_UNORM, 3},
+        {"BC3",  ImageFormat::BC3_UNORM, 4},
+        {"BC4",  ImageFormat::BC4_UNORM, 1},
+        {"BC5",  ImageFormat::BC5_UNORM, 2},
+        {"BC6H", ImageFormat::BC6H_U16F, 3},
+        {"BC7",  ImageFormat::BC7_UNORM, 4},
+    };
+    const char* qualityNames[] = { "LOWEST", "MEDIUM", "HIGHEST" };
+    static_assert( ARRAY_COUNT( qualityNames ) == Underlying( CompressionQuality::COUNT ) );
+
+    const std::vector<ReportImage> corpus = GetReportCorpus( settings );
+    std::vector<RawImage2D> ldrImages, hdrImages;
+    f64 totalMPix = 0;
+    for ( const ReportImage& reportImage : corpus )
+    {
+        ldrImages.push_back( reportImage.image );
+        hdrImages.push_back( reportImage.image.Convert( ImageFormat::R16_G16_B16_A16_FLOAT ) );
+        totalMPix += reportImage.image.width * reportImage.image.height / 1e6;
+        LOG( "Corpus image: %s (%ux%u)", reportImage.name.c_str(), reportImage.image.width, reportImage.image.height );
+    }
+
+    LOG( "Compressing with %d threads. MSE and PSNR are over the whole corpus, on [0, 1] values", GetBCCompressionThreadCount() );
+    LOG( "%-5s %-8s %9s   %-39s   %s", "Fmt", "Quality", "MPix/s", "MSE (R G B A)", "PSNR dB (R G B A)" );
+    for ( const ReportFormat& reportFormat : formats )
+    {
+        // BC4 and BC5 only encode the first 1 and 2 channels, so compress 1 and 2 channel images. GetBlockClamped8Bit
+        // fills in the rest of each block with the default channel values
+        const bool isBC6              = reportFormat.format == ImageFormat::BC6H_U16F;
+        std::vector<RawImage2D> input = isBC6 ? hdrImages : ldrImages;
+        if ( reportFormat.numChannels < 3 )
+        {
+            for ( RawImage2D& image : input )
+                image = image.Convert( GetFormatAfterDecompression( reportFormat.format ) );
+        }
+        for ( u32 quality = 0; quality < Underlying( CompressionQuality::COUNT ); ++quality )
+        {
+            const BCCompressorSettings compressorSettings( reportFormat.format, (CompressionQuality)quality );
+            const auto startTime                   = std::chrono::high_resolution_clock::now();
+            std::vector<RawImage2D> compressedImgs = CompressToBC( input, compressorSettings );
+            const f64 seconds = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - startTime ).count();
+
+            // Weight each image's error by its pixel count, so that the result is the MSE of the whole corpus
+            f64 mse[4] = { 0, 0, 0, 0 };
+            for ( size_t i = 0; i < input.size(); ++i )
+            {
+                FloatImage2D original     = GetChannels( input[i], reportFormat.numChannels );
+                FloatImage2D decompressed = GetChannels( DecompressBC( compressedImgs[i] ), reportFormat.numChannels );
+                const f64 weight          = input[i].width * input[i].height / ( 1e6 * totalMPix );
+                for ( u32 chan = 0; chan < reportFormat.numChannels; ++chan )
+                    mse[chan] += weight * FloatImageMSE( original, decompressed, 1u << ( 3 - chan ) );
+            }
+
+            char mseStr[64]  = {};
+            char psnrStr[64] = {};
+            i32 mseLen       = 0;
+            i32 psnrLen      = 0;
+            for ( u32 chan = 0; chan < reportFormat.numChannels; ++chan )
+            {
+                mseLen += snprintf( mseStr + mseLen, sizeof( mseStr ) - mseLen, "%.3e ", mse[chan] );
+                psnrLen += snprintf( psnrStr + psnrLen, sizeof( psnrStr ) - psnrLen, "%6.2f ", MSEToPSNR( mse[chan] ) );
+            }
+            LOG( "%-5s %-8s %9.2f   %-39s   %s", reportFormat.name, qualityNames[quality], totalMPix / seconds, mseStr, psnrStr );
+        }
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    Logger_Init();
+    Logger_AddLogLocation( "stdout", stdout );
+
+    BenchmarkSettings settings;
+    if ( !ParseCommandLineArgs( argc, argv, settings ) )
+    {
+        Logger_Shutdown();
+        return 0;
+    }
+
+    if ( settings.qualityReport )
+    {
+        LogQualityReport( settings );
+        Logger_Shutdown();
+        return 0;
+    }
+
+    // Like a scene with a few huge textures and lots of small ones. The large ones go first, same as in the converter's asset list
+    const u32 numTextures = settings.numLarge + settings.numSmall;
+    std::vector<std::vector<RawImage2D>> textures( numTextures );
+    f64 totalMPix = 0;
+    for ( u32 i = 0; i < numTextures; ++i )
+    {
+        textures[i] = GenerateSyntheticMips( i < settings.numLarge ? settings.largeSize : settings.smallSize, i );
+        for ( const RawImage2D& mip : textures[i] )
+            totalMPix += mip.width * mip.height / 1e6;
+    }
+
+    // The converter enables nested omp in EngineInitialize, which the old per image path relied on
+    omp_set_nested( 1 );
+    const BCCompressorSettings compressorSettings( ImageFormat::BC7_UNORM, CompressionQuality::MEDIUM );
+    const f64 perImageSeconds = TimeCompression( textures, compressorSettings, false );
+    const f64 poolSeconds     = TimeCompression( textures, compressorSettings, true );
+
+    LOG( "Compressed %u large (%ux%u) and %u small (%ux%u) textures to BC7, with all of their mips, using %d threads", settings.numLarge,
+        settings.largeSize, settings.largeSize, settings.numSmall, settings.smallSize, settings.smallSize, omp_get_max_threads() );
+    LOG( "Per image omp: %.3f seconds, %.2f MPix/s", perImageSeconds, totalMPix / perImageSeconds );
+    LOG( "Task pool:     %.3f seconds, %.2f MPix/s (%.2fx)", poolSeconds, totalMPix / poolSeconds, perImageSeconds / poolSeconds );
+
+    if ( settings.rdoLambda > 0 )
+        LogRDOReport( settings );
+
+    Logger_Shutdown();
+
+    return 0;
+}
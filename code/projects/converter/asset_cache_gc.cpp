@@ -0,0 +1,170 @@
+#include "asset_cache_gc.hpp"
+#include "asset/asset_cache.hpp"
+#include "converters/base_asset_converter.hpp"
+#include "core/cpu_profiling.hpp"
+#include "shared/file_dependency.hpp"
+#include "shared/filesystem.hpp"
+#include "shared/logger.hpp"
+#include <algorithm>
+#include <ctime>
+#include <unordered_map>
+
+// Temporary files that are younger than this might still belong to another converter that is running right now
+static constexpr time_t TMP_FILE_MIN_AGE_SECONDS = 60 * 60;
+
+// The spirv cache is keyed by the preprocessed shader source, so there is no way to tell which entries are reachable.
+// Entries get their timestamps bumped whenever they are used though, so just delete the ones that haven't been in a while
+static constexpr time_t SPIRV_CACHE_MAX_AGE_SECONDS = 14 * 24 * 60 * 60;
+
+static const std::string ASSET_LIST_DIR = PG_ASSET_DIR "cache/assetlists/";
+static const std::string FASTFILE_DIR   = PG_ASSET_DIR "cache/fastfiles/";
+static const std::string SPIRV_DIR      = PG_ASSET_DIR "cache/spirv/";
+
+// AssetCache::CacheAsset writes "<cacheName>_tmp<ext>", shared cache fetches write "<cacheName><ext>_shared_tmp",
+// and the FastfileWriter writes "<fastfile>_tmp"
+static bool IsTmpFilename( const std::string& filename, const std::string& ext )
+{
+    return filename.ends_with( "_tmp" ) || filename.ends_with( "_tmp" + ext );
+}
+
+namespace PG
+{
+
+struct CachedAssetFile
+{
+    std::string path;
+    size_t size;
+    time_t lastUsed;
+};
+
+struct GCStats
+{
+    u32 tmpFilesDeleted    = 0;
+    u32 unreachableDeleted = 0;
+    u32 evicted            = 0;
+    u32 staleSpirvDeleted  = 0;
+    size_t bytesReclaimed  = 0;
+    size_t bytesRemaining  = 0;
+
+    void Delete( const std::string& path, size_t size, u32& counter )
+    {
+        DeleteFile( path );
+        bytesReclaimed += size;
+        ++counter;
+    }
+};
+
+static void DeleteOldTmpFiles( const std::string& dir, const std::string& ext, time_t now, GCStats& stats )
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for ( const auto& entry : fs::directory_iterator( dir, ec ) )
+    {
+        std::string path = entry.path().string();
+        if ( !entry.is_regular_file() || !IsTmpFilename( GetRelativeFilename( path ), ext ) )
+            continue;
+
+        if ( now - GetFileTimestamp( path ) >= TMP_FILE_MIN_AGE_SECONDS )
+            stats.Delete( path, (size_t)entry.file_size( ec ), stats.tmpFilesDeleted );
+    }
+}
+
+bool CollectAssetCacheGarbage( size_t budgetBytes )
+{
+    PGP_ZONE_SCOPEDN( "CollectAssetCacheGarbage" );
+    namespace fs = std::filesystem;
+
+    // The last time a cache entry was used is approximated by the newest asset list referencing it. The cached files'
+    // own timestamps can't be bumped on use, because the up to date checks compare them against the source files
+    std::unordered_map<std::string, time_t> reachable[ASSET_TYPE_COUNT];
+    u32 numAssetLists = 0;
+    std::error_code ec;
+    for ( const auto& entry : fs::recursive_directory_iterator( ASSET_LIST_DIR, ec ) )
+    {
+        std::string path = BackToForwardSlashes( entry.path().string() );
+        if ( !entry.is_regular_file() || GetFileExtension( path ) != ".txt" )
+            continue;
+
+        AssetList assetList;
+        assetList.Import( GetFilenameMinusExtension( GetRelativePathToDir( path, ASSET_LIST_DIR ) ) );
+        time_t listTimestamp = GetFileTimestamp( path );
+        for ( u32 typeIdx = 0; typeIdx < ASSET_TYPE_COUNT; ++typeIdx )
+        {
+            for ( const std::string& cacheName : assetList.assets[typeIdx] )
+            {
+                time_t& lastUsed = reachable[typeIdx][cacheName];
+                lastUsed         = std::max( lastUsed, listTimestamp );
+            }
+        }
+        ++numAssetLists;
+    }
+
+    if ( numAssetLists == 0 )
+    {
+        LOG_ERR( "Asset cache GC: no scene asset lists found in '%s'. Convert the scenes first, or else everything would be deleted",
+            ASSET_LIST_DIR.c_str() );
+        return false;
+    }
+
+    GCStats stats;
+    const time_t now = std::time( nullptr );
+    std::vector<CachedAssetFile> reachableFiles;
+    for ( u32 typeIdx = 0; typeIdx < ASSET_TYPE_COUNT; ++typeIdx )
+    {
+        const AssetType assetType  = (AssetType)typeIdx;
+        const std::string& ext     = AssetCache::GetCacheFileExtension( assetType );
+        const std::string cacheDir = AssetCache::GetCacheDirectory( assetType );
+        DeleteOldTmpFiles( cacheDir, ext, now, stats );
+
+        for ( const auto& entry : fs::directory_iterator( cacheDir, ec ) )
+        {
+            std::string path = entry.path().string();
+            if ( !entry.is_regular_file() || !path.ends_with( ext ) || IsTmpFilename( GetRelativeFilename( path ), ext ) )
+                continue;
+
+            size_t size           = (size_t)entry.file_size( ec );
+            std::string filename  = GetRelativeFilename( path );
+            std::string cacheName = filename.substr( 0, filename.length() - ext.length() );
+            auto it               = reachable[typeIdx].find( cacheName );
+            if ( it == reachable[typeIdx].end() )
+            {
+                stats.Delete( path, size, stats.unreachableDeleted );
+                continue;
+            }
+
+            reachableFiles.push_back( { path, size, std::max( it->second, GetFileTimestamp( path ) ) } );
+            stats.bytesRemaining += size;
+        }
+    }
+    DeleteOldTmpFiles( FASTFILE_DIR, ".ff", now, stats );
+    DeleteOldTmpFiles( SPIRV_DIR, ".spv", now, stats );
+
+    for ( const auto& entry : fs::directory_iterator( SPIRV_DIR, ec ) )
+    {
+        std::string path = entry.path().string();
+        if ( entry.is_regular_file() && path.ends_with( ".spv" ) && now - GetFileTimestamp( path ) >= SPIRV_CACHE_MAX_AGE_SECONDS )
+            stats.Delete( path, (size_t)entry.file_size( ec ), stats.staleSpirvDeleted );
+    }
+
+    if ( budgetBytes && stats.bytesRemaining > budgetBytes )
+    {
+        std::sort( reachableFiles.begin(), reachableFiles.end(),
+            []( const CachedAssetFile& a, const CachedAssetFile& b ) { return a.lastUsed < b.lastUsed; } );
+        for ( size_t i = 0; i < reachableFiles.size() && stats.bytesRemaining > budgetBytes; ++i )
+        {
+            stats.Delete( reachableFiles[i].path, reachableFiles[i].size, stats.evicted );
+            stats.bytesRemaining -= reachableFiles[i].size;
+        }
+    }
+
+    LOG( "Asset cache GC: deleted %u temporary files, %u unreachable assets, %u stale spirv cache entries and evicted %u least "
+         "recently used assets",
+        stats.tmpFilesDeleted, stats.unreachableDeleted, stats.staleSpirvDeleted, stats.evicted );
+    std::string budgetStr = budgetBytes ? std::to_string( budgetBytes / ( 1024 * 1024 ) ) + " MB" : "none";
+    LOG( "Asset cache GC: reclaimed %.2f MB, the cache is now %.2f MB (budget: %s)", stats.bytesReclaimed / ( 1024.0 * 1024.0 ),
+        stats.bytesRemaining / ( 1024.0 * 1024.0 ), budgetStr.c_str() );
+
+    return true;
+}
+
+} // namespace PG
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+namespace PG
+{
+
+// Deletes any temporary files left behind by killed converters, and every cached asset that isn't referenced by any
+// of the scene asset lists (old _v<version>s, old settings hashes, deleted assets, etc).
+// If the cache is still larger than budgetBytes after that, the least recently used assets get evicted too, until it
+// fits. They will just get reconverted the next time a scene using them is out of date. A budget of 0 means unlimited
+bool CollectAssetCacheGarbage( size_t budgetBytes );
+
+} // namespace PG
@@ -1,11 +1,14 @@
 #include "asset/asset_file_database.hpp"
 #include "asset/asset_manager.hpp"
 #include "asset/asset_versions.hpp"
+#include "asset_cache_gc.hpp"
 #include "converters.hpp"
 #include "core/init.hpp"
 #include "core/scene.hpp"
 #include "core/time.hpp"
 #include "ecs/components/model_renderer.hpp"
+#include "fastfile_writer.hpp"
+#include "file_watcher.hpp"
 #include "getopt/getopt.h"
 #include "shared/assert.hpp"
 #include "shared/file_dependency.hpp"
@@ -13,12 +16,36 @@
 #include "shared/json_parsing.hpp"
 #include "shared/logger.hpp"
 #include "shared/serializer.hpp"
+#include "shared/sockets.hpp"
 #include "shared/string.hpp"
+#include "shared_asset_cache.hpp"
 #include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
+#if USING( LINUX_PROGRAM )
+#include <sys/resource.h>
+#endif // #if USING( LINUX_PROGRAM )
+
 using namespace PG;
 
+// Peak resident set size of the whole process so far. Returns 0 if it's not available on this platform
+static size_t GetPeakRSSBytes()
+{
+#if USING( LINUX_PROGRAM )
+    rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) == 0 )
+        return static_cast<size_t>( usage.ru_maxrss ) * 1024; // in KB on linux
+
+    return 0;
+#else  // #if USING( LINUX_PROGRAM )
+    return 0;
+#endif // #else // #if USING( LINUX_PROGRAM )
+}
+
 static void DisplayHelp()
 {
     auto msg =
@@ -27,9 +54,27 @@ static void DisplayHelp()
         "ASSET_NAME is the name of the asset to be converted. Only applies when using --single, otherwise it's always interpreted as a "
         "scene path\n"
         "Options\n"
+        "  --batch        Gather the assets of every scene first, convert each unique asset once, then write all of the fastfiles "
+        "in parallel\n"
+        "  --cachebudget  Maximum size of the asset cache in MB. After converting, unused assets get deleted, followed by the least "
+        "recently used ones until the cache fits. Format: MB\n"
+        "  --cachebind    The address for --cacheserver to listen on. There is no authentication, so only use addresses on trusted "
+        "networks. Defaults to 127.0.0.1:27016. Format: host[:port]\n"
+        "  --cacheserver  Don't convert anything, just serve the given directory as a shared asset cache for other converters. "
+        "Format: DIR\n"
+        "  --daemon       After converting, keep running and watch the asset directory for changes. Any changes get reconverted and "
+        "sent to a running engine\n"
         "  --force        Don't check asset file dependencies, just reconvert everything\n"
+        "  --gc           Don't convert anything, just delete leftover temporary files and cached assets that no scene uses anymore. "
+        "Respects --cachebudget\n"
         "  --help         Print this message and exit\n"
         "  --preproc      Save out the preprocessed shaders, for any converted shaders\n"
+        "  --shaderdebug  Whether to keep the debug info in the compiled shaders. Defaults to keep in development builds, and strip in "
+        "ship builds. Format: keep|strip\n"
+        "  --shaderopt    Which spirv-opt recipe to run on the compiled shaders. Defaults to none in development builds, and perf in ship "
+        "builds. Format: none|perf|size\n"
+        "  --sharedcache  Before converting an out of date asset, try downloading it from the shared asset cache, and upload any "
+        "newly converted assets. Format: DIR or tcp:host[:port]\n"
         "  --single       Used to process a specific asset (and its referenced assets). Format: type name. Ex: '--single material "
         "\n";
 
@@ -38,7 +83,16 @@ static void DisplayHelp()
 
 static AssetType s_singleAssetType;
 static std::string s_singleAssetName;
-static u32 s_outOfDateScenes = 0;
+static bool s_batchScenes   = false;
+static bool s_daemonMode    = false;
+static bool s_gcOnly        = false;
+static size_t s_cacheBudget = 0;
+static std::string s_sharedCacheLocation;
+static std::string s_cacheServerDir;
+static std::string s_cacheServerAddress   = "127.0.0.1";
+static std::atomic<u32> s_outOfDateScenes = 0;
+static std::mutex s_rebuiltFastfilesLock;
+static std::vector<std::string> s_rebuiltFastfiles;
 
 static const std::string SCENE_DIR = PG_ASSET_DIR "scenes/";
 
@@ -46,23 +100,70 @@ static bool ParseCommandLineArgs( int argc, char** argv, std::string& sceneFile
 {
     PGP_ZONE_SCOPEDN( "ParseCommandLineArgs" );
     static struct option long_options[] = {
-        {"force",   no_argument,       0, 'f'},
-        {"help",    no_argument,       0, 'h'},
-        {"preproc", no_argument,       0, 'p'},
-        {"single",  required_argument, 0, 's'},
-        {0,         0,                 0, 0  }
+        {"batch",       no_argument,       0, 'b'},
+        {"cachebind",   required_argument, 0, 'a'},
+        {"cachebudget", required_argument, 0, 'm'},
+        {"cacheserver", required_argument, 0, 'c'},
+        {"daemon",      no_argument,       0, 'd'},
+        {"force",       no_argument,       0, 'f'},
+        {"gc",          no_argument,       0, 'g'},
+        {"help",        no_argument,       0, 'h'},
+        {"preproc",     no_argument,       0, 'p'},
+        {"shaderdebug", required_argument, 0, 'k'},
+        {"shaderopt",   required_argument, 0, 'o'},
+        {"sharedcache", required_argument, 0, 'r'},
+        {"single",      required_argument, 0, 's'},
+        {0,             0,                 0, 0  }
     };
 
     s_singleAssetType = ASSET_TYPE_COUNT;
     i32 option_index  = 0;
     i32 c             = -1;
-    while ( ( c = getopt_long( argc, argv, "fhps", long_options, &option_index ) ) != -1 )
+    while ( ( c = getopt_long( argc, argv, "a:bc:dfghk:m:o:pr:s", long_options, &option_index ) ) != -1 )
     {
         switch ( c )
         {
+        case 'a': s_cacheServerAddress = optarg; break;
+        case 'b': s_batchScenes = true; break;
+        case 'c': s_cacheServerDir = optarg; break;
+        case 'd': s_daemonMode = true; break;
         case 'f': g_converterConfigOptions.force = true; break;
+        case 'g': s_gcOnly = true; break;
         case 'h': DisplayHelp(); return false;
+        case 'k':
+            if ( !Stricmp( optarg, "keep" ) || !Stricmp( optarg, "strip" ) )
+            {
+                g_converterConfigOptions.stripShaderDebugInfo = !Stricmp( optarg, "strip" );
+            }
+            else
+            {
+                LOG_ERR( "Invalid shader debug option '%s'. Expected keep or strip", optarg );
+                return false;
+            }
+            break;
+        case 'm':
+            s_cacheBudget = strtoull( optarg, nullptr, 10 ) * 1024 * 1024;
+            if ( !s_cacheBudget )
+            {
+                LOG_ERR( "Invalid cache budget '%s'. Expected a positive number of MB", optarg );
+                return false;
+            }
+            break;
+        case 'o':
+            if ( !Stricmp( optarg, "none" ) )
+                g_converterConfigOptions.shaderOptimization = ShaderOptimization::NONE;
+            else if ( !Stricmp( optarg, "perf" ) )
+                g_converterConfigOptions.shaderOptimization = ShaderOptimization::PERFORMANCE;
+            else if ( !Stricmp( optarg, "size" ) )
+                g_converterConfigOptions.shaderOptimization = ShaderOptimization::SIZE;
+            else
+            {
+                LOG_ERR( "Invalid shader optimization '%s'. Expected none, perf or size", optarg );
+                return false;
+            }
+            break;
         case 'p': g_converterConfigOptions.saveShaderPreproc = true; break;
+        case 'r': s_sharedCacheLocation = optarg; break;
         case 's':
             for ( u32 i = 0; i < Underlying( ASSET_TYPE_COUNT ); ++i )
             {
@@ -81,6 +182,9 @@ static bool ParseCommandLineArgs( int argc, char** argv, std::string& sceneFile
         }
     }
 
+    if ( !s_cacheServerDir.empty() || s_gcOnly )
+        return true;
+
     if ( optind >= argc )
     {
         DisplayHelp();
@@ -88,6 +192,11 @@ static bool ParseCommandLineArgs( int argc, char** argv, std::string& sceneFile
     }
     if ( s_singleAssetType != ASSET_TYPE_COUNT )
     {
+        if ( s_daemonMode )
+        {
+            LOG_ERR( "--daemon can't be used with --single" );
+            return false;
+        }
         s_singleAssetName = argv[optind];
     }
     else
@@ -265,7 +374,58 @@ bool ConvertAssets( const std::string& sceneName, u32& outOfDateAssets )
     return convertErrors == 0;
 }
 
-bool OutputFastfile( const std::string& sceneName, const u32 outOfDateAssets, const AssetList& prevAssetList )
+struct FastfileInputs
+{
+    std::vector<BaseCreateInfoPtr> usedAssets[ASSET_TYPE_COUNT];
+    AssetList usedAssetList;
+    AssetList prevAssetList;
+    time_t latestDependency = NO_TIMESTAMP;
+    u32 outOfDateAssets     = 0;
+};
+
+static void GetUsedAssetsForFastfile( FastfileInputs& inputs )
+{
+    for ( u8 assetTypeIdx = 0; assetTypeIdx < ASSET_TYPE_COUNT; ++assetTypeIdx )
+    {
+        inputs.usedAssets[assetTypeIdx] = GetUsedAssetsOfType( (AssetType)assetTypeIdx );
+    }
+    inputs.usedAssetList    = GetUsedAssetList();
+    inputs.latestDependency = GetLatestFastfileDependency();
+}
+
+static bool WriteFastfile( const std::string& fastfilePath, const FastfileInputs& inputs, bool debugAssets )
+{
+    FastfileWriter ff;
+    if ( !ff.Open( fastfilePath ) )
+        return false;
+
+    for ( u8 assetTypeIdx = 0; assetTypeIdx < ASSET_TYPE_NON_METADATA_COUNT; ++assetTypeIdx )
+    {
+        for ( const auto& baseInfoPtr : inputs.usedAssets[assetTypeIdx] )
+        {
+            if ( baseInfoPtr->isDebugOnlyAsset != debugAssets )
+                continue;
+
+            AssetType assetType         = (AssetType)assetTypeIdx;
+            const std::string cacheName = baseInfoPtr->cacheName;
+            if ( !ff.AddAsset( assetType, AssetCache::GetCachedAssetPath( assetType, cacheName ) ) )
+            {
+                LOG_ERR( "Could not get cached asset %s of type %s", cacheName.c_str(), g_assetNames[assetTypeIdx] );
+                return false;
+            }
+        }
+    }
+    if ( !ff.Close() )
+        return false;
+
+    LOG( "Wrote fastfile %s: %.2f MB reused from the previous version, %.2f MB copied from the asset cache, %.2f MB of duplicate "
+         "spirv skipped",
+        GetRelativeFilename( fastfilePath ).c_str(), ff.BytesReused() / ( 1024.0 * 1024.0 ), ff.BytesCopied() / ( 1024.0 * 1024.0 ),
+        ff.BytesDeduped() / ( 1024.0 * 1024.0 ) );
+    return true;
+}
+
+bool OutputFastfile( const std::string& sceneName, const FastfileInputs& inputs )
 {
     PGP_ZONE_SCOPEDN( "OutputFastfile" );
     std::string fastfileName      = GetFilenameStem( sceneName ) + "_v" + std::to_string( PG_FASTFILE_VERSION ) + ".ff";
@@ -274,19 +434,18 @@ bool OutputFastfile( const std::string& sceneName, const u32 outOfDateAssets, co
     std::string fastfilePathDebug = PG_ASSET_DIR "cache/fastfiles/" + fastfileNameDebug;
     time_t ffTimestamp            = GetFileTimestamp( fastfilePath );
 
-    const AssetList& usedAssetList = GetUsedAssetList();
-    bool createFastFile            = false;
+    bool createFastFile = false;
     if ( ffTimestamp == NO_TIMESTAMP )
     {
         LOG( "Fastfile %s is missing. Building...", fastfileName.c_str() );
         createFastFile = true;
     }
-    else if ( ffTimestamp < GetLatestFastfileDependency() || outOfDateAssets )
+    else if ( ffTimestamp < inputs.latestDependency || inputs.outOfDateAssets )
     {
         LOG( "Fastfile %s is out of date. Rebuilding...", fastfileName.c_str() );
         createFastFile = true;
     }
-    else if ( prevAssetList != usedAssetList )
+    else if ( inputs.prevAssetList != inputs.usedAssetList )
     {
         LOG( "Fastfile %s is out of date. Rebuilding...", fastfileName.c_str() );
         createFastFile = true;
@@ -295,81 +454,35 @@ bool OutputFastfile( const std::string& sceneName, const u32 outOfDateAssets, co
     if ( createFastFile )
     {
         ++s_outOfDateScenes;
-        Serializer ff;
-        if ( !ff.OpenForWrite( fastfilePath ) )
-        {
-            LOG_ERR( "Could not open fastfile for writing" );
+        if ( !WriteFastfile( fastfilePath, inputs, false ) )
             return false;
-        }
 
         u32 numDebugAssets = 0;
         for ( u8 assetTypeIdx = 0; assetTypeIdx < ASSET_TYPE_NON_METADATA_COUNT; ++assetTypeIdx )
         {
-            const auto& listOfUsedAssets = GetUsedAssetsOfType( (AssetType)assetTypeIdx );
-            for ( const auto& baseInfoPtr : listOfUsedAssets )
+            for ( const auto& baseInfoPtr : inputs.usedAssets[assetTypeIdx] )
             {
                 if ( baseInfoPtr->isDebugOnlyAsset )
-                {
                     ++numDebugAssets;
-                    continue;
-                }
-                AssetType assetType = (AssetType)assetTypeIdx;
-                ff.Write( assetType );
-                const std::string cacheName = baseInfoPtr->cacheName;
-                size_t numBytes;
-                auto assetRawBytes = AssetCache::GetCachedAssetRaw( assetType, cacheName, numBytes );
-                if ( !assetRawBytes )
-                {
-                    ff.Close();
-                    DeleteFile( fastfilePath );
-                    LOG_ERR( "Could not get cached asset %s of type %s", cacheName.c_str(), g_assetNames[assetTypeIdx] );
-                    return false;
-                }
-                ff.Write( assetRawBytes.get(), numBytes );
             }
         }
-        ff.Close();
 
         if ( numDebugAssets )
         {
-            if ( !ff.OpenForWrite( fastfilePathDebug ) )
-            {
-                LOG_ERR( "Could not open debug fastfile for writing" );
+            if ( !WriteFastfile( fastfilePathDebug, inputs, true ) )
                 return false;
-            }
-
-            for ( u8 assetTypeIdx = 0; assetTypeIdx < ASSET_TYPE_NON_METADATA_COUNT; ++assetTypeIdx )
-            {
-                const auto& listOfUsedAssets = GetUsedAssetsOfType( (AssetType)assetTypeIdx );
-                for ( const auto& baseInfoPtr : listOfUsedAssets )
-                {
-                    if ( !baseInfoPtr->isDebugOnlyAsset )
-                        continue;
-
-                    AssetType assetType = (AssetType)assetTypeIdx;
-                    ff.Write( assetType );
-                    const std::string cacheName = baseInfoPtr->cacheName;
-                    size_t numBytes;
-                    auto assetRawBytes = AssetCache::GetCachedAssetRaw( assetType, cacheName, numBytes );
-                    if ( !assetRawBytes )
-                    {
-                        ff.Close();
-                        DeleteFile( fastfilePath );
-                        LOG_ERR( "Could not get cached asset %s of type %s", cacheName.c_str(), g_assetNames[assetTypeIdx] );
-                        return false;
-                    }
-                    ff.Write( assetRawBytes.get(), numBytes );
-                }
-            }
-            ff.Close();
         }
         else
         {
             DeleteFile( fastfilePathDebug );
         }
 
-        usedAssetList.Export( sceneName );
-        LOG( "Build fastfile succeeded" );
+        inputs.usedAssetList.Export( sceneName );
+        {
+            std::scoped_lock lock( s_rebuiltFastfilesLock );
+            s_rebuiltFastfiles.push_back( GetFilenameStem( sceneName ) );
+        }
+        LOG( "Build fastfile %s succeeded", fastfileName.c_str() );
     }
     else
     {
@@ -386,12 +499,8 @@ struct SceneInfo
     bool requiredScene = false;
 };
 
-bool ProcessSingleScene( const SceneInfo& sceneInfo )
+static bool FindAssetsUsedInScene( const SceneInfo& sceneInfo )
 {
-    PGP_ZONE_SCOPED_FMT( "ProcessSingleScene %s", sceneInfo.name.c_str() );
-    ClearAllFastfileDependencies();
-    ClearAllUsedAssets();
-
     size_t debugPostfix = sceneInfo.name.rfind( "_debug" );
     if ( debugPostfix != std::string::npos && debugPostfix + 6 == sceneInfo.name.length() )
     {
@@ -434,15 +543,132 @@ bool ProcessSingleScene( const SceneInfo& sceneInfo )
         return false;
     }
 
+    return true;
+}
+
+bool ProcessSingleScene( const SceneInfo& sceneInfo )
+{
+    PGP_ZONE_SCOPED_FMT( "ProcessSingleScene %s", sceneInfo.name.c_str() );
+    ClearAllFastfileDependencies();
+    ClearAllUsedAssets();
+
+    if ( !FindAssetsUsedInScene( sceneInfo ) )
+        return false;
+
     // NOTE: this isn't valid to do if an asset type is removed. There is no versioning or checking,
     // So if the ASSET_TYPE enum is edited, this folder should just be deleted
-    AssetList prevAssetList;
-    prevAssetList.Import( sceneInfo.name );
+    FastfileInputs ffInputs;
+    ffInputs.prevAssetList.Import( sceneInfo.name );
 
-    u32 outOfDateAssets;
-    bool success = ConvertAssets( sceneInfo.name, outOfDateAssets );
-    success      = success && OutputFastfile( sceneInfo.name, outOfDateAssets, prevAssetList );
-    return success;
+    if ( !ConvertAssets( sceneInfo.name, ffInputs.outOfDateAssets ) )
+        return false;
+
+    GetUsedAssetsForFastfile( ffInputs );
+    return OutputFastfile( sceneInfo.name, ffInputs );
+}
+
+struct UniqueAsset
+{
+    BaseCreateInfoPtr createInfo;
+    AssetType assetType;
+    AssetStatus status      = AssetStatus::UP_TO_DATE;
+    time_t latestDependency = NO_TIMESTAMP;
+};
+
+// Instead of processing each scene one after another, gather the union of all the scenes' assets first, so that
+// assets shared between scenes only get their status checked (and converted) once. Then emit all of the fastfiles
+bool ConvertScenesBatched( const std::vector<SceneInfo>& scenes )
+{
+    PGP_ZONE_SCOPEDN( "ConvertScenesBatched" );
+    auto convertStartTime = Time::GetTimePoint();
+
+    std::vector<FastfileInputs> sceneInputs( scenes.size() );
+    std::vector<std::vector<u32>> sceneAssetIndices( scenes.size() );
+    std::vector<UniqueAsset> uniqueAssets;
+    std::unordered_map<std::string, u32> uniqueAssetMap[ASSET_TYPE_COUNT];
+    u32 totalAssets = 0;
+
+    // Scene parsing goes through lua and the global used asset lists, so it has to stay serial
+    for ( size_t sceneIdx = 0; sceneIdx < scenes.size(); ++sceneIdx )
+    {
+        ClearAllFastfileDependencies();
+        ClearAllUsedAssets();
+        if ( !FindAssetsUsedInScene( scenes[sceneIdx] ) )
+            return false;
+
+        FastfileInputs& inputs = sceneInputs[sceneIdx];
+        GetUsedAssetsForFastfile( inputs );
+        inputs.prevAssetList.Import( scenes[sceneIdx].name );
+        for ( u8 assetTypeIdx = 0; assetTypeIdx < ASSET_TYPE_COUNT; ++assetTypeIdx )
+        {
+            for ( const BaseCreateInfoPtr& createInfo : inputs.usedAssets[assetTypeIdx] )
+            {
+                auto [it, inserted] = uniqueAssetMap[assetTypeIdx].try_emplace( createInfo->cacheName, (u32)uniqueAssets.size() );
+                if ( inserted )
+                    uniqueAssets.push_back( { createInfo, (AssetType)assetTypeIdx } );
+                sceneAssetIndices[sceneIdx].push_back( it->second );
+                ++totalAssets;
+            }
+        }
+    }
+
+    std::atomic<u32> convertErrors = 0;
+#pragma omp parallel for schedule( dynamic )
+    for ( i32 i = 0; i < (i32)uniqueAssets.size(); ++i )
+    {
+        UniqueAsset& asset = uniqueAssets[i];
+        ClearAllFastfileDependencies();
+        asset.status           = g_converters[asset.assetType]->IsAssetOutOfDate( asset.createInfo );
+        asset.latestDependency = GetLatestFastfileDependency();
+        if ( asset.status == AssetStatus::ERROR )
+            ++convertErrors;
+    }
+
+    std::vector<u32> outOfDateAssetList;
+    for ( u32 i = 0; i < (u32)uniqueAssets.size(); ++i )
+    {
+        if ( uniqueAssets[i].status == AssetStatus::OUT_OF_DATE )
+            outOfDateAssetList.push_back( i );
+    }
+
+    if ( !convertErrors )
+    {
+#pragma omp parallel for schedule( dynamic )
+        for ( i32 i = 0; i < (i32)outOfDateAssetList.size(); ++i )
+        {
+            const UniqueAsset& asset = uniqueAssets[outOfDateAssetList[i]];
+            if ( !g_converters[asset.assetType]->Convert( asset.createInfo ) )
+                ++convertErrors;
+        }
+    }
+
+    f64 duration = Time::GetTimeSince( convertStartTime ) / 1000.0f;
+    if ( convertErrors )
+    {
+        LOG_ERR( "Convert for %zu scenes FAILED with %u errors in %.2f seconds", scenes.size(), convertErrors.load(), duration );
+        return false;
+    }
+    LOG( "Convert for %zu scenes succeeded in %.2f seconds, %zu / %zu unique assets out of date (%u total asset references)\n",
+        scenes.size(), duration, outOfDateAssetList.size(), uniqueAssets.size(), totalAssets );
+
+    std::atomic<u32> fastfileErrors = 0;
+#pragma omp parallel for schedule( dynamic )
+    for ( i32 sceneIdx = 0; sceneIdx < (i32)scenes.size(); ++sceneIdx )
+    {
+        FastfileInputs& inputs = sceneInputs[sceneIdx];
+        for ( u32 uniqueIdx : sceneAssetIndices[sceneIdx] )
+        {
+            const UniqueAsset& asset = uniqueAssets[uniqueIdx];
+            inputs.latestDependency  = std::max( inputs.latestDependency, asset.latestDependency );
+            if ( asset.status == AssetStatus::OUT_OF_DATE )
+                ++inputs.outOfDateAssets;
+        }
+
+        if ( !OutputFastfile( scenes[sceneIdx].name, inputs ) )
+            ++fastfileErrors;
+    }
+
+    return fastfileErrors == 0;
 }
 
 bool ConvertScenes( const std::string& scene )
@@ -487,6 +713,9 @@ bool ConvertScenes( const std::string& scene )
         scenesToProcess.push_back( sInfo );
     }
 
+    if ( s_batchScenes )
+        return ConvertScenesBatched( scenesToProcess );
+
     for ( size_t i = 0; i < scenesToProcess.size(); ++i )
     {
         const SceneInfo& sceneInfo = scenesToProcess[i];
@@ -516,6 +745,75 @@ bool ConvertSingleAsset()
     return ConvertAssets( s_singleAssetName, outOfDateAssets );
 }
 
+static volatile sig_atomic_t s_daemonShouldExit = 0;
+
+static void DaemonSignalHandler( int ) { s_daemonShouldExit = 1; }
+
+// Sends a regular 'loadFF' command to the engine's remote console server (same as the RemoteConsole program),
+// which then live updates any of the assets that changed in the new fastfile
+static void NotifyEngine( const std::string& fastfileName )
+{
+    ClientSocket clientSocket;
+    if ( !clientSocket.OpenSocket( "localhost", 27015 ) || !clientSocket.OpenConnection() )
+    {
+        LOG( "Converter daemon: no engine running to notify about fastfile %s", fastfileName.c_str() );
+        return;
+    }
+
+    std::string cmd = "loadFF " + fastfileName;
+    if ( clientSocket.SendData( cmd.c_str(), (int)cmd.length() ) )
+        LOG( "Converter daemon: sent '%s' to the engine", cmd.c_str() );
+}
+
+// Keeps the asset database, converters and the shader include cache resident, and just reruns the regular scene
+// conversion whenever something in the asset directory changes. The usual timestamp checks mean only the assets
+// that actually depend on the changed files get reconverted, and only the fastfiles using them get rebuilt
+static void RunDaemon( const std::string& sceneFile )
+{
+    FileWatcher watcher;
+    if ( !watcher.Init( PG_ASSET_DIR, { PG_ASSET_DIR "cache/" } ) )
+    {
+        LOG_ERR( "Converter daemon: could not start watching the asset directory" );
+        return;
+    }
+
+    std::signal( SIGINT, DaemonSignalHandler );
+    std::signal( SIGTERM, DaemonSignalHandler );
+    InitSocketsLib();
+    LOG( "Converter daemon: watching '%s' for changes. Press ctrl-c to exit", PG_ASSET_DIR );
+    while ( !s_daemonShouldExit )
+    {
+        std::vector<std::string> changedFiles = watcher.WaitForChanges( 250, 50 );
+        if ( changedFiles.empty() )
+            continue;
+
+        auto updateStartTime   = Time::GetTimePoint();
+        bool assetFilesChanged = false;
+        for ( const std::string& file : changedFiles )
+        {
+            LOG( "Converter daemon: '%s' changed", GetRelativePathToDir( file, PG_ASSET_DIR ).c_str() );
+            assetFilesChanged = assetFilesChanged || GetFileExtension( file ) == ".paf";
+        }
+
+        if ( assetFilesChanged && !AssetDatabase::Reload() )
+        {
+            LOG_ERR( "Converter daemon: failed to reload the asset files. Waiting for the next change..." );
+            continue;
+        }
+
+        s_outOfDateScenes = 0;
+        s_rebuiltFastfiles.clear();
+        if ( ConvertScenes( sceneFile ) )
+        {
+            for ( const std::string& fastfileName : s_rebuiltFastfiles )
+                NotifyEngine( fastfileName );
+        }
+        LOG( "Converter daemon: update finished in %.2f ms\n", Time::GetTimeSince( updateStartTime ) );
+    }
+
+    ShutdownSocketLib();
+}
+
 int main( int argc, char** argv )
 {
     auto initStartTime = Time::GetTimePoint();
@@ -527,7 +825,23 @@ int main( int argc, char** argv )
     {
         return 0;
     }
+    if ( !s_cacheServerDir.empty() )
+    {
+        SharedAssetCache::RunServer( s_cacheServerDir, s_cacheServerAddress );
+        EngineShutdown();
+        return 0;
+    }
+    if ( !s_sharedCacheLocation.empty() && !SharedAssetCache::Init( s_sharedCacheLocation ) )
+    {
+        return 0;
+    }
     AssetCache::Init();
+    if ( s_gcOnly )
+    {
+        CollectAssetCacheGarbage( s_cacheBudget );
+        EngineShutdown();
+        return 0;
+    }
     InitConverters();
     if ( !AssetDatabase::Init() )
     {
@@ -551,10 +865,25 @@ int main( int argc, char** argv )
                 LOG( "All Scenes up to date already!" );
             }
         }
+
+        if ( s_cacheBudget )
+        {
+            CollectAssetCacheGarbage( s_cacheBudget );
+        }
+
+        if ( s_daemonMode )
+        {
+            RunDaemon( sceneFile );
+        }
     }
 
     LOG( "Total time: %.2f seconds", Time::GetTimeSince( initStartTime ) / 1000.0f );
+    if ( size_t peakRSS = GetPeakRSSBytes() )
+    {
+        LOG( "Peak memory usage (RSS): %.1f MB", peakRSS / ( 1024.0 * 1024.0 ) );
+    }
 
+    SharedAssetCache::Shutdown();
     ShutdownConverters();
     EngineShutdown();
     return 0;
@@ -7,7 +7,8 @@ namespace PG
 {
 
 ConverterConfigOptions g_converterConfigOptions;
-static time_t s_latestAssetTimestamp;
+// thread local so that asset statuses can be checked in parallel, with each check tracking its own dependencies
+static thread_local time_t s_latestAssetTimestamp;
 
 void AddFastfileDependency( const std::string& file )
 {
@@ -99,6 +100,9 @@ void ClearAllUsedAssets()
     for ( u32 assetTypeIdx = 0; assetTypeIdx < ASSET_TYPE_COUNT; ++assetTypeIdx )
     {
         s_pendingAssets[assetTypeIdx].clear();
+        // these are only placeholder assets created while parsing the scenes, but need to be freed for the daemon mode
+        for ( auto& [_, entry] : AssetManager::g_resourceMaps[assetTypeIdx] )
+            delete entry.asset;
         AssetManager::g_resourceMaps[assetTypeIdx].clear();
     }
 }
@@ -141,4 +145,13 @@ std::vector<BaseCreateInfoPtr> GetUsedAssetsOfType( AssetType assetType )
     return { s_pendingAssets[assetType].begin(), s_pendingAssets[assetType].end() };
 }
 
+bool BaseAssetConverter::GetSharedCacheKey( ConstBaseCreateInfoPtr& baseInfo, std::string& key )
+{
+    std::vector<std::string> inputFiles;
+    if ( !GetInputFiles( baseInfo, inputFiles ) )
+        return false;
+
+    return SharedAssetCache::ComputeKey( assetType, baseInfo->cacheName, inputFiles, key );
+}
+
 } // namespace PG
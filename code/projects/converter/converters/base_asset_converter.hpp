@@ -10,14 +10,26 @@
 #include "shared/json_parsing.hpp"
 #include "shared/logger.hpp"
 #include "shared/serializer.hpp"
+#include "shared_asset_cache.hpp"
 
 namespace PG
 {
 
+enum class ShaderOptimization : u8
+{
+    NONE,
+    PERFORMANCE,
+    SIZE,
+};
+
 struct ConverterConfigOptions
 {
     bool force             = false;
     bool saveShaderPreproc = false;
+
+    // Shipping converters produce optimized shaders without any debug info by default
+    ShaderOptimization shaderOptimization = USING( DEVELOPMENT_BUILD ) ? ShaderOptimization::NONE : ShaderOptimization::PERFORMANCE;
+    bool stripShaderDebugInfo             = !USING( DEVELOPMENT_BUILD );
 };
 
 enum class AssetStatus : u8
@@ -66,6 +78,13 @@ public:
     virtual AssetStatus IsAssetOutOfDate( ConstBaseCreateInfoPtr& baseInfo ) { return AssetStatus::UP_TO_DATE; }
     virtual bool Convert( ConstBaseCreateInfoPtr& baseInfo ) { return true; }
     virtual void AddReferencedAssets( ConstBaseCreateInfoPtr& baseInfo ) {}
+
+    // Every file that the converted asset depends on, besides what is already part of the cache name. Returns false
+    // if the full list can't be known without converting the asset first (ex: shaders without an include cache entry)
+    virtual bool GetInputFiles( ConstBaseCreateInfoPtr& baseInfo, std::vector<std::string>& inputFiles ) { return true; }
+
+protected:
+    bool GetSharedCacheKey( ConstBaseCreateInfoPtr& baseInfo, std::string& key );
 };
 
 template <typename DerivedAsset, typename DerivedInfo>
@@ -106,8 +125,24 @@ public:
     virtual bool Convert( ConstBaseCreateInfoPtr& baseInfo ) override
     {
         PGP_ZONE_SCOPED_FMT( "Convert %s %s", g_assetNames[assetType], baseInfo->name.c_str() );
+        std::string sharedCacheKey;
+        const bool useSharedCache = SharedAssetCache::IsEnabled();
+        if ( useSharedCache && !g_converterConfigOptions.force && GetSharedCacheKey( baseInfo, sharedCacheKey ) &&
+             SharedAssetCache::Fetch( assetType, baseInfo->cacheName, sharedCacheKey ) )
+        {
+            LOG( "Fetched out of date asset %s %s from the shared cache", g_assetNames[assetType], baseInfo->name.c_str() );
+            return true;
+        }
+
         LOG( "Converting out of date asset %s %s...", g_assetNames[assetType], baseInfo->name.c_str() );
-        return ConvertInternal( std::static_pointer_cast<const DerivedInfo>( baseInfo ) );
+        if ( !ConvertInternal( std::static_pointer_cast<const DerivedInfo>( baseInfo ) ) )
+            return false;
+
+        // some input files are only known after converting (ex: shader includes), so try getting the key again
+        if ( useSharedCache && ( !sharedCacheKey.empty() || GetSharedCacheKey( baseInfo, sharedCacheKey ) ) )
+            SharedAssetCache::Publish( assetType, baseInfo->cacheName, sharedCacheKey );
+
+        return true;
     }
 
     virtual void AddReferencedAssets( ConstBaseCreateInfoPtr& baseInfo ) override
@@ -115,10 +150,16 @@ public:
         AddReferencedAssetsInternal( std::static_pointer_cast<const DerivedInfo>( baseInfo ) );
     }
 
+    virtual bool GetInputFiles( ConstBaseCreateInfoPtr& baseInfo, std::vector<std::string>& inputFiles ) override
+    {
+        return GetInputFilesInternal( std::static_pointer_cast<const DerivedInfo>( baseInfo ), inputFiles );
+    }
+
 protected:
     virtual std::string GetCacheNameInternal( ConstDerivedInfoPtr derivedCreateInfo )                            = 0;
     virtual AssetStatus IsAssetOutOfDateInternal( ConstDerivedInfoPtr derivedCreateInfo, time_t cacheTimestamp ) = 0;
     virtual void AddReferencedAssetsInternal( ConstDerivedInfoPtr& derivedCreateInfo ) {}
+    virtual bool GetInputFilesInternal( ConstDerivedInfoPtr derivedCreateInfo, std::vector<std::string>& inputFiles ) { return true; }
 
     virtual bool ConvertInternal( ConstDerivedInfoPtr& derivedCreateInfo )
     {
@@ -38,6 +38,12 @@ AssetStatus FontConverter::IsAssetOutOfDateInternal( ConstDerivedInfoPtr info, t
     return AssetStatus::UP_TO_DATE;
 }
 
+bool FontConverter::GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles )
+{
+    inputFiles.push_back( GetAbsPath_FontFilename( info->filename ) );
+    return true;
+}
+
 #define DEBUG_ATLAS NOT_IN_USE
 #define MTSDF IN_USE
 
@@ -15,6 +15,7 @@ public:
 protected:
     std::string GetCacheNameInternal( ConstDerivedInfoPtr info ) override;
     AssetStatus IsAssetOutOfDateInternal( ConstDerivedInfoPtr info, time_t cacheTimestamp ) override;
+    bool GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles ) override;
     bool ConvertInternal( ConstDerivedInfoPtr& info ) override;
 };
 
@@ -37,6 +37,8 @@ std::string GfxImageConverter::GetCacheNameInternal( ConstDerivedInfoPtr info )
         HashCombine( hash, Underlying( info->clampHorizontal ) );
         HashCombine( hash, Underlying( info->clampVertical ) );
         HashCombine( hash, Underlying( info->filterMode ) );
+        if ( info->rdoLambda > 0 )
+            HashCombine( hash, info->rdoLambda );
         for ( i32 i = 0; i < 6; ++i )
         {
             if ( info->filenames[i].empty() )
@@ -78,4 +80,19 @@ AssetStatus GfxImageConverter::IsAssetOutOfDateInternal( ConstDerivedInfoPtr inf
     return AssetStatus::UP_TO_DATE;
 }
 
+bool GfxImageConverter::GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles )
+{
+    for ( i32 i = 0; i < 6; ++i )
+    {
+        const std::string& filename = info->filenames[i];
+        if ( filename.empty() )
+            break;
+
+        if ( !IsImageFilenameBuiltin( filename ) )
+            inputFiles.push_back( PG_ASSET_DIR + filename );
+    }
+
+    return true;
+}
+
 } // namespace PG
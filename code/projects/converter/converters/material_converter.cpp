@@ -20,6 +20,7 @@ static std::shared_ptr<GfxImageCreateInfo> GetImgCreateInfoBase(
     imageCreateInfo->clampHorizontal = texturesetInfo->clampHorizontal;
     imageCreateInfo->clampVertical   = texturesetInfo->clampVertical;
     imageCreateInfo->flipVertically  = texturesetInfo->flipVertically;
+    imageCreateInfo->rdoLambda       = texturesetInfo->rdoLambda;
     return imageCreateInfo;
 }
 
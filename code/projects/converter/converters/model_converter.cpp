@@ -24,6 +24,9 @@ std::string ModelConverter::GetCacheNameInternal( ConstDerivedInfoPtr info )
     HashCombine( hash, info->flipTexCoordsVertically );
     HashCombine( hash, info->recalculateNormals );
     HashCombine( hash, info->centerModel );
+    HashCombine( hash, info->generateMeshletLODs );
+    HashCombine( hash, info->encodeStreams );
+    HashCombine( hash, info->optimizeVertexOrder );
     HashCombine( hash, MAX_VERTS_PER_MESHLET );
     HashCombine( hash, MAX_TRIS_PER_MESHLET );
     HashCombine( hash, PACKED_VERTS ); // temporary, for experimenting
@@ -40,4 +43,10 @@ AssetStatus ModelConverter::IsAssetOutOfDateInternal( ConstDerivedInfoPtr info,
     return IsFileOutOfDate( cacheTimestamp, absPath ) ? AssetStatus::OUT_OF_DATE : AssetStatus::UP_TO_DATE;
 }
 
+bool ModelConverter::GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles )
+{
+    inputFiles.push_back( GetAbsPath_ModelFilename( info->filename ) );
+    return true;
+}
+
 } // namespace PG
@@ -18,4 +18,10 @@ AssetStatus ScriptConverter::IsAssetOutOfDateInternal( ConstDerivedInfoPtr info,
     return IsFileOutOfDate( cacheTimestamp, absFilename ) ? AssetStatus::OUT_OF_DATE : AssetStatus::UP_TO_DATE;
 }
 
+bool ScriptConverter::GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles )
+{
+    inputFiles.push_back( GetAbsPath_ScriptFilename( info->filename ) );
+    return true;
+}
+
 } // namespace PG
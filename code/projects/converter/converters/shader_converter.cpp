@@ -88,12 +88,114 @@ void PG::AddIncludeCacheEntry( const ShaderCreateInfo* createInfo, const ShaderP
 }
 #endif // #else // #if USING( SHADER_INCLUDE_CACHE )
 
+static const std::string SPIRV_CACHE_DIR = PG_ASSET_DIR "cache/spirv/";
+
+// Bump SPIRV_CACHE_VERSION whenever the layout of the cache files changes
+static constexpr u32 SPIRV_CACHE_MAGIC   = 0x56525053; // "SPRV"
+static constexpr u32 SPIRV_CACHE_VERSION = 1;
+
+// Entries with the wrong magic/version, or whose sizes don't match the file, are treated as misses (and then overwritten)
+struct SpirvCacheHeader
+{
+    u32 magic;
+    u32 version;
+    u64 spirvSizeInBytes;
+    u64 dataSize; // everything after the header
+};
+
+static std::string GetSpirvCachePath( u64 key )
+{
+    char filename[32];
+    snprintf( filename, sizeof( filename ), "%016llx.spv", (unsigned long long)key );
+    return SPIRV_CACHE_DIR + filename;
+}
+
+// Has to match what AddCachedSpirv writes
+static u64 GetSpirvCacheDataSize( const std::vector<u32>& spirv, const PG::ShaderReflectData& reflectData )
+{
+    u64 size = sizeof( reflectData.workgroupSize ) + sizeof( reflectData.pushConstantSize ) + sizeof( reflectData.pushConstantOffset );
+    size += sizeof( size_t );
+    for ( const std::string& ext : reflectData.extensions )
+        size += sizeof( u32 ) + ext.length();
+    size += sizeof( size_t ) + reflectData.capabilities.size() * sizeof( i32 );
+    size += sizeof( size_t ) + spirv.size() * sizeof( u32 );
+
+    return size;
+}
+
+bool PG::GetCachedSpirv( u64 key, std::vector<u32>& spirv, ShaderReflectData& reflectData )
+{
+    std::string path = GetSpirvCachePath( key );
+    Serializer serializer;
+    if ( !PathExists( path ) || !serializer.OpenForRead( path ) )
+        return false;
+
+    SpirvCacheHeader header;
+    if ( serializer.BytesLeft() < sizeof( header ) )
+        return false;
+    serializer.Read( header );
+    if ( header.magic != SPIRV_CACHE_MAGIC || header.version != SPIRV_CACHE_VERSION || header.dataSize != serializer.BytesLeft() )
+        return false;
+
+    serializer.Read( reflectData.workgroupSize );
+    serializer.Read( reflectData.pushConstantSize );
+    serializer.Read( reflectData.pushConstantOffset );
+    serializer.Read( reflectData.extensions );
+    serializer.Read( reflectData.capabilities );
+    serializer.Read( spirv );
+    serializer.Close();
+    if ( spirv.empty() || 4 * spirv.size() != header.spirvSizeInBytes )
+        return false;
+
+    // bump the timestamp, so that the asset cache GC knows this entry is still in use
+    std::error_code ec;
+    std::filesystem::last_write_time( path, std::filesystem::file_time_type::clock::now(), ec );
+
+    return true;
+}
+
+void PG::AddCachedSpirv( u64 key, const std::vector<u32>& spirv, const ShaderReflectData& reflectData )
+{
+    // Permutations with the same key can compile in parallel, so write to a unique temporary file first. It still ends
+    // with _tmp, so that the asset cache GC cleans it up if the converter dies before the rename
+    std::string path    = GetSpirvCachePath( key );
+    std::string tmpPath = path + GetUniqueTmpSuffix() + "_tmp";
+    Serializer serializer;
+    if ( !serializer.OpenForWrite( tmpPath ) )
+    {
+        LOG_WARN( "Failed to write spirv cache entry %s", path.c_str() );
+        return;
+    }
+
+    SpirvCacheHeader header;
+    header.magic            = SPIRV_CACHE_MAGIC;
+    header.version          = SPIRV_CACHE_VERSION;
+    header.spirvSizeInBytes = 4 * spirv.size();
+    header.dataSize         = GetSpirvCacheDataSize( spirv, reflectData );
+    serializer.Write( header );
+    serializer.Write( reflectData.workgroupSize );
+    serializer.Write( reflectData.pushConstantSize );
+    serializer.Write( reflectData.pushConstantOffset );
+    serializer.Write( reflectData.extensions );
+    serializer.Write( reflectData.capabilities );
+    serializer.Write( spirv );
+    serializer.Close();
+    if ( !RenameFile( tmpPath, path ) )
+        DeleteFile( tmpPath );
+}
+
 namespace PG
 {
 
 std::string ShaderConverter::GetCacheNameInternal( ConstDerivedInfoPtr info )
 {
-    return GetShaderCacheName( info->filename, info->shaderStage, info->defines );
+    std::string cacheName = GetShaderCacheName( info->filename, info->shaderStage, info->defines );
+    if ( g_converterConfigOptions.shaderOptimization != ShaderOptimization::NONE )
+        cacheName += "_O" + std::to_string( Underlying( g_converterConfigOptions.shaderOptimization ) );
+    if ( g_converterConfigOptions.stripShaderDebugInfo )
+        cacheName += "_s";
+
+    return cacheName;
 }
 
 AssetStatus ShaderConverter::IsAssetOutOfDateInternal( ConstDerivedInfoPtr info, time_t cacheTimestamp )
@@ -119,4 +221,15 @@ AssetStatus ShaderConverter::IsAssetOutOfDateInternal( ConstDerivedInfoPtr info,
     return AssetStatus::OUT_OF_DATE;
 }
 
+bool ShaderConverter::GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles )
+{
+#if USING( SHADER_INCLUDE_CACHE )
+    return GetIncludeCacheEntry( info->cacheName, inputFiles );
+#else  // #if USING( SHADER_INCLUDE_CACHE )
+    PG_UNUSED( info );
+    PG_UNUSED( inputFiles );
+    return false;
+#endif // #else // #if USING( SHADER_INCLUDE_CACHE )
+}
+
 } // namespace PG
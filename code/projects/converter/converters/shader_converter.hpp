@@ -12,6 +12,11 @@ void CloseShaderIncludeCache();
 
 void AddIncludeCacheEntry( const ShaderCreateInfo* createInfo, const ShaderPreprocessOutput& preprocOutput );
 
+// Second level cache for compiled spirv + reflection data, keyed by a hash of the preprocessed source + compile options.
+// Shaders whose preprocessed source is identical (ex: permutations with unused defines) only get compiled once
+bool GetCachedSpirv( u64 key, std::vector<u32>& spirv, ShaderReflectData& reflectData );
+void AddCachedSpirv( u64 key, const std::vector<u32>& spirv, const ShaderReflectData& reflectData );
+
 class ShaderConverter : public BaseAssetConverterTemplate<Shader, ShaderCreateInfo>
 {
 public:
@@ -20,6 +25,7 @@ public:
 protected:
     std::string GetCacheNameInternal( ConstDerivedInfoPtr info ) override;
     AssetStatus IsAssetOutOfDateInternal( ConstDerivedInfoPtr info, time_t cacheTimestamp ) override;
+    bool GetInputFilesInternal( ConstDerivedInfoPtr info, std::vector<std::string>& inputFiles ) override;
 };
 
 } // namespace PG
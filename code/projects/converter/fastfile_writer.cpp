@@ -0,0 +1,358 @@
+#include "fastfile_writer.hpp"
+#include "asset/types/base_asset.hpp"
+#include "core/cpu_profiling.hpp"
+#include "shared/filesystem.hpp"
+#include "shared/logger.hpp"
+#include "shared/serializer.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <memory>
+
+#if USING( WINDOWS_PROGRAM )
+#include <io.h>
+#else // #if USING( WINDOWS_PROGRAM )
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+
+static constexpr size_t FALLBACK_COPY_BUFFER_SIZE = 1024 * 1024;
+
+static int OpenFileForRead( const std::string& filename )
+{
+#if USING( WINDOWS_PROGRAM )
+    return _open( filename.c_str(), _O_RDONLY | _O_BINARY );
+#else  // #if USING( WINDOWS_PROGRAM )
+    return open( filename.c_str(), O_RDONLY );
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+}
+
+static int OpenFileForWrite( const std::string& filename )
+{
+#if USING( WINDOWS_PROGRAM )
+    return _open( filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE );
+#else  // #if USING( WINDOWS_PROGRAM )
+    return open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+}
+
+static void CloseFile( int& fd )
+{
+    if ( fd < 0 )
+        return;
+#if USING( WINDOWS_PROGRAM )
+    _close( fd );
+#else  // #if USING( WINDOWS_PROGRAM )
+    close( fd );
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+    fd = -1;
+}
+
+static i64 SeekFile( int fd, i64 offset, int origin )
+{
+#if USING( WINDOWS_PROGRAM )
+    return _lseeki64( fd, offset, origin );
+#else  // #if USING( WINDOWS_PROGRAM )
+    return lseek( fd, offset, origin );
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+}
+
+static bool ReadAll( int fd, void* buffer, size_t numBytes )
+{
+    char* dst = (char*)buffer;
+    while ( numBytes )
+    {
+#if USING( WINDOWS_PROGRAM )
+        i64 bytesRead = _read( fd, dst, (unsigned int)std::min<size_t>( numBytes, FALLBACK_COPY_BUFFER_SIZE ) );
+#else  // #if USING( WINDOWS_PROGRAM )
+        i64 bytesRead = read( fd, dst, numBytes );
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+        if ( bytesRead <= 0 )
+            return false;
+        dst += bytesRead;
+        numBytes -= bytesRead;
+    }
+
+    return true;
+}
+
+static bool WriteAll( int fd, const void* buffer, size_t numBytes )
+{
+    const char* src = (const char*)buffer;
+    while ( numBytes )
+    {
+#if USING( WINDOWS_PROGRAM )
+        i64 bytesWritten = _write( fd, src, (unsigned int)std::min<size_t>( numBytes, FALLBACK_COPY_BUFFER_SIZE ) );
+#else  // #if USING( WINDOWS_PROGRAM )
+        i64 bytesWritten = write( fd, src, numBytes );
+#endif // #else // #if USING( WINDOWS_PROGRAM )
+        if ( bytesWritten <= 0 )
+            return false;
+        src += bytesWritten;
+        numBytes -= bytesWritten;
+    }
+
+    return true;
+}
+
+namespace PG
+{
+
+FastfileWriter::~FastfileWriter() { Abort(); }
+
+bool FastfileWriter::Open( const std::string& fastfilePath )
+{
+    PGP_ZONE_SCOPEDN( "FastfileWriter::Open" );
+    m_finalPath     = fastfilePath;
+    m_tmpPath       = fastfilePath + "_tmp";
+    m_pendingOffset = 0;
+    m_pendingBytes  = 0;
+    m_bytesReused   = 0;
+    m_bytesCopied   = 0;
+    m_bytesDeduped  = 0;
+    m_spirvBlobs.clear();
+    ParsePrevFastfile();
+
+    CreateDirectory( GetParentPath( m_tmpPath ) );
+    m_fd = OpenFileForWrite( m_tmpPath );
+    if ( m_fd < 0 )
+    {
+        LOG_ERR( "Could not open file '%s' for writing", m_tmpPath.c_str() );
+        CloseFile( m_prevFd );
+        return false;
+    }
+
+    return true;
+}
+
+// The fastfile is just a list of [AssetType, cached asset file] entries, and each cached asset file begins with its
+// AssetMetadata (name, hash, size), so the previous fastfile's layout can be recovered by only reading the headers
+void FastfileWriter::ParsePrevFastfile()
+{
+    for ( u32 i = 0; i < ASSET_TYPE_COUNT; ++i )
+        m_prevAssets[i].clear();
+
+    if ( !PathExists( m_finalPath ) )
+        return;
+
+    Serializer prevFastfile;
+    if ( !prevFastfile.OpenForRead( m_finalPath ) )
+        return;
+
+    const u8* data          = prevFastfile.GetData();
+    const size_t totalBytes = prevFastfile.BytesLeft();
+    size_t pos              = 0;
+    while ( pos < totalBytes )
+    {
+        const size_t entryStart = pos;
+        if ( pos + sizeof( AssetType ) + sizeof( u16 ) > totalBytes )
+            break;
+
+        AssetType assetType = (AssetType)data[pos];
+        pos += sizeof( AssetType );
+        u16 nameLen;
+        memcpy( &nameLen, data + pos, sizeof( u16 ) );
+        pos += sizeof( u16 );
+        if ( assetType >= ASSET_TYPE_COUNT || pos + nameLen + 2 * sizeof( u64 ) > totalBytes )
+            break;
+
+        std::string name( (const char*)data + pos, nameLen );
+        pos += nameLen;
+        PrevAssetEntry entry;
+        memcpy( &entry.hash, data + pos, sizeof( u64 ) );
+        pos += sizeof( u64 );
+        memcpy( &entry.size, data + pos, sizeof( u64 ) );
+        pos += sizeof( u64 );
+        if ( entry.size > totalBytes - pos )
+            break;
+
+        pos += entry.size;
+        entry.offset                  = entryStart;
+        entry.numBytes                = pos - entryStart;
+        m_prevAssets[assetType][name] = entry;
+    }
+
+    if ( pos != totalBytes )
+    {
+        LOG_WARN( "Previous fastfile '%s' looks corrupted, not reusing any of it", m_finalPath.c_str() );
+        for ( u32 i = 0; i < ASSET_TYPE_COUNT; ++i )
+            m_prevAssets[i].clear();
+        return;
+    }
+
+    m_prevFd = OpenFileForRead( m_finalPath );
+}
+
+bool FastfileWriter::AddAsset( AssetType assetType, const std::string& cachedAssetPath )
+{
+    int srcFd = OpenFileForRead( cachedAssetPath );
+    if ( srcFd < 0 )
+        return false;
+
+    const i64 fileSize = SeekFile( srcFd, 0, SEEK_END );
+    bool success       = fileSize > 0 && SeekFile( srcFd, 0, SEEK_SET ) == 0;
+
+    // Only the metadata is needed to tell if the previous fastfile's copy of this asset is still valid
+    AssetMetadata metadata;
+    u16 nameLen = 0;
+    success     = success && ReadAll( srcFd, &nameLen, sizeof( u16 ) );
+    if ( success )
+    {
+        metadata.name.resize( nameLen );
+        success = ReadAll( srcFd, metadata.name.data(), nameLen );
+        success = success && ReadAll( srcFd, &metadata.hash, sizeof( u64 ) );
+        success = success && ReadAll( srcFd, &metadata.size, sizeof( u64 ) );
+    }
+    // Shaders start with their spirv hash + size, and end with the spirv itself (see Shader::FastfileSave)
+    u64 spirvHash = 0;
+    u64 spirvSize = 0;
+    if ( success && assetType == ASSET_TYPE_SHADER )
+    {
+        success = ReadAll( srcFd, &spirvHash, sizeof( u64 ) ) && ReadAll( srcFd, &spirvSize, sizeof( u64 ) );
+        success = success && metadata.size >= 2 * sizeof( u64 ) + spirvSize;
+    }
+    if ( !success )
+    {
+        LOG_ERR( "Cached asset '%s' is empty or corrupted", cachedAssetPath.c_str() );
+        CloseFile( srcFd );
+        return false;
+    }
+
+    if ( spirvSize && !m_spirvBlobs.insert( spirvHash ).second )
+    {
+        success = AddShaderWithoutSpirv( srcFd, metadata, spirvHash, spirvSize );
+        CloseFile( srcFd );
+        return success;
+    }
+
+    const size_t entryBytes = sizeof( AssetType ) + (size_t)fileSize;
+    auto it                 = m_prevAssets[assetType].find( metadata.name );
+    if ( m_prevFd >= 0 && it != m_prevAssets[assetType].end() )
+    {
+        const PrevAssetEntry& prevEntry = it->second;
+        if ( prevEntry.hash == metadata.hash && prevEntry.size == metadata.size && prevEntry.numBytes == entryBytes )
+        {
+            CloseFile( srcFd );
+            m_bytesReused += entryBytes;
+            if ( m_pendingBytes && m_pendingOffset + m_pendingBytes == prevEntry.offset )
+            {
+                m_pendingBytes += entryBytes;
+                return true;
+            }
+
+            if ( !FlushPendingRange() )
+                return false;
+            m_pendingOffset = prevEntry.offset;
+            m_pendingBytes  = entryBytes;
+            return true;
+        }
+    }
+
+    success = FlushPendingRange();
+    success = success && WriteAll( m_fd, &assetType, sizeof( AssetType ) );
+    success = success && CopyRange( srcFd, 0, (size_t)fileSize );
+    CloseFile( srcFd );
+    m_bytesCopied += entryBytes;
+
+    return success;
+}
+
+// The spirv of this shader is identical to one already in the fastfile, so write everything but the spirv, with a size of 0.
+// The engine then looks up the spirv from the earlier shader by its hash
+bool FastfileWriter::AddShaderWithoutSpirv( int srcFd, const AssetMetadata& metadata, u64 spirvHash, u64 spirvSize )
+{
+    const AssetType assetType = ASSET_TYPE_SHADER;
+    const u16 nameLen         = (u16)metadata.name.length();
+    const u64 newSize         = metadata.size - spirvSize;
+    const u64 newSpirvSize    = 0;
+    const size_t headerBytes  = sizeof( u16 ) + nameLen + 2 * sizeof( u64 );
+
+    bool success = FlushPendingRange();
+    success      = success && WriteAll( m_fd, &assetType, sizeof( AssetType ) );
+    success      = success && WriteAll( m_fd, &nameLen, sizeof( u16 ) ) && WriteAll( m_fd, metadata.name.data(), nameLen );
+    success      = success && WriteAll( m_fd, &metadata.hash, sizeof( u64 ) ) && WriteAll( m_fd, &newSize, sizeof( u64 ) );
+    success      = success && WriteAll( m_fd, &spirvHash, sizeof( u64 ) ) && WriteAll( m_fd, &newSpirvSize, sizeof( u64 ) );
+    success      = success && CopyRange( srcFd, headerBytes + 2 * sizeof( u64 ), newSize - 2 * sizeof( u64 ) );
+    m_bytesCopied += sizeof( AssetType ) + headerBytes + newSize;
+    m_bytesDeduped += spirvSize;
+
+    return success;
+}
+
+bool FastfileWriter::FlushPendingRange()
+{
+    if ( !m_pendingBytes )
+        return true;
+
+    bool success   = CopyRange( m_prevFd, m_pendingOffset, m_pendingBytes );
+    m_pendingBytes = 0;
+    return success;
+}
+
+bool FastfileWriter::CopyRange( int srcFd, size_t srcOffset, size_t numBytes )
+{
+#if USING( LINUX_PROGRAM )
+    // Both of these append at m_fd's current file position, same as the write() calls do
+    off_t inOffset = (off_t)srcOffset;
+    while ( numBytes )
+    {
+        ssize_t copied = copy_file_range( srcFd, &inOffset, m_fd, nullptr, numBytes, 0 );
+        if ( copied <= 0 )
+            break;
+        numBytes -= copied;
+    }
+
+    // copy_file_range can fail across filesystems on older kernels, but sendfile still avoids the userspace copy
+    while ( numBytes )
+    {
+        ssize_t copied = sendfile( m_fd, srcFd, &inOffset, numBytes );
+        if ( copied <= 0 )
+            break;
+        numBytes -= copied;
+    }
+
+    if ( !numBytes )
+        return true;
+    srcOffset = (size_t)inOffset;
+#endif // #if USING( LINUX_PROGRAM )
+
+    if ( SeekFile( srcFd, (i64)srcOffset, SEEK_SET ) < 0 )
+        return false;
+
+    std::unique_ptr<char[]> buffer( new char[FALLBACK_COPY_BUFFER_SIZE] );
+    while ( numBytes )
+    {
+        size_t toCopy = std::min( numBytes, FALLBACK_COPY_BUFFER_SIZE );
+        if ( !ReadAll( srcFd, buffer.get(), toCopy ) || !WriteAll( m_fd, buffer.get(), toCopy ) )
+            return false;
+        numBytes -= toCopy;
+    }
+
+    return true;
+}
+
+bool FastfileWriter::Close()
+{
+    bool success = FlushPendingRange();
+    CloseFile( m_prevFd );
+    CloseFile( m_fd );
+    if ( !success || !RenameFile( m_tmpPath, m_finalPath ) )
+    {
+        LOG_ERR( "Failed to finalize fastfile '%s'", m_finalPath.c_str() );
+        DeleteFile( m_tmpPath );
+        return false;
+    }
+
+    return true;
+}
+
+void FastfileWriter::Abort()
+{
+    CloseFile( m_prevFd );
+    if ( m_fd >= 0 )
+    {
+        CloseFile( m_fd );
+        DeleteFile( m_tmpPath );
+    }
+}
+
+} // namespace PG
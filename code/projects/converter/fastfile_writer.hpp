@@ -0,0 +1,65 @@
+#pragma once
+
+#include "asset/asset_versions.hpp"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace PG
+{
+
+struct AssetMetadata;
+
+// Assembles a fastfile by streaming the cached asset files straight into the output file (copy_file_range/sendfile
+// on linux, plain buffered copies otherwise), instead of reading each asset into memory first.
+// If a previous version of the fastfile exists, any assets whose cached contents haven't changed are copied out of
+// the old fastfile instead, coalescing neighboring unchanged assets into a single range copy.
+// Shaders whose spirv is identical to an earlier shader in the fastfile are written without their spirv.
+// The new fastfile is written to a temporary file, and only replaces the old one once Close() succeeds
+class FastfileWriter
+{
+public:
+    FastfileWriter() = default;
+    ~FastfileWriter();
+
+    FastfileWriter( const FastfileWriter& )            = delete;
+    FastfileWriter& operator=( const FastfileWriter& ) = delete;
+
+    bool Open( const std::string& fastfilePath );
+    bool AddAsset( AssetType assetType, const std::string& cachedAssetPath );
+    bool Close();
+    void Abort();
+
+    size_t BytesReused() const { return m_bytesReused; }
+    size_t BytesCopied() const { return m_bytesCopied; }
+    size_t BytesDeduped() const { return m_bytesDeduped; }
+
+private:
+    struct PrevAssetEntry
+    {
+        size_t offset; // offset of the AssetType byte preceding the asset in the previous fastfile
+        size_t numBytes;
+        u64 hash;
+        u64 size;
+    };
+
+    void ParsePrevFastfile();
+    bool AddShaderWithoutSpirv( int srcFd, const AssetMetadata& metadata, u64 spirvHash, u64 spirvSize );
+    bool FlushPendingRange();
+    bool CopyRange( int srcFd, size_t srcOffset, size_t numBytes );
+
+    std::string m_finalPath;
+    std::string m_tmpPath;
+    int m_fd     = -1;
+    int m_prevFd = -1;
+    std::unordered_map<std::string, PrevAssetEntry> m_prevAssets[ASSET_TYPE_COUNT];
+    std::unordered_set<u64> m_spirvBlobs;
+
+    size_t m_pendingOffset = 0;
+    size_t m_pendingBytes  = 0;
+    size_t m_bytesReused   = 0;
+    size_t m_bytesCopied   = 0;
+    size_t m_bytesDeduped  = 0;
+};
+
+} // namespace PG
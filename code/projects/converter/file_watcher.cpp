@@ -0,0 +1,189 @@
+#include "file_watcher.hpp"
+#include "shared/filesystem.hpp"
+#include "shared/logger.hpp"
+#include "shared/platform_defines.hpp"
+#include <algorithm>
+
+#if USING( LINUX_PROGRAM )
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static constexpr u32 WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF | IN_DELETE_SELF;
+#endif // #if USING( LINUX_PROGRAM )
+
+namespace PG
+{
+
+FileWatcher::~FileWatcher() { Shutdown(); }
+
+bool FileWatcher::Init( const std::string& rootDir, const std::vector<std::string>& ignoredDirs )
+{
+#if USING( LINUX_PROGRAM )
+    m_ignoredDirs = ignoredDirs;
+    m_fd          = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( m_fd < 0 )
+    {
+        LOG_ERR( "FileWatcher: inotify_init1 failed" );
+        return false;
+    }
+
+    if ( !AddWatchRecursive( rootDir ) )
+    {
+        Shutdown();
+        return false;
+    }
+
+    return true;
+#else  // #if USING( LINUX_PROGRAM )
+    PG_UNUSED( rootDir );
+    PG_UNUSED( ignoredDirs );
+    LOG_ERR( "FileWatcher: not implemented on this platform" );
+    return false;
+#endif // #else // #if USING( LINUX_PROGRAM )
+}
+
+void FileWatcher::Shutdown()
+{
+#if USING( LINUX_PROGRAM )
+    if ( m_fd >= 0 )
+        close( m_fd );
+#endif // #if USING( LINUX_PROGRAM )
+    m_fd = -1;
+    m_watchDirs.clear();
+}
+
+bool FileWatcher::IsIgnored( const std::string& path ) const
+{
+    return std::any_of(
+        m_ignoredDirs.begin(), m_ignoredDirs.end(), [&path]( const std::string& ignored ) { return path.starts_with( ignored ); } );
+}
+
+bool FileWatcher::AddWatchRecursive( const std::string& dir )
+{
+#if USING( LINUX_PROGRAM )
+    std::string dirPath = BackToForwardSlashes( dir );
+    if ( !dirPath.empty() && dirPath.back() != '/' )
+        dirPath += '/';
+    if ( IsIgnored( dirPath ) )
+        return true;
+
+    int wd = inotify_add_watch( m_fd, dirPath.c_str(), WATCH_MASK );
+    if ( wd < 0 )
+    {
+        LOG_ERR( "FileWatcher: could not watch directory '%s'. Might need to raise fs.inotify.max_user_watches", dirPath.c_str() );
+        return false;
+    }
+    m_watchDirs[wd] = dirPath;
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for ( const auto& entry : fs::directory_iterator( dirPath, ec ) )
+    {
+        if ( entry.is_directory() && !AddWatchRecursive( entry.path().string() ) )
+            return false;
+    }
+#else  // #if USING( LINUX_PROGRAM )
+    PG_UNUSED( dir );
+#endif // #else // #if USING( LINUX_PROGRAM )
+
+    return true;
+}
+
+void FileWatcher::RemoveWatchesUnder( const std::string& dirPath )
+{
+#if USING( LINUX_PROGRAM )
+    for ( auto it = m_watchDirs.begin(); it != m_watchDirs.end(); )
+    {
+        if ( it->second.starts_with( dirPath ) )
+        {
+            inotify_rm_watch( m_fd, it->first );
+            it = m_watchDirs.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+#else  // #if USING( LINUX_PROGRAM )
+    PG_UNUSED( dirPath );
+#endif // #else // #if USING( LINUX_PROGRAM )
+}
+
+void FileWatcher::ReadEvents( std::vector<std::string>& changedFiles )
+{
+#if USING( LINUX_PROGRAM )
+    alignas( inotify_event ) char buffer[16 * 1024];
+    ssize_t len;
+    while ( ( len = read( m_fd, buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        for ( char* ptr = buffer; ptr < buffer + len; )
+        {
+            const inotify_event* event = (const inotify_event*)ptr;
+            ptr += sizeof( inotify_event ) + event->len;
+
+            auto it = m_watchDirs.find( event->wd );
+            if ( it == m_watchDirs.end() )
+                continue;
+
+            // The kernel already dropped the watch (IN_IGNORED), or the directory is gone. A directory moved somewhere else
+            // usually had its watches dropped at the IN_MOVED_FROM below, but not if it was the root or the event was missed
+            if ( event->mask & IN_IGNORED )
+            {
+                m_watchDirs.erase( it );
+                continue;
+            }
+            if ( event->mask & ( IN_DELETE_SELF | IN_MOVE_SELF ) )
+            {
+                RemoveWatchesUnder( std::string( it->second ) );
+                continue;
+            }
+            if ( event->len == 0 )
+                continue;
+
+            std::string path = it->second + event->name;
+            if ( event->mask & IN_ISDIR )
+            {
+                // The old paths are stale after a rename, so drop the watches under it. If it was moved within the watched
+                // tree, the IN_MOVED_TO re-adds them with the new paths. New directories need their own watches too,
+                // or else files added to them later are missed
+                if ( event->mask & IN_MOVED_FROM )
+                    RemoveWatchesUnder( path + '/' );
+                if ( event->mask & ( IN_CREATE | IN_MOVED_TO ) )
+                    AddWatchRecursive( path );
+                continue;
+            }
+
+            if ( !IsIgnored( path ) && std::find( changedFiles.begin(), changedFiles.end(), path ) == changedFiles.end() )
+                changedFiles.push_back( path );
+        }
+    }
+#else  // #if USING( LINUX_PROGRAM )
+    PG_UNUSED( changedFiles );
+#endif // #else // #if USING( LINUX_PROGRAM )
+}
+
+std::vector<std::string> FileWatcher::WaitForChanges( i32 timeoutMs, i32 debounceMs )
+{
+    std::vector<std::string> changedFiles;
+#if USING( LINUX_PROGRAM )
+    if ( m_fd < 0 )
+        return changedFiles;
+
+    pollfd pfd = { m_fd, POLLIN, 0 };
+    if ( poll( &pfd, 1, timeoutMs ) <= 0 )
+        return changedFiles;
+
+    do
+    {
+        ReadEvents( changedFiles );
+    } while ( poll( &pfd, 1, debounceMs ) > 0 );
+#else  // #if USING( LINUX_PROGRAM )
+    PG_UNUSED( timeoutMs );
+    PG_UNUSED( debounceMs );
+#endif // #else // #if USING( LINUX_PROGRAM )
+
+    return changedFiles;
+}
+
+} // namespace PG
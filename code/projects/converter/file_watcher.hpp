@@ -0,0 +1,43 @@
+#pragma once
+
+#include "shared/core_defines.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PG
+{
+
+// Recursively watches a directory for files that are written, created, moved or deleted. Currently only implemented
+// with inotify on linux, Init() just fails on other platforms
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher( const FileWatcher& )            = delete;
+    FileWatcher& operator=( const FileWatcher& ) = delete;
+
+    // Any directories that start with one of the ignoredDirs are not watched (ex: the asset cache)
+    bool Init( const std::string& rootDir, const std::vector<std::string>& ignoredDirs = {} );
+    void Shutdown();
+
+    // Waits up to timeoutMs for a file to change. Once something changes, it keeps collecting changes until no new
+    // ones come in for debounceMs, since editors often save a file in multiple steps. Returns the absolute paths
+    // of all the changed files, or an empty list if nothing changed before the timeout
+    std::vector<std::string> WaitForChanges( i32 timeoutMs, i32 debounceMs );
+
+private:
+    bool AddWatchRecursive( const std::string& dir );
+    bool IsIgnored( const std::string& path ) const;
+    // Removes the watches of dirPath and every directory under it
+    void RemoveWatchesUnder( const std::string& dirPath );
+    void ReadEvents( std::vector<std::string>& changedFiles );
+
+    int m_fd = -1;
+    std::vector<std::string> m_ignoredDirs;
+    std::unordered_map<int, std::string> m_watchDirs;
+};
+
+} // namespace PG
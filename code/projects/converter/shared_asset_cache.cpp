@@ -0,0 +1,556 @@
+#include "shared_asset_cache.hpp"
+#include "asset/asset_cache.hpp"
+#include "core/cpu_profiling.hpp"
+#include "shared/filesystem.hpp"
+#include "shared/logger.hpp"
+#include "shared/sockets.hpp"
+#include "xxHash/xxhash.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+static constexpr size_t TRANSFER_CHUNK_SIZE            = 64 * 1024;
+static constexpr u64 SHARED_CACHE_MISS                 = ~0ull;
+static constexpr int SOCKET_TIMEOUT_MS                 = 30000;
+static constexpr u32 SERVER_WORKER_THREADS             = 8;
+static constexpr size_t SERVER_MAX_PENDING_CONNECTIONS = 64;
+static constexpr int SERVER_POLL_INTERVAL_MS           = 250;
+
+enum class SharedCacheOp : u8
+{
+    GET = 0,
+    PUT = 1,
+};
+
+static const char* s_keyPrefixes[ASSET_TYPE_COUNT] = {
+    "images/",      // ASSET_TYPE_GFX_IMAGE
+    "materials/",   // ASSET_TYPE_MATERIAL
+    "scripts/",     // ASSET_TYPE_SCRIPT
+    "models/",      // ASSET_TYPE_MODEL
+    "shaders/",     // ASSET_TYPE_SHADER
+    "pipelines/",   // ASSET_TYPE_PIPELINE
+    "fonts/",       // ASSET_TYPE_FONT
+    "texturesets/", // ASSET_TYPE_TEXTURESET
+};
+static_assert( ASSET_TYPE_COUNT == 8 );
+
+// Keys come over the network when running the server, so make sure they can't point outside of the cache directory
+static bool IsValidKey( const std::string& key )
+{
+    if ( key.empty() || key.length() > 256 || key[0] == '/' || key.find( ".." ) != std::string::npos )
+        return false;
+
+    for ( char c : key )
+    {
+        if ( !( ( c >= 'a' && c <= 'z' ) || ( c >= '0' && c <= '9' ) || c == '_' || c == '/' ) )
+            return false;
+    }
+
+    return true;
+}
+
+static bool HashFile( XXH64_state_t* state, const std::string& filename )
+{
+    std::ifstream in( filename, std::ios::binary );
+    if ( !in )
+        return false;
+
+    std::unique_ptr<char[]> buffer( new char[TRANSFER_CHUNK_SIZE] );
+    while ( in )
+    {
+        in.read( buffer.get(), TRANSFER_CHUNK_SIZE );
+        XXH64_update( state, buffer.get(), (size_t)in.gcount() );
+    }
+
+    return in.eof();
+}
+
+static bool SendAll( ClientSocket& socket, const void* data, size_t numBytes )
+{
+    const char* src = (const char*)data;
+    while ( numBytes )
+    {
+        int toSend = (int)std::min( numBytes, TRANSFER_CHUNK_SIZE );
+        if ( !socket.SendData( src, toSend ) )
+            return false;
+        src += toSend;
+        numBytes -= toSend;
+    }
+
+    return true;
+}
+
+static bool ReceiveAll( ClientSocket& socket, void* buffer, size_t numBytes )
+{
+    char* dst = (char*)buffer;
+    while ( numBytes )
+    {
+        int received = socket.ReceiveData( dst, (int)std::min( numBytes, TRANSFER_CHUNK_SIZE ) );
+        if ( received <= 0 )
+            return false;
+        dst += received;
+        numBytes -= received;
+    }
+
+    return true;
+}
+
+// The file size is sent first, then the contents, and then an XXH64 of the contents. If reading the file fails partway
+// through, the trailing hash is never sent, so the receiver can't mistake a truncated file for a complete one
+static bool SendFile( ClientSocket& socket, const std::string& filename, size_t& numBytes )
+{
+    std::ifstream in( filename, std::ios::binary | std::ios::ate );
+    if ( !in )
+        return false;
+
+    u64 fileSize = (u64)in.tellg();
+    in.seekg( 0 );
+    if ( !SendAll( socket, &fileSize, sizeof( u64 ) ) )
+        return false;
+
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset( state, 0 );
+    bool success = true;
+    std::unique_ptr<char[]> buffer( new char[TRANSFER_CHUNK_SIZE] );
+    for ( u64 bytesLeft = fileSize; bytesLeft && success; )
+    {
+        size_t toSend = (size_t)std::min<u64>( bytesLeft, TRANSFER_CHUNK_SIZE );
+        success       = in.read( buffer.get(), toSend ) && SendAll( socket, buffer.get(), toSend );
+        XXH64_update( state, buffer.get(), toSend );
+        bytesLeft -= toSend;
+    }
+    u64 hash = XXH64_digest( state );
+    XXH64_freeState( state );
+    if ( !success || !SendAll( socket, &hash, sizeof( u64 ) ) )
+        return false;
+    numBytes = (size_t)fileSize;
+
+    return true;
+}
+
+static bool ReceiveFile( ClientSocket& socket, u64 fileSize, const std::string& filename )
+{
+    CreateDirectory( GetParentPath( filename ) );
+    std::ofstream out( filename, std::ios::binary );
+    if ( !out )
+        return false;
+
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset( state, 0 );
+    bool success = true;
+    std::unique_ptr<char[]> buffer( new char[TRANSFER_CHUNK_SIZE] );
+    for ( u64 bytesLeft = fileSize; bytesLeft && success; )
+    {
+        size_t toReceive = (size_t)std::min<u64>( bytesLeft, TRANSFER_CHUNK_SIZE );
+        success          = ReceiveAll( socket, buffer.get(), toReceive ) && out.write( buffer.get(), toReceive );
+        XXH64_update( state, buffer.get(), toReceive );
+        bytesLeft -= toReceive;
+    }
+    u64 expectedHash = 0;
+    u64 hash         = XXH64_digest( state );
+    XXH64_freeState( state );
+    if ( !success || !ReceiveAll( socket, &expectedHash, sizeof( u64 ) ) )
+        return false;
+    if ( hash != expectedHash )
+    {
+        LOG_WARN( "Shared asset cache: checksum mismatch while receiving '%s'", filename.c_str() );
+        return false;
+    }
+    out.close();
+
+    return !out.fail();
+}
+
+// Parses "host[:port]"
+static bool ParseHostAndPort( const std::string& address, std::string& host, int& port )
+{
+    host         = address;
+    port         = PG::SHARED_CACHE_DEFAULT_PORT;
+    size_t colon = host.find( ':' );
+    if ( colon != std::string::npos )
+    {
+        port = atoi( host.c_str() + colon + 1 );
+        host = host.substr( 0, colon );
+    }
+
+    return !host.empty() && port > 0;
+}
+
+static bool SendRequestHeader( ClientSocket& socket, SharedCacheOp op, const std::string& key )
+{
+    u16 keyLen = (u16)key.length();
+    return SendAll( socket, &op, sizeof( op ) ) && SendAll( socket, &keyLen, sizeof( keyLen ) ) && SendAll( socket, key.data(), keyLen );
+}
+
+namespace PG
+{
+
+DirectorySharedCacheStore::DirectorySharedCacheStore( const std::string& rootDir ) : m_rootDir( BackToForwardSlashes( rootDir ) )
+{
+    if ( !m_rootDir.empty() && m_rootDir.back() != '/' )
+        m_rootDir += '/';
+}
+
+bool DirectorySharedCacheStore::Get( const std::string& key, const std::string& dstPath, size_t& numBytes )
+{
+    std::string path = m_rootDir + key;
+    std::error_code ec;
+    numBytes = (size_t)std::filesystem::file_size( path, ec );
+    if ( ec || !numBytes )
+        return false;
+
+    return std::filesystem::copy_file( path, dstPath, std::filesystem::copy_options::overwrite_existing, ec ) && !ec;
+}
+
+bool DirectorySharedCacheStore::Put( const std::string& key, const std::string& srcPath, size_t& numBytes )
+{
+    // Keys are content hashes, so if it already exists, another machine already published the exact same asset
+    numBytes              = 0;
+    std::string finalPath = m_rootDir + key;
+    if ( PathExists( finalPath ) )
+        return true;
+
+    std::string tmpPath = finalPath + GetUniqueTmpSuffix();
+    CreateDirectory( GetParentPath( finalPath ) );
+    std::error_code ec;
+    if ( !std::filesystem::copy_file( srcPath, tmpPath, std::filesystem::copy_options::overwrite_existing, ec ) || ec )
+    {
+        DeleteFile( tmpPath );
+        return false;
+    }
+    if ( !RenameFile( tmpPath, finalPath ) )
+    {
+        DeleteFile( tmpPath );
+        return false;
+    }
+    numBytes = (size_t)std::filesystem::file_size( finalPath, ec );
+
+    return true;
+}
+
+bool TcpSharedCacheStore::Get( const std::string& key, const std::string& dstPath, size_t& numBytes )
+{
+    ClientSocket socket;
+    if ( !socket.OpenSocket( m_host.c_str(), m_port ) || !socket.OpenConnection() )
+        return false;
+    socket.SetNonblockingRecv( SOCKET_TIMEOUT_MS );
+
+    u64 fileSize;
+    if ( !SendRequestHeader( socket, SharedCacheOp::GET, key ) || !ReceiveAll( socket, &fileSize, sizeof( u64 ) ) )
+        return false;
+    if ( fileSize == SHARED_CACHE_MISS || !ReceiveFile( socket, fileSize, dstPath ) )
+        return false;
+    numBytes = (size_t)fileSize;
+
+    return true;
+}
+
+bool TcpSharedCacheStore::Put( const std::string& key, const std::string& srcPath, size_t& numBytes )
+{
+    ClientSocket socket;
+    if ( !socket.OpenSocket( m_host.c_str(), m_port ) || !socket.OpenConnection() )
+        return false;
+    socket.SetNonblockingRecv( SOCKET_TIMEOUT_MS );
+
+    u8 status = 0;
+    if ( !SendRequestHeader( socket, SharedCacheOp::PUT, key ) || !SendFile( socket, srcPath, numBytes ) )
+        return false;
+
+    return ReceiveAll( socket, &status, sizeof( status ) ) && status;
+}
+
+} // namespace PG
+
+namespace PG::SharedAssetCache
+{
+
+static std::unique_ptr<SharedCacheStore> s_store;
+static std::atomic<u32> s_hits;
+static std::atomic<u32> s_misses;
+static std::atomic<u32> s_publishes;
+static std::atomic<u32> s_failedPublishes;
+static std::atomic<size_t> s_bytesFetched;
+static std::atomic<size_t> s_bytesPublished;
+
+bool Init( const std::string& location )
+{
+    if ( location.starts_with( "tcp:" ) )
+    {
+        std::string host;
+        int port;
+        if ( !ParseHostAndPort( location.substr( 4 ), host, port ) )
+        {
+            LOG_ERR( "Invalid shared cache location '%s'. Expected 'tcp:host[:port]'", location.c_str() );
+            return false;
+        }
+
+        InitSocketsLib();
+        Init( std::make_unique<TcpSharedCacheStore>( host, port ) );
+        return true;
+    }
+
+    if ( !IsDirectory( location ) )
+    {
+        LOG_ERR( "Shared cache directory '%s' does not exist", location.c_str() );
+        return false;
+    }
+    Init( std::make_unique<DirectorySharedCacheStore>( location ) );
+
+    return true;
+}
+
+void Init( std::unique_ptr<SharedCacheStore>&& store )
+{
+    s_store           = std::move( store );
+    s_hits            = 0;
+    s_misses          = 0;
+    s_publishes       = 0;
+    s_failedPublishes = 0;
+    s_bytesFetched    = 0;
+    s_bytesPublished  = 0;
+    LOG( "Using shared asset cache: %s", s_store->Describe().c_str() );
+}
+
+void Shutdown()
+{
+    if ( !s_store )
+        return;
+
+    u32 lookups = s_hits + s_misses;
+    LOG( "Shared asset cache: %u hits, %u misses (%.1f%% hit rate), %.2f MB downloaded", s_hits.load(), s_misses.load(),
+        lookups ? 100.0f * s_hits / lookups : 0.0f, s_bytesFetched / ( 1024.0 * 1024.0 ) );
+    LOG( "Shared asset cache: %u assets published (%.2f MB), %u failed publishes", s_publishes.load(),
+        s_bytesPublished / ( 1024.0 * 1024.0 ), s_failedPublishes.load() );
+
+    if ( dynamic_cast<TcpSharedCacheStore*>( s_store.get() ) )
+        ShutdownSocketLib();
+    s_store.reset();
+}
+
+bool IsEnabled() { return s_store != nullptr; }
+
+bool ComputeKey( AssetType assetType, const std::string& cacheName, const std::vector<std::string>& inputFiles, std::string& key )
+{
+    PGP_ZONE_SCOPEDN( "SharedAssetCache::ComputeKey" );
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset( state, 0 );
+    XXH64_update( state, cacheName.data(), cacheName.length() + 1 );
+
+    bool success = true;
+    for ( const std::string& absPath : inputFiles )
+    {
+        // Hash the paths relative to the asset dir, so that machines with different checkout locations still match
+        std::string relPath = absPath.starts_with( PG_ASSET_DIR ) ? absPath.substr( strlen( PG_ASSET_DIR ) ) : absPath;
+        XXH64_update( state, relPath.data(), relPath.length() + 1 );
+        if ( !HashFile( state, absPath ) )
+        {
+            success = false;
+            break;
+        }
+    }
+    u64 hash = XXH64_digest( state );
+    XXH64_freeState( state );
+
+    char hashStr[32];
+    snprintf( hashStr, sizeof( hashStr ), "%02x/%016llx", (u32)( hash >> 56 ), (unsigned long long)hash );
+    key = s_keyPrefixes[assetType] + std::string( hashStr );
+
+    return success;
+}
+
+bool Fetch( AssetType assetType, const std::string& cacheName, const std::string& key )
+{
+    PGP_ZONE_SCOPEDN( "SharedAssetCache::Fetch" );
+    std::string localPath = AssetCache::GetCachedAssetPath( assetType, cacheName );
+    std::string tmpPath   = localPath + "_shared_tmp";
+    size_t numBytes       = 0;
+    if ( !s_store->Get( key, tmpPath, numBytes ) || !RenameFile( tmpPath, localPath ) )
+    {
+        DeleteFile( tmpPath );
+        ++s_misses;
+        return false;
+    }
+
+    ++s_hits;
+    s_bytesFetched += numBytes;
+    return true;
+}
+
+void Publish( AssetType assetType, const std::string& cacheName, const std::string& key )
+{
+    PGP_ZONE_SCOPEDN( "SharedAssetCache::Publish" );
+    size_t numBytes = 0;
+    if ( !s_store->Put( key, AssetCache::GetCachedAssetPath( assetType, cacheName ), numBytes ) )
+    {
+        LOG_WARN( "Failed to publish %s %s to the shared asset cache", g_assetNames[assetType], cacheName.c_str() );
+        ++s_failedPublishes;
+        return;
+    }
+
+    if ( numBytes )
+    {
+        ++s_publishes;
+        s_bytesPublished += numBytes;
+    }
+}
+
+static void HandleClient( ClientSocket& socket, DirectorySharedCacheStore* store, const std::string& rootDir )
+{
+    socket.SetNonblockingRecv( SOCKET_TIMEOUT_MS );
+    SharedCacheOp op;
+    u16 keyLen;
+    std::string key;
+    if ( !ReceiveAll( socket, &op, sizeof( op ) ) || !ReceiveAll( socket, &keyLen, sizeof( keyLen ) ) )
+        return;
+    key.resize( keyLen );
+    if ( !ReceiveAll( socket, key.data(), keyLen ) || !IsValidKey( key ) )
+    {
+        LOG_WARN( "Shared cache server: dropping request with an invalid key" );
+        return;
+    }
+
+    if ( op == SharedCacheOp::GET )
+    {
+        // only report a miss if the file isn't there. Once SendFile has sent the size, a failure just closes the connection
+        size_t numBytes;
+        if ( !PathExists( rootDir + key ) )
+            SendAll( socket, &SHARED_CACHE_MISS, sizeof( u64 ) );
+        else if ( !SendFile( socket, rootDir + key, numBytes ) )
+            LOG_WARN( "Shared cache server: failed to send %s", key.c_str() );
+    }
+    else if ( op == SharedCacheOp::PUT )
+    {
+        // receive into a temporary file first, then reuse the directory store's atomic publish
+        u64 fileSize;
+        u8 status           = 0;
+        std::string tmpPath = rootDir + "incoming/" + key + GetUniqueTmpSuffix();
+        if ( ReceiveAll( socket, &fileSize, sizeof( u64 ) ) && ReceiveFile( socket, fileSize, tmpPath ) )
+        {
+            size_t numBytes;
+            status = store->Put( key, tmpPath, numBytes );
+            if ( numBytes )
+                LOG( "Shared cache server: stored %s (%.2f KB)", key.c_str(), numBytes / 1024.0f );
+        }
+        DeleteFile( tmpPath );
+        SendAll( socket, &status, sizeof( status ) );
+    }
+}
+
+static volatile sig_atomic_t s_serverShouldExit = 0;
+
+static void ServerSignalHandler( int ) { s_serverShouldExit = 1; }
+
+bool RunServer( const std::string& rootDir, const std::string& bindAddress )
+{
+    std::string host;
+    int port;
+    if ( !ParseHostAndPort( bindAddress, host, port ) )
+    {
+        LOG_ERR( "Invalid shared cache server address '%s'. Expected 'host[:port]'", bindAddress.c_str() );
+        return false;
+    }
+
+    std::string dir = BackToForwardSlashes( rootDir );
+    if ( !dir.empty() && dir.back() != '/' )
+        dir += '/';
+    CreateDirectory( dir );
+    DirectorySharedCacheStore store( dir );
+
+    InitSocketsLib();
+    ServerSocket serverSocket;
+    if ( !serverSocket.Open( host.c_str(), port ) )
+    {
+        LOG_ERR( "Shared cache server: could not listen on %s:%d", host.c_str(), port );
+        ShutdownSocketLib();
+        return false;
+    }
+
+    // Every request is a short lived connection, handled by a fixed pool of workers. Connections past the pending limit
+    // get closed right away, which the clients just treat as a cache miss / failed publish
+    std::mutex pendingLock;
+    std::condition_variable pendingCV;
+    std::deque<std::unique_ptr<ClientSocket>> pendingClients;
+    bool stopWorkers = false;
+    auto WorkerLoop  = [&]()
+    {
+        while ( true )
+        {
+            std::unique_ptr<ClientSocket> clientSocket;
+            {
+                std::unique_lock lock( pendingLock );
+                pendingCV.wait( lock, [&]() { return stopWorkers || !pendingClients.empty(); } );
+                // finish off the connections that were already accepted before exiting
+                if ( pendingClients.empty() )
+                    return;
+                clientSocket = std::move( pendingClients.front() );
+                pendingClients.pop_front();
+            }
+            HandleClient( *clientSocket, &store, dir );
+        }
+    };
+    std::vector<std::thread> workers;
+    for ( u32 i = 0; i < SERVER_WORKER_THREADS; ++i )
+        workers.emplace_back( WorkerLoop );
+
+    std::signal( SIGINT, ServerSignalHandler );
+    std::signal( SIGTERM, ServerSignalHandler );
+    LOG( "Shared cache server: serving '%s' on %s:%d. Press ctrl-c to exit", dir.c_str(), host.c_str(), port );
+    bool success        = true;
+    u32 acceptBackoffMS = 0;
+    while ( !s_serverShouldExit )
+    {
+        // Waiting with a timeout instead of blocking in accept, so that the exit flag gets checked
+        int waitResult = serverSocket.WaitForConnection( SERVER_POLL_INTERVAL_MS );
+        if ( waitResult < 0 && !s_serverShouldExit )
+        {
+            LOG_ERR( "Shared cache server: waiting for connections failed, shutting down" );
+            success = false;
+            break;
+        }
+        if ( waitResult <= 0 )
+            continue;
+
+        auto clientSocket = std::make_unique<ClientSocket>();
+        if ( !serverSocket.AcceptConnection( *clientSocket ) )
+        {
+            // Errors like running out of file descriptors don't go away right away, so back off instead of spinning on them
+            acceptBackoffMS = std::clamp( 2 * acceptBackoffMS, 10u, 1000u );
+            LOG_WARN( "Shared cache server: failed to accept a connection, retrying in %u ms", acceptBackoffMS );
+            std::this_thread::sleep_for( std::chrono::milliseconds( acceptBackoffMS ) );
+            continue;
+        }
+        acceptBackoffMS = 0;
+
+        std::unique_lock lock( pendingLock );
+        if ( pendingClients.size() >= SERVER_MAX_PENDING_CONNECTIONS )
+        {
+            LOG_WARN( "Shared cache server: too many pending connections, dropping one" );
+            continue;
+        }
+        pendingClients.push_back( std::move( clientSocket ) );
+        pendingCV.notify_one();
+    }
+
+    {
+        std::unique_lock lock( pendingLock );
+        stopWorkers = true;
+    }
+    pendingCV.notify_all();
+    for ( std::thread& worker : workers )
+        worker.join();
+    serverSocket.Close();
+    ShutdownSocketLib();
+    LOG( "Shared cache server: shut down" );
+
+    return success;
+}
+
+} // namespace PG::SharedAssetCache
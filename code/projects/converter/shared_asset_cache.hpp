@@ -0,0 +1,84 @@
+#pragma once
+
+#include "asset/asset_versions.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PG
+{
+
+// A content addressed store of converted assets, shared between multiple machines. Keys are strings like
+// "images/01/0123456789abcdef" and the values are the exact cached asset files (metadata header included)
+class SharedCacheStore
+{
+public:
+    virtual ~SharedCacheStore() = default;
+
+    // Both return false on a miss or failure. dstPath should be a temporary file, since it can be partially written on failure
+    virtual bool Get( const std::string& key, const std::string& dstPath, size_t& numBytes ) = 0;
+    virtual bool Put( const std::string& key, const std::string& srcPath, size_t& numBytes ) = 0;
+    virtual std::string Describe() const                                                     = 0;
+};
+
+// Just a directory on a shared path (ex: a network drive). Publishes are atomic, by copying into a temporary file
+// first and renaming it after, so readers never see partially written files
+class DirectorySharedCacheStore : public SharedCacheStore
+{
+public:
+    DirectorySharedCacheStore( const std::string& rootDir );
+
+    bool Get( const std::string& key, const std::string& dstPath, size_t& numBytes ) override;
+    bool Put( const std::string& key, const std::string& srcPath, size_t& numBytes ) override;
+    std::string Describe() const override { return "directory '" + m_rootDir + "'"; }
+
+private:
+    std::string m_rootDir;
+};
+
+// Client for 'converter --cacheserver', which is a DirectorySharedCacheStore served over TCP
+class TcpSharedCacheStore : public SharedCacheStore
+{
+public:
+    TcpSharedCacheStore( const std::string& host, int port ) : m_host( host ), m_port( port ) {}
+
+    bool Get( const std::string& key, const std::string& dstPath, size_t& numBytes ) override;
+    bool Put( const std::string& key, const std::string& srcPath, size_t& numBytes ) override;
+    std::string Describe() const override { return "server " + m_host + ":" + std::to_string( m_port ); }
+
+private:
+    std::string m_host;
+    int m_port;
+};
+
+static constexpr int SHARED_CACHE_DEFAULT_PORT = 27016;
+
+} // namespace PG
+
+// The local AssetCache is always checked first (via the regular timestamp checks). Only assets that are out of date
+// locally are looked up in the shared cache, before falling back to actually converting them
+namespace PG::SharedAssetCache
+{
+
+// location is either a directory, or "tcp:host[:port]" for a server started with 'converter --cacheserver'
+bool Init( const std::string& location );
+void Init( std::unique_ptr<SharedCacheStore>&& store );
+// Logs the hit/miss stats
+void Shutdown();
+bool IsEnabled();
+
+// Hashes the cache name (which already contains the asset version + settings hash) along with the relative path and
+// contents of every input file. Two machines only get the same key if they would produce the same converted asset
+bool ComputeKey( AssetType assetType, const std::string& cacheName, const std::vector<std::string>& inputFiles, std::string& key );
+
+// Copies the asset from the shared cache into the local AssetCache. Returns false on a miss
+bool Fetch( AssetType assetType, const std::string& cacheName, const std::string& key );
+// Uploads the locally cached asset to the shared cache
+void Publish( AssetType assetType, const std::string& cacheName, const std::string& key );
+
+// Serves the given directory to TcpSharedCacheStore clients, listening on bindAddress ("host[:port]"). There is no
+// authentication, so only bind to interfaces on trusted networks. Runs until ctrl-c / SIGTERM, or until listening fails.
+// Returns false on failure
+bool RunServer( const std::string& rootDir, const std::string& bindAddress );
+
+} // namespace PG::SharedAssetCache
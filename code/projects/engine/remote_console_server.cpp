@@ -5,6 +5,7 @@
 
 #include "shared/logger.hpp"
 #include "shared/sockets.hpp"
+#include <errno.h>
 #include <thread>
 
 static bool s_serverShouldStop;
@@ -24,7 +25,7 @@ bool Init()
     s_serverShouldStop = false;
 
     InitSocketsLib();
-    if ( !s_serverSocket.Open( "localhost", 27015 ) )
+    if ( !s_serverSocket.Open( nullptr, 27015 ) )
         return false;
 
     s_initialized  = true;
@@ -67,7 +68,7 @@ static void ListenForCommands()
         bool clientConnected = true;
         while ( clientConnected && !s_serverShouldStop )
         {
-            int bytesReceived = s_clientSocket.ReceiveData( recvBuffer, recvBufferLen );
+            int bytesReceived = s_clientSocket.ReceiveData( recvBuffer, recvBufferLen - 1 );
             if ( bytesReceived > 0 )
             {
                 recvBuffer[bytesReceived] = '\0';
@@ -89,7 +90,10 @@ static void ListenForCommands()
                     LOG_ERR( "RemoteConsoleServer: recv failed with error: %d. Closing connection", WSAGetLastError() );
                 }
 #else  // #if USING( WINDOWS_PROGRAM )
-                LOG_ERR( "RemoteConsoleServer: client closed connection" );
+                if ( bytesReceived < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) )
+                    continue;
+
+                LOG( "RemoteConsoleServer: client closed connection" );
 #endif // #else // #if USING( WINDOWS_PROGRAM )
                 clientConnected = false;
             }
@@ -0,0 +1,296 @@
+#include "core/image_processing.hpp"
+#include "core/low_discrepancy_sampling.hpp"
+#include "getopt/getopt.h"
+#include "renderer/brdf_functions.hpp"
+#include "shared/logger.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace PG;
+
+static void DisplayHelp()
+{
+    auto msg =
+        "Usage: env_map_benchmark [options]\n"
+        "Compares how the converter bakes environment maps against brute force versions of the same, on a few synthetic skies, and\n"
+        "reports the error and the timings. Runs every report unless some are picked below. No external assets are needed\n"
+        "Options\n"
+        "  --help         Print this message and exit\n"
+        "  --image        Equirectangular environment map to add to the synthetic skies\n"
+        "  --irradiance   Compare the SH irradiance that ENVIRONMENT_MAP_IRRADIANCE images use against a brute force integration\n"
+        "                 of the environment map\n"
+        "  --probe        Prefilter reflection probes the way ENVIRONMENT_MAP_REFLECTION_PROBE images are, and report the MSE + PSNR\n"
+        "                 of each mip against the brute force prefiltering\n"
+        "\n";
+
+    LOG( "%s", msg );
+}
+
+struct BenchmarkSettings
+{
+    std::string inputImage;
+    bool irradianceReport = false;
+    bool probeReport      = false;
+};
+
+static bool ParseCommandLineArgs( int argc, char** argv, BenchmarkSettings& settings )
+{
+    static struct option long_options[] = {
+        {"help",       no_argument,       0, 'h'},
+        {"image",      required_argument, 0, 'i'},
+        {"irradiance", no_argument,       0, 'I'},
+        {"probe",      no_argument,       0, 'p'},
+        {0,            0,                 0, 0  }
+    };
+
+    i32 option_index = 0;
+    i32 c            = -1;
+    while ( ( c = getopt_long( argc, argv, "hi:Ip", long_options, &option_index ) ) != -1 )
+    {
+        switch ( c )
+        {
+        case 'h': DisplayHelp(); return false;
+        case 'i': settings.inputImage = optarg; break;
+        case 'I': settings.irradianceReport = true; break;
+        case 'p': settings.probeReport = true; break;
+        default: LOG_ERR( "Invalid option, try 'env_map_benchmark --help' for more information" ); return false;
+        }
+    }
+
+    if ( !settings.irradianceReport && !settings.probeReport )
+    {
+        settings.irradianceReport = true;
+        settings.probeReport      = true;
+    }
+
+    return true;
+}
+
+// Size of the cubemaps that the irradiance report integrates, and of the irradiance cubemaps that it compares
+static constexpr u32 IRRADIANCE_SOURCE_SIZE = 64;
+static constexpr u32 IRRADIANCE_OUTPUT_SIZE = 16;
+
+// A sky gradient over a darker ground, plus an optional sun with an HDR intensity. The sun is the hard case for L2 SH,
+// since all of its high frequency energy gets dropped
+static FloatImageCubemap GenerateSkyCubemap( u32 size, f32 sunIntensity )
+{
+    const vec3 sunDir = Normalize( vec3( 0.6f, 0.3f, 0.5f ) );
+    FloatImageCubemap cubemap( size, 3 );
+    for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+    {
+        for ( u32 row = 0; row < size; ++row )
+        {
+            for ( u32 col = 0; col < size; ++col )
+            {
+                const vec3 dir = CubemapFaceUVToDirection( faceIdx, { ( col + 0.5f ) / size, ( row + 0.5f ) / size } );
+                vec3 radiance  = dir.z >= 0 ? vec3( 0.3f, 0.5f, 1.0f ) * ( 0.4f + 0.6f * dir.z ) : vec3( 0.15f, 0.12f, 0.1f );
+                if ( Dot( dir, sunDir ) > 0.995f )
+                    radiance += vec3( sunIntensity, 0.9f * sunIntensity, 0.8f * sunIntensity );
+                cubemap.faces[faceIdx].SetFromFloat4( row, col, vec4( radiance, 0 ) );
+            }
+        }
+    }
+
+    return cubemap;
+}
+
+// The cosine weighted integral over every source texel, weighted by its solid angle, divided by PI to match ConvolveSH9WithCosineLobe
+static vec3 BruteForceIrradiance( const FloatImageCubemap& cubemap, const vec3& normal )
+{
+    vec3 irradiance( 0 );
+    f64 totalWeight     = 0;
+    const f32 texelSize = 2.0f / cubemap.size;
+    for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+    {
+        for ( u32 row = 0; row < cubemap.size; ++row )
+        {
+            for ( u32 col = 0; col < cubemap.size; ++col )
+            {
+                const vec2 localUV = { ( col + 0.5f ) / cubemap.size, ( row + 0.5f ) / cubemap.size };
+                const vec2 st      = 2.0f * localUV - vec2( 1.0f );
+                const f32 tmp      = 1.0f + st.x * st.x + st.y * st.y;
+                const f32 weight   = texelSize * texelSize / ( tmp * sqrtf( tmp ) );
+                const f32 cosTheta = Dot( normal, CubemapFaceUVToDirection( faceIdx, localUV ) );
+                totalWeight += weight;
+                if ( cosTheta > 0 )
+                    irradiance += ( weight * cosTheta ) * vec3( cubemap.faces[faceIdx].GetFloat4( row, col ) );
+            }
+        }
+    }
+
+    return irradiance * static_cast<f32>( 4.0 / totalWeight );
+}
+
+static std::vector<std::pair<std::string, FloatImageCubemap>> GetSkyCorpus( const BenchmarkSettings& settings, u32 size )
+{
+    std::vector<std::pair<std::string, FloatImageCubemap>> skies;
+    skies.emplace_back( "sky", GenerateSkyCubemap( size, 0.0f ) );
+    skies.emplace_back( "sky + sun (100x)", GenerateSkyCubemap( size, 100.0f ) );
+    skies.emplace_back( "sky + sun (10000x)", GenerateSkyCubemap( size, 10000.0f ) );
+    if ( !settings.inputImage.empty() )
+    {
+        FloatImage2D equiImg;
+        if ( equiImg.Load( settings.inputImage ) )
+            skies.emplace_back( settings.inputImage, EquirectangularToCubemap( equiImg ).Resize( size ) );
+        else
+            LOG_ERR( "Could not load the environment map '%s', skipping it", settings.inputImage.c_str() );
+    }
+
+    return skies;
+}
+
+static void LogIrradianceReport( const BenchmarkSettings& settings )
+{
+    const std::vector<std::pair<std::string, FloatImageCubemap>> skies = GetSkyCorpus( settings, IRRADIANCE_SOURCE_SIZE );
+
+    LOG( "SH irradiance vs brute force, for a %ux%u irradiance cubemap from a %ux%u source. Errors are the length of the RGB "
+         "difference, relative to the length of the brute force RGB",
+        IRRADIANCE_OUTPUT_SIZE, IRRADIANCE_OUTPUT_SIZE, IRRADIANCE_SOURCE_SIZE, IRRADIANCE_SOURCE_SIZE );
+    LOG( "%-20s %10s %10s %12s %14s", "Environment", "Avg error", "Max error", "SH seconds", "Brute seconds" );
+    for ( const auto& [name, cubemap] : skies )
+    {
+        const auto shStartTime = std::chrono::high_resolution_clock::now();
+        const SH9Color sh      = ConvolveSH9WithCosineLobe( ProjectCubemapToSH9( cubemap ) );
+        const f64 shSeconds    = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - shStartTime ).count();
+
+        f64 totalError   = 0;
+        f64 maxError     = 0;
+        f64 bruteSeconds = 0;
+        for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+        {
+            for ( u32 row = 0; row < IRRADIANCE_OUTPUT_SIZE; ++row )
+            {
+                for ( u32 col = 0; col < IRRADIANCE_OUTPUT_SIZE; ++col )
+                {
+                    const vec2 faceUV       = { ( col + 0.5f ) / IRRADIANCE_OUTPUT_SIZE, ( row + 0.5f ) / IRRADIANCE_OUTPUT_SIZE };
+                    const vec3 normal       = CubemapFaceUVToDirection( faceIdx, faceUV );
+                    // Same clamp as Load_EnvironmentMapIrradiance, since the SH can ring negative opposite a bright sun
+                    const vec3 shIrradiance = Max( EvaluateSH9( sh, normal ), vec3( 0 ) );
+
+                    const auto bruteStartTime  = std::chrono::high_resolution_clock::now();
+                    const vec3 bruteIrradiance = BruteForceIrradiance( cubemap, normal );
+                    bruteSeconds += std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - bruteStartTime ).count();
+
+                    const vec3 diff = shIrradiance - bruteIrradiance;
+                    const f64 error = Length( diff ) / std::max( 1e-6f, Length( bruteIrradiance ) );
+                    totalError += error;
+                    maxError = std::max( maxError, error );
+                }
+            }
+        }
+
+        const f64 avgError = totalError / ( 6.0 * IRRADIANCE_OUTPUT_SIZE * IRRADIANCE_OUTPUT_SIZE );
+        LOG( "%-20s %9.2f%% %9.2f%% %12.4f %14.4f", name.c_str(), 100.0 * avgError, 100.0 * maxError, shSeconds, bruteSeconds );
+    }
+}
+
+// Same sizes as Load_EnvironmentMapReflectionProbe uses. The source size is up to the artist, so just pick a typical one
+static constexpr u32 PROBE_SOURCE_SIZE = 256;
+static constexpr i32 PROBE_FACE_SIZE   = 64;
+static constexpr i32 PROBE_MIP_LEVELS  = 7;
+
+// Same output as PrefilterReflectionProbe, but the original brute force way: 1024 samples per texel, always reading the full
+// resolution source. Far too slow for the converter
+static void PrefilterReflectionProbeReference(
+    const FloatImageCubemap& cubemap, FloatImageCubemap* outputMips, i32 mipLevels, i32 faceSize )
+{
+    for ( i32 mipLevel = 0; mipLevel < mipLevels; ++mipLevel )
+    {
+        const i32 MIP_SIZE      = faceSize >> mipLevel;
+        outputMips[mipLevel]    = FloatImageCubemap( MIP_SIZE, 3 );
+        f32 perceptualRoughness = mipLevel / static_cast<f32>( mipLevels - 1 );
+        f32 linearRoughness     = perceptualRoughness * perceptualRoughness;
+        for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+        {
+#pragma omp parallel for
+            for ( i32 dstRow = 0; dstRow < MIP_SIZE; ++dstRow )
+            {
+                for ( i32 dstCol = 0; dstCol < MIP_SIZE; ++dstCol )
+                {
+                    vec2 faceUV = { ( dstCol + 0.5f ) / MIP_SIZE, ( dstRow + 0.5f ) / MIP_SIZE };
+
+                    vec3 N = CubemapFaceUVToDirection( faceIdx, faceUV );
+                    vec3 V = N;
+
+                    f32 totalWeight = 0;
+                    vec3 prefilteredColor( 0 );
+                    const u32 SAMPLE_COUNT = 1024u;
+                    for ( u32 i = 0u; i < SAMPLE_COUNT; ++i )
+                    {
+                        vec2 Xi = vec2( i / (f32)SAMPLE_COUNT, Hammersley32( i ) );
+                        vec3 H  = ImportanceSampleGGX_D( Xi, N, linearRoughness );
+                        vec3 L  = Normalize( 2.0f * Dot( V, H ) * H - V );
+
+                        f32 NdotL = Max( Dot( N, L ), 0.0f );
+                        if ( NdotL > 0.0f )
+                        {
+                            vec3 radiance = cubemap.Sample( L );
+                            prefilteredColor += radiance * NdotL;
+                            totalWeight += NdotL;
+                        }
+                    }
+                    prefilteredColor = prefilteredColor / totalWeight;
+                    outputMips[mipLevel].faces[faceIdx].SetFromFloat4( dstRow, dstCol, vec4( prefilteredColor, 0 ) );
+                }
+            }
+        }
+    }
+}
+
+static void LogReflectionProbeReport( const BenchmarkSettings& settings )
+{
+    const std::vector<std::pair<std::string, FloatImageCubemap>> skies = GetSkyCorpus( settings, PROBE_SOURCE_SIZE );
+
+    LOG( "Reflection probe prefiltering vs brute force, for a %dx%d probe with %d mips from a %ux%u source. PSNR is relative to the "
+         "brightest texel of each reference mip",
+        PROBE_FACE_SIZE, PROBE_FACE_SIZE, PROBE_MIP_LEVELS, PROBE_SOURCE_SIZE, PROBE_SOURCE_SIZE );
+    for ( const auto& [name, cubemap] : skies )
+    {
+        FloatImageCubemap outputMips[PROBE_MIP_LEVELS];
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        PrefilterReflectionProbe( cubemap, outputMips, PROBE_MIP_LEVELS, PROBE_FACE_SIZE );
+        const f64 seconds = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - startTime ).count();
+
+        FloatImageCubemap referenceMips[PROBE_MIP_LEVELS];
+        const auto referenceStartTime = std::chrono::high_resolution_clock::now();
+        PrefilterReflectionProbeReference( cubemap, referenceMips, PROBE_MIP_LEVELS, PROBE_FACE_SIZE );
+        const f64 referenceSeconds = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - referenceStartTime ).count();
+
+        LOG( "%s: %.3f seconds, brute force %.3f seconds (%.1fx)", name.c_str(), seconds, referenceSeconds, referenceSeconds / seconds );
+        for ( i32 mipLevel = 0; mipLevel < PROBE_MIP_LEVELS; ++mipLevel )
+        {
+            f64 mse      = 0;
+            f32 maxValue = 0;
+            for ( i32 faceIdx = 0; faceIdx < 6; ++faceIdx )
+            {
+                mse += FloatImageMSE( outputMips[mipLevel].faces[faceIdx], referenceMips[mipLevel].faces[faceIdx], 0b1110 ) / 6.0;
+                referenceMips[mipLevel].faces[faceIdx].ForEachPixel(
+                    [&maxValue]( f32* p ) { maxValue = Max( maxValue, Max( p[0], Max( p[1], p[2] ) ) ); } );
+            }
+            const i32 mipSize = PROBE_FACE_SIZE >> mipLevel;
+            LOG( "  Mip %d (%dx%d): MSE %.3e, PSNR %.2f dB", mipLevel, mipSize, mipSize, mse, MSEToPSNR( mse, maxValue ) );
+        }
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    Logger_Init();
+    Logger_AddLogLocation( "stdout", stdout );
+
+    BenchmarkSettings settings;
+    if ( !ParseCommandLineArgs( argc, argv, settings ) )
+    {
+        Logger_Shutdown();
+        return 0;
+    }
+
+    if ( settings.irradianceReport )
+        LogIrradianceReport( settings );
+    if ( settings.probeReport )
+        LogReflectionProbeReport( settings );
+
+    Logger_Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,984 @@
+#include "asset/pmodel.hpp"
+#include "asset/types/model.hpp"
+#include "core/init.hpp"
+#include "core/meshlet_culling.hpp"
+#include "core/meshlet_lod.hpp"
+#include "core/time.hpp"
+#include "getopt/getopt.h"
+#include "shared/assert.hpp"
+#include "shared/filesystem.hpp"
+#include "shared/logger.hpp"
+#include "shared/random.hpp"
+#include "shared/serializer.hpp"
+#include "xxHash/xxhash.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <omp.h>
+
+using namespace PG;
+
+static void DisplayHelp()
+{
+    auto msg =
+        "Usage: model_benchmark [options]\n"
+        "Builds synthetic models with Model::Load, the same way the converter does, and reports the wall time with 1 thread and with "
+        "all of them. Also checks that the output doesn't depend on the thread count. No external assets are needed\n"
+        "Options\n"
+        "  --culling      Also fly a camera around each model, and report how many meshlets and triangles the CPU meshlet\n"
+        "                 culling keeps, and how fast it runs in meshlets/s. Checks the batched culling against the scalar one\n"
+        "  --help         Print this message and exit\n"
+        "  --hugetris     Number of triangles in the single mesh model. Default: 2000000\n"
+        "  --lods         Also generate the meshlet LODs, and report the triangle counts that get picked at a few distances\n"
+        "  --meshes       Number of meshes in the many mesh model. Default: 500\n"
+        "  --meshtris     Number of triangles in each of those meshes. Default: 2000\n"
+        "  --runs         How many times to load each model. The fastest run is reported. Default: 3\n"
+        "  --stresstris   Instead of the benchmarks, check that a mesh this big gets split into parts that stay under the\n"
+        "                 meshlet limit, and that no triangles go missing. Ex: 10000000\n"
+        "  --text         Also save each model as a .pmodelt, and report how fast PModel::Load parses it compared to the\n"
+        "                 reference parser, in MB/s. Checks that both parsers give exactly the same PModel\n"
+        "  --vertexorder  Also shuffle the triangles and vertices of each model, and compare the meshlets built from that with\n"
+        "                 and without optimizeVertexOrder\n"
+        "\n";
+
+    LOG( "%s", msg );
+}
+
+struct BenchmarkSettings
+{
+    u32 hugeMeshTris   = 2000000;
+    u32 numSmallMeshes = 500;
+    u32 smallMeshTris  = 2000;
+    u32 numRuns        = 3;
+    bool generateLODs  = false;
+    u32 stressTestTris = 0;
+    bool textParsing   = false;
+    bool vertexOrder   = false;
+    bool culling       = false;
+};
+
+static bool ParseCommandLineArgs( int argc, char** argv, BenchmarkSettings& settings )
+{
+    static struct option long_options[] = {
+        {"culling",     no_argument,       0, 'c'},
+        {"help",        no_argument,       0, 'h'},
+        {"hugetris",    required_argument, 0, 'H'},
+        {"lods",        no_argument,       0, 'l'},
+        {"meshes",      required_argument, 0, 'm'},
+        {"meshtris",    required_argument, 0, 't'},
+        {"runs",        required_argument, 0, 'r'},
+        {"stresstris",  required_argument, 0, 's'},
+        {"text",        no_argument,       0, 'T'},
+        {"vertexorder", no_argument,       0, 'v'},
+        {0,             0,                 0, 0  }
+    };
+
+    i32 option_index = 0;
+    i32 c            = -1;
+    while ( ( c = getopt_long( argc, argv, "chH:lm:r:s:t:Tv", long_options, &option_index ) ) != -1 )
+    {
+        switch ( c )
+        {
+        case 'c': settings.culling = true; break;
+        case 'h': DisplayHelp(); return false;
+        case 'H': settings.hugeMeshTris = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 'l': settings.generateLODs = true; break;
+        case 'm': settings.numSmallMeshes = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 'r': settings.numRuns = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 's': settings.stressTestTris = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 't': settings.smallMeshTris = (u32)strtoul( optarg, nullptr, 10 ); break;
+        case 'T': settings.textParsing = true; break;
+        case 'v': settings.vertexOrder = true; break;
+        default: LOG_ERR( "Invalid option, try 'model_benchmark --help' for more information" ); return false;
+        }
+    }
+
+    if ( !settings.hugeMeshTris || !settings.numSmallMeshes || !settings.smallMeshTris || !settings.numRuns )
+    {
+        LOG_ERR( "All of the counts must be positive" );
+        return false;
+    }
+
+    return true;
+}
+
+// A slightly bumpy grid with uvs and tangents, offset so that the meshes of a model don't overlap. Gets rounded up to a whole grid
+static void GenerateGridMesh( PModel::Mesh& mesh, u32 numTris, vec3 offset, u64 seed )
+{
+    const u32 gridSize  = std::max( 1u, (u32)std::ceil( std::sqrt( numTris / 2.0 ) ) );
+    const u32 rowVerts  = gridSize + 1;
+    mesh.numUVChannels  = 1;
+    mesh.hasTangents    = true;
+    mesh.hasBoneWeights = false;
+    mesh.Resize( rowVerts * rowVerts );
+
+    Random::RNG rng( seed );
+    for ( u32 row = 0; row < rowVerts; ++row )
+    {
+        for ( u32 col = 0; col < rowVerts; ++col )
+        {
+            const u32 vIdx        = row * rowVerts + col;
+            const vec2 uv         = vec2( col, row ) / (f32)gridSize;
+            mesh.positions[vIdx]  = offset + vec3( uv.x, uv.y, 0.01f * rng.UniformFloat() );
+            mesh.normals[vIdx]    = vec3( 0, 0, 1 );
+            mesh.tangents[vIdx]   = vec3( 1, 0, 0 );
+            mesh.bitangents[vIdx] = vec3( 0, 1, 0 );
+            mesh.UV( vIdx, 0 )    = uv;
+        }
+    }
+
+    mesh.indices.reserve( 6 * gridSize * gridSize );
+    for ( u32 row = 0; row < gridSize; ++row )
+    {
+        for ( u32 col = 0; col < gridSize; ++col )
+        {
+            const u32 v00 = row * rowVerts + col;
+            const u32 v10 = v00 + 1;
+            const u32 v01 = v00 + rowVerts;
+            const u32 v11 = v01 + 1;
+            mesh.indices.insert( mesh.indices.end(), { v00, v10, v11, v00, v11, v01 } );
+        }
+    }
+}
+
+template <typename T>
+static void HashVector( XXH64_state_t* state, const std::vector<T>& v )
+{
+    XXH64_update( state, v.data(), v.size() * sizeof( T ) );
+}
+
+static u64 HashModelOutput( const Model& model )
+{
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset( state, 0 );
+    HashVector( state, model.meshAABBs );
+    XXH64_update( state, &model.positionDequantizationInfo, sizeof( model.positionDequantizationInfo ) );
+    for ( const Mesh& mesh : model.meshes )
+    {
+        HashVector( state, mesh.meshlets );
+        HashVector( state, mesh.meshletCullDatas );
+        HashVector( state, mesh.meshletLODCullDatas );
+        HashVector( state, mesh.packedPositions );
+        HashVector( state, mesh.packedNormals );
+        HashVector( state, mesh.packedTangents );
+        HashVector( state, mesh.packedTexCoords );
+        HashVector( state, mesh.packedTris );
+    }
+    u64 hash = XXH64_digest( state );
+    XXH64_freeState( state );
+
+    return hash;
+}
+
+struct LoadResult
+{
+    f64 fastestMS   = 0;
+    u64 outputHash  = 0;
+    u32 numMeshes   = 0;
+    u32 numMeshlets = 0;
+};
+
+static bool TimeModelLoad( const std::string& relFilename, u32 numThreads, const BenchmarkSettings& settings, LoadResult& result )
+{
+    omp_set_num_threads( (int)numThreads );
+    ModelCreateInfo createInfo;
+    createInfo.name                = GetFilenameStem( relFilename );
+    createInfo.filename            = relFilename;
+    createInfo.generateMeshletLODs = settings.generateLODs;
+
+    result.fastestMS = FLT_MAX;
+    for ( u32 run = 0; run < settings.numRuns; ++run )
+    {
+        Model model;
+        auto startTime = Time::GetTimePoint();
+        if ( !model.Load( &createInfo ) )
+            return false;
+        result.fastestMS = std::min( result.fastestMS, Time::GetTimeSince( startTime ) );
+
+        u64 hash           = HashModelOutput( model );
+        result.numMeshes   = (u32)model.meshes.size();
+        result.numMeshlets = 0;
+        for ( const Mesh& mesh : model.meshes )
+            result.numMeshlets += (u32)mesh.meshlets.size();
+        if ( run > 0 && hash != result.outputHash )
+        {
+            LOG_ERR( "Model '%s' built differently on run %u with %u threads", relFilename.c_str(), run, numThreads );
+            return false;
+        }
+        result.outputHash = hash;
+        model.Free();
+    }
+
+    return true;
+}
+
+// Views the model head on from further and further away, and checks that the LOD cut only ever gets coarser
+static bool ReportLODCuts( const std::string& relFilename )
+{
+    ModelCreateInfo createInfo;
+    createInfo.name                = GetFilenameStem( relFilename );
+    createInfo.filename            = relFilename;
+    createInfo.generateMeshletLODs = true;
+    Model model;
+    if ( !model.Load( &createInfo ) )
+        return false;
+
+    AABB modelAABB = {};
+    for ( const AABB& aabb : model.meshAABBs )
+        modelAABB.Encompass( aabb );
+    const f32 modelSize = Length( modelAABB.Extent() );
+
+    MeshletLODView view;
+    view.vFov         = DegToRad( 45.0f );
+    view.screenHeight = 1080;
+    view.nearPlane    = 0.01f * modelSize;
+
+    std::vector<u32> selectedMeshlets;
+    u32 prevTris = UINT32_MAX;
+    for ( f32 distance : { 0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 64.0f } )
+    {
+        view.cameraPos = modelAABB.Center() + vec3( 0, 0, distance * modelSize );
+        u32 numTris    = 0;
+        for ( const Mesh& mesh : model.meshes )
+        {
+            if ( mesh.meshletLODCullDatas.empty() )
+            {
+                for ( u32 meshletIdx = 0; meshletIdx < mesh.numFullDetailMeshlets; ++meshletIdx )
+                    numTris += mesh.meshlets[meshletIdx].triangleCount;
+                continue;
+            }
+
+            SelectMeshletLODs( view, mesh.meshletLODCullDatas, selectedMeshlets );
+            for ( u32 meshletIdx : selectedMeshlets )
+                numTris += mesh.meshlets[meshletIdx].triangleCount;
+        }
+        LOG( "    LOD cut at %5.1fx the model size away: %u tris", distance, numTris );
+        if ( numTris > prevTris )
+        {
+            LOG_ERR( "    The LOD cut picked more triangles further away!" );
+            return false;
+        }
+        prevTris = numTris;
+    }
+
+    return true;
+}
+
+template <typename T>
+static bool VectorsIdentical( const std::vector<T>& a, const std::vector<T>& b )
+{
+    return a.size() == b.size() && ( a.empty() || !memcmp( a.data(), b.data(), a.size() * sizeof( T ) ) );
+}
+
+static bool PModelsIdentical( const PModel& a, const PModel& b )
+{
+    if ( memcmp( &a.aabbMin, &b.aabbMin, sizeof( vec3 ) ) || memcmp( &a.aabbMax, &b.aabbMax, sizeof( vec3 ) ) ||
+         a.meshes.size() != b.meshes.size() )
+        return false;
+
+    for ( size_t meshIdx = 0; meshIdx < a.meshes.size(); ++meshIdx )
+    {
+        const PModel::Mesh& mA = a.meshes[meshIdx];
+        const PModel::Mesh& mB = b.meshes[meshIdx];
+        if ( mA.name != mB.name || mA.materialName != mB.materialName || mA.numUVChannels != mB.numUVChannels ||
+             mA.numColorChannels != mB.numColorChannels || mA.hasTangents != mB.hasTangents || mA.hasBoneWeights != mB.hasBoneWeights )
+            return false;
+
+        if ( !VectorsIdentical( mA.indices, mB.indices ) || !VectorsIdentical( mA.positions, mB.positions ) ||
+             !VectorsIdentical( mA.normals, mB.normals ) || !VectorsIdentical( mA.tangents, mB.tangents ) ||
+             !VectorsIdentical( mA.bitangents, mB.bitangents ) || !VectorsIdentical( mA.uvs, mB.uvs ) ||
+             !VectorsIdentical( mA.colors, mB.colors ) || !VectorsIdentical( mA.numBones, mB.numBones ) ||
+             !VectorsIdentical( mA.boneIndices, mB.boneIndices ) || !VectorsIdentical( mA.boneWeights, mB.boneWeights ) )
+            return false;
+    }
+
+    return true;
+}
+
+static std::string GetNameAfterColon( const std::string& line )
+{
+    size_t startIdx = line.find( ':' );
+    while ( std::isspace( line[++startIdx] ) )
+        ;
+    return line.substr( startIdx );
+}
+
+// The original getline + sscanf .pmodelt parser. Way slower than what PModel::Load uses, and only kept around to check that
+// the two still parse every file into exactly the same PModel
+static bool LoadPModelTextReference( std::string_view filename, PModel& pmodel )
+{
+    std::ifstream in( filename.data() );
+    if ( !in )
+    {
+        LOG_ERR( "Failed to open pmodelt file '%s'", filename.data() );
+        return false;
+    }
+
+    char tmpBuffer[128];
+    std::string tmp;
+    in >> tmp; // pmodelFormat
+    u16 version;
+    in >> version;
+    const PModelVersionNum versionNum = PModelVersionNum( version );
+    if ( versionNum < PModelVersionNum::LAST_SUPPORTED_VERSION )
+    {
+        LOG_ERR( "PModelt file %s contains a version (%u) that is no longer supported. Please re-export the source file", filename.data(),
+            versionNum );
+        return false;
+    }
+
+    auto SkipEmptyLines = []( std::ifstream& inFile, std::string& line )
+    {
+        do
+        {
+            std::getline( inFile, line );
+        } while ( line.empty() );
+    };
+
+    //  skip to material list
+    std::string line;
+    SkipEmptyLines( in, line );
+
+    // parse material list (not actually needed outside of converter)
+    do
+    {
+        std::getline( in, line );
+    } while ( !line.empty() );
+
+    if ( versionNum >= PModelVersionNum::MODEL_AABB )
+    {
+        // Model AABB Min: float float float
+        std::getline( in, line );
+        sscanf( line.c_str(), "%s %s %s %f %f %f", tmpBuffer, tmpBuffer, tmpBuffer, &pmodel.aabbMin.x, &pmodel.aabbMin.y,
+            &pmodel.aabbMin.z );
+        // Model AABB Max: float float float
+        std::getline( in, line );
+        sscanf( line.c_str(), "%s %s %s %f %f %f", tmpBuffer, tmpBuffer, tmpBuffer, &pmodel.aabbMax.x, &pmodel.aabbMax.y,
+            &pmodel.aabbMax.z );
+    }
+
+    while ( std::getline( in, line ) && line.substr( 0, 4 ) == "Mesh" )
+    {
+        PModel::Mesh& mesh = pmodel.meshes.emplace_back();
+        mesh.name          = GetNameAfterColon( line );
+        std::getline( in, line );
+        mesh.materialName = GetNameAfterColon( line );
+        std::getline( in, line );
+        sscanf( line.c_str(), "%s %u", tmpBuffer, &mesh.numUVChannels );
+        std::getline( in, line );
+        sscanf( line.c_str(), "%s %u", tmpBuffer, &mesh.numColorChannels );
+
+        // skip to first vertex
+        SkipEmptyLines( in, line );
+
+        u32 meshNumUVs        = 0;
+        u32 meshNumColors     = 0;
+        u32 meshNumTangents   = 0;
+        u32 meshNumBitangents = 0;
+
+        // Whether the mesh has tangents and bone weights is only known after all of the vertices are parsed. So the tangent streams
+        // are always filled in, and the bone streams start being filled in on the first bone weight
+        mesh.hasTangents    = true;
+        mesh.hasBoneWeights = false;
+        mesh.positions.reserve( 65536 );
+        while ( !line.empty() && line[0] == 'V' )
+        {
+            const u32 vIdx = mesh.NumVertices();
+            mesh.Resize( vIdx + 1 );
+            vec3& pos         = mesh.positions[vIdx];
+            vec3& normal      = mesh.normals[vIdx];
+            vec3& tangent     = mesh.tangents[vIdx];
+            vec3& bitangent   = mesh.bitangents[vIdx];
+            u32 numUVs        = 0;
+            u32 numColors     = 0;
+            u32 numTangents   = 0;
+            u32 numBitangents = 0;
+
+            std::getline( in, line );
+            while ( !line.empty() )
+            {
+                if ( line[0] == 'p' )
+                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &pos.x, &pos.y, &pos.z );
+                else if ( line[0] == 'n' )
+                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &normal.x, &normal.y, &normal.z );
+                else if ( line[0] == 't' )
+                {
+                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &tangent.x, &tangent.y, &tangent.z );
+                    ++numTangents;
+                }
+                else if ( line[0] == 'u' && line[1] == 'v' )
+                {
+                    if ( numUVs < mesh.numUVChannels )
+                    {
+                        vec2& uv = mesh.UV( vIdx, numUVs );
+                        sscanf( line.c_str(), "%s %f %f", tmpBuffer, &uv.x, &uv.y );
+                    }
+                    ++numUVs;
+                }
+                else if ( line[0] == 'c' )
+                {
+                    if ( numColors < mesh.numColorChannels )
+                    {
+                        vec4& color = mesh.Color( vIdx, numColors );
+                        sscanf( line.c_str(), "%s %f %f %f %f", tmpBuffer, &color.x, &color.y, &color.z, &color.w );
+                    }
+                    ++numColors;
+                }
+                else if ( line[0] == 'b' && line[1] == 'w' )
+                {
+                    if ( !mesh.hasBoneWeights )
+                    {
+                        mesh.hasBoneWeights = true;
+                        mesh.Resize( vIdx + 1 );
+                    }
+                    u32 boneIdx;
+                    f32 weight;
+                    sscanf( line.c_str(), "%s %u %f", tmpBuffer, &boneIdx, &weight );
+                    mesh.AddBone( vIdx, boneIdx, weight );
+                }
+                else if ( line[0] == 'b' )
+                {
+                    sscanf( line.c_str(), "%s %f %f %f", tmpBuffer, &bitangent.x, &bitangent.y, &bitangent.z );
+                    ++numBitangents;
+                }
+
+                std::getline( in, line );
+            }
+
+#if USING( DEBUG_BUILD )
+            if ( numTangents > 1 )
+                LOG_WARN( "Mesh %s vertex %u has more than 1 tangent specified", mesh.name.c_str(), vIdx );
+            if ( numBitangents > 1 )
+                LOG_WARN( "Mesh %s vertex %u has more than 1 bittangent specified", mesh.name.c_str(), vIdx );
+            if ( numTangents && !numBitangents )
+                LOG_WARN( "Mesh %s vertex %u has a tangent specified, but no bitangent", mesh.name.c_str(), vIdx );
+            if ( !numTangents && numBitangents )
+                LOG_WARN( "Mesh %s vertex %u has a bitangent specified, but no tangent", mesh.name.c_str(), vIdx );
+#endif // #if USING( DEBUG_BUILD )
+
+            meshNumUVs += numUVs;
+            meshNumColors += numColors;
+            meshNumTangents += numTangents;
+            meshNumBitangents += numBitangents;
+
+            std::getline( in, line );
+        }
+
+        const u32 numVerts = mesh.NumVertices();
+        if ( meshNumUVs != numVerts * mesh.numUVChannels )
+            LOG_WARN( "Not every vertex in mesh %s specified the expected uvs!", mesh.name.c_str() );
+        if ( meshNumColors != numVerts * mesh.numColorChannels )
+            LOG_WARN( "Not every vertex in mesh %s specified the expected vertex colors!", mesh.name.c_str() );
+        if ( meshNumTangents && meshNumTangents != numVerts )
+            LOG_WARN( "Only some, but not all of the vertices in mesh %s specified tangents!", mesh.name.c_str() );
+        if ( meshNumBitangents && meshNumBitangents != numVerts )
+            LOG_WARN( "Only some, but not all of the vertices in mesh %s specified bitangents!", mesh.name.c_str() );
+
+        mesh.hasTangents = meshNumTangents > 0 && meshNumBitangents > 0;
+        if ( !mesh.hasTangents )
+        {
+            mesh.tangents   = {};
+            mesh.bitangents = {};
+        }
+
+        PG_ASSERT( line == "Tris:" );
+        std::getline( in, line );
+        mesh.indices.reserve( numVerts * 2 );
+        while ( !line.empty() )
+        {
+            u32 i0, i1, i2;
+            sscanf( line.c_str(), "%u %u %u", &i0, &i1, &i2 );
+            mesh.indices.push_back( i0 );
+            mesh.indices.push_back( i1 );
+            mesh.indices.push_back( i2 );
+            std::getline( in, line );
+        }
+    }
+    PG_ASSERT( pmodel.meshes.size() );
+
+    return true;
+}
+
+// Times PModel::Load and LoadPModelTextReference on the model saved as a .pmodelt. The grid meshes don't have any vertex colors
+// or bone weights, so those get added first, including a few denormal weights, which are the one case from_chars is picky about
+static bool ReportTextParsing( const std::string& label, const PModel& pmodel, const BenchmarkSettings& settings )
+{
+    PModel toSave = pmodel;
+    Random::RNG rng( 7 );
+    for ( PModel::Mesh& mesh : toSave.meshes )
+    {
+        mesh.numColorChannels = 1;
+        mesh.hasBoneWeights   = true;
+        mesh.Resize( mesh.NumVertices() );
+        for ( u32 vIdx = 0; vIdx < mesh.NumVertices(); ++vIdx )
+        {
+            mesh.Color( vIdx, 0 ) = vec4( rng.UniformFloat(), rng.UniformFloat(), rng.UniformFloat(), 1.0f );
+            if ( vIdx % 3 == 0 )
+                mesh.AddBone( vIdx, vIdx % 64, rng.UniformFloat() );
+            if ( vIdx % 1000 == 0 )
+                mesh.AddBone( vIdx, 1, 1e-40f );
+        }
+    }
+
+    const std::string filename = GetAbsPath_ModelFilename( "cache/model_benchmark/" + label + ".pmodelt" );
+    if ( !toSave.Save( filename, 6, false ) )
+        return false;
+    const f64 fileMB = std::filesystem::file_size( filename ) / ( 1024.0 * 1024.0 );
+
+    f64 fastMS      = FLT_MAX;
+    f64 referenceMS = FLT_MAX;
+    PModel fast, reference;
+    for ( u32 run = 0; run < settings.numRuns; ++run )
+    {
+        fast           = {};
+        auto startTime = Time::GetTimePoint();
+        if ( !fast.Load( filename ) )
+            return false;
+        fastMS = std::min( fastMS, Time::GetTimeSince( startTime ) );
+
+        reference = {};
+        startTime = Time::GetTimePoint();
+        if ( !LoadPModelTextReference( filename, reference ) )
+            return false;
+        referenceMS = std::min( referenceMS, Time::GetTimeSince( startTime ) );
+    }
+    DeleteFile( filename );
+
+    LOG( "    Text pmodel (%.1f MB): PModel::Load %.1f ms (%.1f MB/s), reference parser %.1f ms (%.1f MB/s), %.1fx faster", fileMB, fastMS,
+        1000.0 * fileMB / fastMS, referenceMS, 1000.0 * fileMB / referenceMS, referenceMS / fastMS );
+    if ( !PModelsIdentical( fast, reference ) )
+    {
+        LOG_ERR( "    PModel::Load and the reference text parser gave different results!" );
+        return false;
+    }
+
+    return true;
+}
+
+// Compares the fastfile size and load time with and without the meshoptimizer stream encoding, and checks that it round trips
+static bool ReportFastfileEncoding( const std::string& relFilename, const BenchmarkSettings& settings )
+{
+    ModelCreateInfo createInfo;
+    createInfo.name                = GetFilenameStem( relFilename );
+    createInfo.filename            = relFilename;
+    createInfo.generateMeshletLODs = settings.generateLODs;
+    Model model;
+    if ( !model.Load( &createInfo ) )
+        return false;
+
+    const u64 expectedHash         = HashModelOutput( model );
+    const std::string fastfileName = GetParentPath( GetAbsPath_ModelFilename( relFilename ) ) + createInfo.name + ".ffi";
+    size_t fastfileSizes[2]        = {};
+    f64 fastfileLoadMS[2]          = {};
+    for ( bool encode : { false, true } )
+    {
+        model.encodeStreams = encode;
+        Serializer serializer;
+        if ( !serializer.OpenForWrite( fastfileName ) || !model.FastfileSave( &serializer ) )
+            return false;
+        fastfileSizes[encode] = serializer.Close();
+
+        fastfileLoadMS[encode] = FLT_MAX;
+        for ( u32 run = 0; run < settings.numRuns; ++run )
+        {
+            if ( !serializer.OpenForRead( fastfileName ) )
+                return false;
+
+            Model loaded;
+            auto startTime = Time::GetTimePoint();
+            if ( !loaded.FastfileLoad( &serializer ) )
+                return false;
+            fastfileLoadMS[encode] = std::min( fastfileLoadMS[encode], Time::GetTimeSince( startTime ) );
+            serializer.Close();
+
+            if ( HashModelOutput( loaded ) != expectedHash )
+            {
+                LOG_ERR( "    The model changed after a fastfile round trip with encodeStreams = %d", encode );
+                return false;
+            }
+            loaded.Free();
+        }
+    }
+    DeleteFile( fastfileName );
+    model.Free();
+
+    LOG( "    Fastfile raw: %.2f MB, load %.1f ms. Encoded: %.2f MB (%.1f%%), load %.1f ms", fastfileSizes[0] / ( 1024.0 * 1024.0 ),
+        fastfileLoadMS[0], fastfileSizes[1] / ( 1024.0 * 1024.0 ), 100.0 * fastfileSizes[1] / fastfileSizes[0], fastfileLoadMS[1] );
+
+    return true;
+}
+
+// Moves vertex v to perm[v]. Works for any of the PModel::Mesh vertex streams
+template <typename T>
+static void PermuteVertexStream( std::vector<T>& stream, u32 elementsPerVertex, const std::vector<u32>& perm )
+{
+    if ( stream.empty() )
+        return;
+
+    std::vector<T> permuted( stream.size() );
+    for ( u32 v = 0; v < (u32)perm.size(); ++v )
+    {
+        for ( u32 i = 0; i < elementsPerVertex; ++i )
+            permuted[perm[v] * elementsPerVertex + i] = stream[v * elementsPerVertex + i];
+    }
+    stream.swap( permuted );
+}
+
+// Imported models don't always come in a nice order, so shuffle the triangles and vertices of the generated ones to see how much
+// optimizeVertexOrder gets back. Fewer meshlet vertices per triangle means less vertex shading and less duplicated vertex data
+static bool ReportVertexOrder( const std::string& label, const PModel& pmodel, const BenchmarkSettings& settings )
+{
+    PModel scrambled = pmodel;
+    Random::RNG rng( 1234 );
+    for ( PModel::Mesh& mesh : scrambled.meshes )
+    {
+        const u32 numTris = (u32)mesh.indices.size() / 3;
+        for ( u32 tri = numTris; tri > 1; --tri )
+        {
+            const u32 other = rng.UniformUInt32( tri );
+            for ( u32 i = 0; i < 3; ++i )
+                std::swap( mesh.indices[3 * ( tri - 1 ) + i], mesh.indices[3 * other + i] );
+        }
+
+        std::vector<u32> perm( mesh.NumVertices() );
+        for ( u32 v = 0; v < (u32)perm.size(); ++v )
+            perm[v] = v;
+        for ( u32 v = (u32)perm.size(); v > 1; --v )
+            std::swap( perm[v - 1], perm[rng.UniformUInt32( v )] );
+
+        for ( u32& index : mesh.indices )
+            index = perm[index];
+        PermuteVertexStream( mesh.positions, 1, perm );
+        PermuteVertexStream( mesh.normals, 1, perm );
+        PermuteVertexStream( mesh.tangents, 1, perm );
+        PermuteVertexStream( mesh.bitangents, 1, perm );
+        PermuteVertexStream( mesh.uvs, mesh.numUVChannels, perm );
+        PermuteVertexStream( mesh.colors, mesh.numColorChannels, perm );
+        PermuteVertexStream( mesh.numBones, 1, perm );
+        PermuteVertexStream( mesh.boneIndices, PMODEL_MAX_BONE_WEIGHTS_PER_VERT, perm );
+        PermuteVertexStream( mesh.boneWeights, PMODEL_MAX_BONE_WEIGHTS_PER_VERT, perm );
+    }
+
+    const std::string relFilename = "cache/model_benchmark/" + label + "_scrambled.pmodelb";
+    const std::string absFilename = GetAbsPath_ModelFilename( relFilename );
+    if ( !scrambled.Save( absFilename ) )
+        return false;
+
+    bool success = true;
+    for ( bool optimize : { false, true } )
+    {
+        ModelCreateInfo createInfo;
+        createInfo.name                = GetFilenameStem( relFilename );
+        createInfo.filename            = relFilename;
+        createInfo.optimizeVertexOrder = optimize;
+
+        f64 loadMS       = FLT_MAX;
+        u32 numMeshlets  = 0;
+        u64 meshletVerts = 0;
+        u64 meshletTris  = 0;
+        for ( u32 run = 0; run < settings.numRuns && success; ++run )
+        {
+            Model model;
+            auto startTime = Time::GetTimePoint();
+            success        = model.Load( &createInfo );
+            loadMS         = std::min( loadMS, Time::GetTimeSince( startTime ) );
+            numMeshlets    = 0;
+            meshletVerts   = 0;
+            meshletTris    = 0;
+            for ( const Mesh& mesh : model.meshes )
+            {
+                numMeshlets += mesh.numFullDetailMeshlets;
+                for ( u32 meshletIdx = 0; meshletIdx < mesh.numFullDetailMeshlets; ++meshletIdx )
+                {
+                    meshletVerts += mesh.meshlets[meshletIdx].vertexCount;
+                    meshletTris += mesh.meshlets[meshletIdx].triangleCount;
+                }
+            }
+            model.Free();
+        }
+        if ( !success )
+            break;
+
+        LOG( "    Shuffled, optimizeVertexOrder = %d: %u meshlets, %.3f meshlet verts per tri, Model::Load %.1f ms", optimize,
+            numMeshlets, meshletVerts / (f64)meshletTris, loadMS );
+    }
+    DeleteFile( absFilename );
+
+    return success;
+}
+
+// Orbits the model, with the camera aimed at a point that wanders around the model, so that the views range from all of the
+// model being visible, to only part of it, to only its back faces
+static std::vector<MeshletCullView> GenerateCameraPath( const AABB& modelAABB, u32 numViews )
+{
+    const vec3 center   = modelAABB.Center();
+    const vec3 extent   = modelAABB.Extent();
+    const f32 modelSize = Length( extent );
+
+    std::vector<MeshletCullView> views( numViews );
+    for ( u32 viewIdx = 0; viewIdx < numViews; ++viewIdx )
+    {
+        const f32 angle       = 2 * PI * viewIdx / numViews;
+        const vec3 target     = center + 0.4f * vec3( extent.x * sinf( 2 * angle ), extent.y * cosf( 3 * angle ), 0 );
+        const vec3 pos        = center + 0.75f * modelSize * vec3( sinf( angle ), 0, cosf( angle ) );
+        const vec3 forward    = Normalize( target - pos );
+        const vec3 right      = Normalize( Cross( forward, vec3( 0, 1, 0 ) ) );
+        const vec3 up         = Cross( right, forward );
+        MeshletCullView& view = views[viewIdx];
+        view.cameraPos        = pos;
+        view.frustum.Update( DegToRad( 45.0f ), 0.01f * modelSize, 10 * modelSize, 16.0f / 9.0f, pos, forward, up, right );
+    }
+
+    return views;
+}
+
+// Culls every full detail meshlet of the model from each view of a camera path, with both the batched and the scalar tests
+static bool ReportCulling( const std::string& relFilename, const BenchmarkSettings& settings )
+{
+    omp_set_num_threads( 1 );
+    ModelCreateInfo createInfo;
+    createInfo.name     = GetFilenameStem( relFilename );
+    createInfo.filename = relFilename;
+    Model model;
+    if ( !model.Load( &createInfo ) )
+        return false;
+
+    AABB modelAABB = {};
+    for ( const AABB& aabb : model.meshAABBs )
+        modelAABB.Encompass( aabb );
+    const std::vector<MeshletCullView> views = GenerateCameraPath( modelAABB, 64 );
+    std::vector<MeshletCullBatches> meshBatches( model.meshes.size() );
+    for ( size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx )
+        meshBatches[meshIdx].Build( model.meshes[meshIdx].meshletCullDatas.data(), model.meshes[meshIdx].numFullDetailMeshlets );
+
+    MeshletCullStats totalStats;
+    std::vector<u32> visibleMeshlets;
+    f64 batchedMS = FLT_MAX;
+    for ( u32 run = 0; run < settings.numRuns; ++run )
+    {
+        MeshletCullStats runStats;
+        auto startTime = Time::GetTimePoint();
+        for ( const MeshletCullView& view : views )
+        {
+            for ( size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx )
+            {
+                CullMesh( view, model.meshAABBs[meshIdx], model.meshes[meshIdx].meshlets.data(), meshBatches[meshIdx], visibleMeshlets,
+                    runStats );
+            }
+        }
+        batchedMS  = std::min( batchedMS, Time::GetTimeSince( startTime ) );
+        totalStats = runStats;
+    }
+
+    f64 scalarMS         = FLT_MAX;
+    u64 numScalarVisible = 0;
+    for ( u32 run = 0; run < settings.numRuns; ++run )
+    {
+        numScalarVisible = 0;
+        auto startTime   = Time::GetTimePoint();
+        for ( const MeshletCullView& view : views )
+        {
+            for ( const Mesh& mesh : model.meshes )
+            {
+                for ( u32 meshletIdx = 0; meshletIdx < mesh.numFullDetailMeshlets; ++meshletIdx )
+                    numScalarVisible += IsMeshletVisible( view, mesh.meshletCullDatas[meshletIdx] );
+            }
+        }
+        scalarMS = std::min( scalarMS, Time::GetTimeSince( startTime ) );
+    }
+
+    // The AABB test can only remove meshlets that the sphere test would have kept, so compare the meshlet tests on their own
+    std::vector<u32> expectedMeshlets;
+    for ( const MeshletCullView& view : views )
+    {
+        for ( size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx )
+        {
+            const Mesh& mesh = model.meshes[meshIdx];
+            CullMeshlets( view, meshBatches[meshIdx], visibleMeshlets );
+            expectedMeshlets.clear();
+            for ( u32 meshletIdx = 0; meshletIdx < mesh.numFullDetailMeshlets; ++meshletIdx )
+            {
+                if ( IsMeshletVisible( view, mesh.meshletCullDatas[meshletIdx] ) )
+                    expectedMeshlets.push_back( meshletIdx );
+            }
+            if ( visibleMeshlets != expectedMeshlets )
+            {
+                LOG_ERR( "    The batched and scalar meshlet culling disagree on mesh '%s'!", mesh.name.c_str() );
+                return false;
+            }
+        }
+    }
+    model.Free();
+
+    const f64 numViews    = (f64)views.size();
+    const f64 numMeshlets = (f64)totalStats.numMeshlets;
+    LOG( "    Culling over %zu views: on average %.1f%% of the meshes, %.1f%% of the meshlets (%.1f%% frustum culled, %.1f%% backface "
+         "culled), and %.1f%% of the tris are visible",
+        views.size(), 100.0 * totalStats.visibleMeshes / totalStats.numMeshes, 100.0 * totalStats.visibleMeshlets / numMeshlets,
+        100.0 * totalStats.frustumCulledMeshlets / numMeshlets, 100.0 * totalStats.backfaceCulledMeshlets / numMeshlets,
+        100.0 * totalStats.visibleTris / totalStats.numTris );
+    LOG( "    %.0f visible meshlets and %.0f visible tris per view. The mesh AABB tests removed another %.0f meshlets per view",
+        totalStats.visibleMeshlets / numViews, totalStats.visibleTris / numViews,
+        ( numScalarVisible - totalStats.visibleMeshlets ) / numViews );
+    LOG( "    Batched culling: %.1f M meshlets/s, scalar: %.1f M meshlets/s (%.2fx)", numMeshlets / ( 1000.0 * batchedMS ),
+        numMeshlets / ( 1000.0 * scalarMS ), scalarMS / batchedMS );
+
+    return true;
+}
+
+static bool BenchmarkModel( const std::string& label, const PModel& pmodel, const BenchmarkSettings& settings )
+{
+    // Model::Load only takes filenames relative to the asset directory, so put them in with the rest of the generated files
+    const std::string relFilename = "cache/model_benchmark/" + label + ".pmodelb";
+    const std::string absFilename = GetAbsPath_ModelFilename( relFilename );
+    CreateDirectory( GetParentPath( absFilename ) );
+    PModel toSave = pmodel;
+    if ( !toSave.Save( absFilename ) )
+        return false;
+
+    f64 pmodelLoadMS = FLT_MAX;
+    for ( u32 run = 0; run < settings.numRuns; ++run )
+    {
+        PModel loaded;
+        auto startTime = Time::GetTimePoint();
+        if ( !loaded.Load( absFilename ) )
+            return false;
+        pmodelLoadMS = std::min( pmodelLoadMS, Time::GetTimeSince( startTime ) );
+    }
+
+    const u32 maxThreads = (u32)omp_get_num_procs();
+    LoadResult serial, parallel;
+    if ( !TimeModelLoad( relFilename, 1, settings, serial ) || !TimeModelLoad( relFilename, maxThreads, settings, parallel ) )
+        return false;
+
+    size_t numTris = 0;
+    for ( const PModel::Mesh& mesh : pmodel.meshes )
+        numTris += mesh.indices.size() / 3;
+
+    LOG( "%s: %zu meshes, %.2fM tris, %u meshlets. PModel::Load %.1f ms", label.c_str(), pmodel.meshes.size(), numTris / 1e6,
+        parallel.numMeshlets, pmodelLoadMS );
+    LOG( "    Model::Load with 1 thread: %.1f ms, with %u threads: %.1f ms (%.2fx)", serial.fastestMS, maxThreads, parallel.fastestMS,
+        serial.fastestMS / parallel.fastestMS );
+    if ( parallel.numMeshes != pmodel.meshes.size() )
+        LOG( "    Model::Load split the meshes into %u, to stay under the meshlet limit", parallel.numMeshes );
+    if ( serial.outputHash != parallel.outputHash )
+    {
+        LOG_ERR( "    Output differs between 1 and %u threads! %llx vs %llx", maxThreads, (unsigned long long)serial.outputHash,
+            (unsigned long long)parallel.outputHash );
+        return false;
+    }
+
+    bool success = ReportFastfileEncoding( relFilename, settings );
+    success      = success && ( !settings.textParsing || ReportTextParsing( label, pmodel, settings ) );
+    success      = success && ( !settings.generateLODs || ReportLODCuts( relFilename ) );
+    success      = success && ( !settings.vertexOrder || ReportVertexOrder( label, pmodel, settings ) );
+    success      = success && ( !settings.culling || ReportCulling( relFilename, settings ) );
+    DeleteFile( absFilename );
+
+    return success;
+}
+
+// A mesh way over the meshlet limit should get split up into parts that are each under it, without dropping any triangles
+static bool StressTestMeshSplitting( u32 numTris )
+{
+    PModel pmodel;
+    PModel::Mesh& pMesh = pmodel.meshes.emplace_back();
+    GenerateGridMesh( pMesh, numTris, vec3( 0 ), 0 );
+    pMesh.name         = "stress";
+    pMesh.materialName = "default";
+    numTris            = (u32)pMesh.indices.size() / 3;
+
+    const std::string relFilename = "cache/model_benchmark/stress.pmodelb";
+    const std::string absFilename = GetAbsPath_ModelFilename( relFilename );
+    CreateDirectory( GetParentPath( absFilename ) );
+    if ( !pmodel.Save( absFilename ) )
+        return false;
+    pmodel = {};
+
+    ModelCreateInfo createInfo;
+    createInfo.name     = GetFilenameStem( relFilename );
+    createInfo.filename = relFilename;
+    Model model;
+    auto startTime = Time::GetTimePoint();
+    bool success   = model.Load( &createInfo );
+    DeleteFile( absFilename );
+    if ( !success )
+        return false;
+    f64 loadMS = Time::GetTimeSince( startTime );
+
+    u32 mostMeshlets   = 0;
+    u64 numOutputTris  = 0;
+    f32 summedAABBArea = 0;
+    AABB modelAABB     = {};
+    for ( size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx )
+    {
+        const Mesh& mesh = model.meshes[meshIdx];
+        mostMeshlets     = std::max( mostMeshlets, mesh.numFullDetailMeshlets );
+        for ( u32 meshletIdx = 0; meshletIdx < mesh.numFullDetailMeshlets; ++meshletIdx )
+            numOutputTris += mesh.meshlets[meshletIdx].triangleCount;
+
+        const vec3 extent = model.meshAABBs[meshIdx].Extent();
+        summedAABBArea += extent.x * extent.y;
+        modelAABB.Encompass( model.meshAABBs[meshIdx] );
+    }
+    const vec3 modelExtent = modelAABB.Extent();
+
+    LOG( "Stress test: %.2fM tris split into %zu meshes in %.1f ms. Most meshlets in one mesh: %u. Mesh AABB overlap: %.3fx",
+        numTris / 1e6, model.meshes.size(), loadMS, mostMeshlets, summedAABBArea / ( modelExtent.x * modelExtent.y ) );
+    if ( mostMeshlets > MAX_MESHLETS_PER_MESH )
+    {
+        LOG_ERR( "    A mesh still has more than %u meshlets!", (u32)MAX_MESHLETS_PER_MESH );
+        return false;
+    }
+    if ( numOutputTris != numTris )
+    {
+        LOG_ERR( "    Expected %u triangles in the meshlets, but found %llu", numTris, (unsigned long long)numOutputTris );
+        return false;
+    }
+
+    return true;
+}
+
+int main( int argc, char* argv[] )
+{
+    EngineInitialize();
+
+    BenchmarkSettings settings;
+    if ( !ParseCommandLineArgs( argc, argv, settings ) )
+    {
+        EngineShutdown();
+        return 0;
+    }
+
+    if ( settings.stressTestTris )
+    {
+        bool success = StressTestMeshSplitting( settings.stressTestTris );
+        EngineShutdown();
+        return success ? 0 : 1;
+    }
+
+    // Like a scanned prop: one huge mesh that can only be parallelized within the mesh
+    PModel hugeModel;
+    GenerateGridMesh( hugeModel.meshes.emplace_back(), settings.hugeMeshTris, vec3( 0 ), 0 );
+    hugeModel.meshes[0].name         = "huge";
+    hugeModel.meshes[0].materialName = "default";
+
+    // Like an imported scene or kitbash set: lots of small meshes, which each only have a few meshlet blocks
+    PModel manyMeshModel;
+    manyMeshModel.meshes.resize( settings.numSmallMeshes );
+    for ( u32 meshIdx = 0; meshIdx < settings.numSmallMeshes; ++meshIdx )
+    {
+        PModel::Mesh& mesh = manyMeshModel.meshes[meshIdx];
+        GenerateGridMesh( mesh, settings.smallMeshTris, vec3( 1.5f * ( meshIdx % 32 ), 1.5f * ( meshIdx / 32 ), 0 ), meshIdx + 1 );
+        mesh.name         = "mesh" + std::to_string( meshIdx );
+        mesh.materialName = "default";
+    }
+
+    bool success = BenchmarkModel( "huge_mesh", hugeModel, settings );
+    success      = success && BenchmarkModel( "many_meshes", manyMeshModel, settings );
+
+    EngineShutdown();
+
+    return success ? 0 : 1;
+}
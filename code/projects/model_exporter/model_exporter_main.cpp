@@ -14,6 +14,8 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <omp.h>
 #include <unordered_set>
 
 using namespace PG;
@@ -62,47 +64,48 @@ static void ProcessVertices( const aiMesh* paiMesh, const mat4& localToWorldMat,
     u32 numZeroBefore = 0;
     u32 numZeroAfter  = 0;
     u32 numVerts      = paiMesh->mNumVertices;
-    pgMesh.vertices.resize( numVerts );
+    pgMesh.Resize( numVerts );
     for ( u32 vIdx = 0; vIdx < numVerts; ++vIdx )
     {
-        PModel::Vertex& v = pgMesh.vertices[vIdx];
-        v.pos             = AiToPG( paiMesh->mVertices[vIdx] );
-        v.pos             = vec3( localToWorldMat * vec4( v.pos, 1.0f ) );
-        v.normal          = AiToPG( paiMesh->mNormals[vIdx] );
-        if ( Length( v.normal ) == 0 )
+        vec3& pos    = pgMesh.positions[vIdx];
+        vec3& normal = pgMesh.normals[vIdx];
+        pos          = AiToPG( paiMesh->mVertices[vIdx] );
+        pos          = vec3( localToWorldMat * vec4( pos, 1.0f ) );
+        normal       = AiToPG( paiMesh->mNormals[vIdx] );
+        if ( Length( normal ) == 0 )
             numZeroBefore++;
-        v.normal = vec3( normalMatrix * vec4( v.normal, 0.0f ) );
-        if ( Length( v.normal ) == 0 )
+        normal = vec3( normalMatrix * vec4( normal, 0.0f ) );
+        if ( Length( normal ) == 0 )
             numZeroAfter++;
-        PG_ASSERT( !any( isnan( v.pos ) ) );
-        PG_ASSERT( !any( isnan( v.normal ) ) );
-        v.numBones = 0;
+        PG_ASSERT( !any( isnan( pos ) ) );
+        PG_ASSERT( !any( isnan( normal ) ) );
 
         if ( pgMesh.hasTangents )
         {
-            v.tangent   = AiToPG( paiMesh->mTangents[vIdx] );
-            v.tangent   = vec3( localToWorldMat * vec4( v.tangent, 0.0f ) );
-            v.bitangent = AiToPG( paiMesh->mBitangents[vIdx] );
-            v.bitangent = vec3( localToWorldMat * vec4( v.bitangent, 0.0f ) );
+            pgMesh.tangents[vIdx]   = vec3( localToWorldMat * vec4( AiToPG( paiMesh->mTangents[vIdx] ), 0.0f ) );
+            pgMesh.bitangents[vIdx] = vec3( localToWorldMat * vec4( AiToPG( paiMesh->mBitangents[vIdx] ), 0.0f ) );
         }
 
         for ( u32 uvSetIdx = 0; uvSetIdx < pgMesh.numUVChannels; ++uvSetIdx )
         {
-            u32 aiUVSetIdx  = uvSetRemap[uvSetIdx];
-            vec3 uvw        = AiToPG( paiMesh->mTextureCoords[aiUVSetIdx][vIdx] );
-            v.uvs[uvSetIdx] = vec2( uvw.x, uvw.y );
+            u32 aiUVSetIdx              = uvSetRemap[uvSetIdx];
+            vec3 uvw                    = AiToPG( paiMesh->mTextureCoords[aiUVSetIdx][vIdx] );
+            pgMesh.UV( vIdx, uvSetIdx ) = vec2( uvw.x, uvw.y );
         }
 
         for ( u32 colorSetIdx = 0; colorSetIdx < pgMesh.numColorChannels; ++colorSetIdx )
         {
-            u32 aiColorSetIdx     = colorSetRemap[colorSetIdx];
-            v.colors[colorSetIdx] = AiToPG( paiMesh->mColors[aiColorSetIdx][vIdx] );
+            u32 aiColorSetIdx                 = colorSetRemap[colorSetIdx];
+            pgMesh.Color( vIdx, colorSetIdx ) = AiToPG( paiMesh->mColors[aiColorSetIdx][vIdx] );
         }
     }
 
     if ( numZeroBefore || numZeroAfter )
         LOG( "Num normals with length zero: pre-transform %u, post %u", numZeroBefore, numZeroAfter );
 
+    if ( !pgMesh.hasBoneWeights )
+        return;
+
     std::vector<u32> numBonesPerVertex( numVerts, 0 );
     for ( u32 aiBoneIdx = 0; aiBoneIdx < paiMesh->mNumBones; ++aiBoneIdx )
     {
@@ -112,7 +115,7 @@ static void ProcessVertices( const aiMesh* paiMesh, const mat4& localToWorldMat,
             const aiVertexWeight& w = paiBone.mWeights[weightIdx];
             PG_ASSERT( w.mVertexId < numVerts );
             numBonesPerVertex[w.mVertexId]++;
-            pgMesh.vertices[w.mVertexId].AddBone( aiBoneIdx, w.mWeight );
+            pgMesh.AddBone( w.mVertexId, aiBoneIdx, w.mWeight );
         }
     }
 
@@ -125,13 +128,13 @@ static void ProcessVertices( const aiMesh* paiMesh, const mat4& localToWorldMat,
                 vIdx, pgMesh.name.c_str(), numBonesPerVertex[vIdx], PMODEL_MAX_BONE_WEIGHTS_PER_VERT, PMODEL_MAX_BONE_WEIGHTS_PER_VERT );
         }
 
-        PModel::Vertex& v = pgMesh.vertices[vIdx];
-        f32 weightTotal   = 0;
-        for ( u8 slot = 0; slot < v.numBones; ++slot )
-            weightTotal += v.boneWeights[slot];
+        f32* boneWeights = pgMesh.BoneWeights( vIdx );
+        f32 weightTotal  = 0;
+        for ( u8 slot = 0; slot < pgMesh.numBones[vIdx]; ++slot )
+            weightTotal += boneWeights[slot];
 
-        for ( u8 slot = 0; slot < v.numBones; ++slot )
-            v.boneWeights[slot] /= weightTotal;
+        for ( u8 slot = 0; slot < pgMesh.numBones[vIdx]; ++slot )
+            boneWeights[slot] /= weightTotal;
     }
 }
 
@@ -198,21 +201,44 @@ void ParseNode( const std::string& filename, const std::vector<std::string>& mat
     }
 }
 
-static bool ConvertModel( const std::string& filename, std::string& outputJSON )
+// Everything about one source file that has to be kept around between the export phases
+struct ModelExport
 {
-    LOG( "Parsing file %s...", filename.c_str() );
-    Assimp::Importer importer;
-    const aiScene* scene =
-        importer.ReadFile( filename.c_str(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_JoinIdenticalVertices |
-                                                 aiProcess_CalcTangentSpace | aiProcess_RemoveRedundantMaterials );
-    if ( !scene )
-    {
-        LOG_ERR( "Assimp error while parsing model file '%s': '%s'", filename.c_str(), importer.GetErrorString() );
+    std::string filename;
+    std::string modelName;
+    std::unique_ptr<Assimp::Importer> importer; // owns the scene, freed once the materials are output
+    const aiScene* scene = nullptr;
+    std::vector<std::string> materialNames;
+    PModel pmodel;
+    std::string json;
+    bool success = false;
+
+    f64 importMS   = 0;
+    f64 buildMS    = 0;
+    f64 materialMS = 0;
+    f64 saveMS     = 0;
+};
+
+// Only touches the ModelExport, so any number of these can run at once
+static bool ImportModel( ModelExport& model )
+{
+    LOG( "Parsing file %s...", model.filename.c_str() );
+    auto startTime = Time::GetTimePoint();
+    model.importer = std::make_unique<Assimp::Importer>();
+    model.scene    = model.importer->ReadFile(
+        model.filename.c_str(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_JoinIdenticalVertices |
+                                    aiProcess_CalcTangentSpace | aiProcess_RemoveRedundantMaterials );
+    model.importMS = Time::GetTimeSince( startTime );
+    if ( !model.scene )
+    {
+        LOG_ERR( "Assimp error while parsing model file '%s': '%s'", model.filename.c_str(), model.importer->GetErrorString() );
+        model.importer.reset();
         return false;
     }
 
-    std::vector<std::string> materialNames;
-    bool isOBJ = GetFileExtension( filename ) == ".obj";
+    startTime            = Time::GetTimePoint();
+    const aiScene* scene = model.scene;
+    bool isOBJ           = GetFileExtension( model.filename ) == ".obj";
     for ( u32 i = 0; i < scene->mNumMaterials; ++i )
     {
         std::string matName = scene->mMaterials[i]->GetName().C_Str();
@@ -221,62 +247,80 @@ static bool ConvertModel( const std::string& filename, std::string& outputJSON )
         else if ( matName == "" )
             matName = "material_" + std::to_string( i );
 
-        materialNames.push_back( matName );
+        model.materialNames.push_back( matName );
     }
 
-    std::string modelName = GetFilenameStem( filename );
+    model.modelName = GetFilenameStem( model.filename );
+    ParseNode( model.filename, model.materialNames, scene, scene->mRootNode, mat4( 1.0f ), model.pmodel );
+    model.buildMS = Time::GetTimeSince( startTime );
 
+    return true;
+}
+
+// Has to be called serially, in file order: the unique material and textureset names depend on what was already output
+static void OutputMaterials( ModelExport& model )
+{
+    auto startTime = Time::GetTimePoint();
     MaterialContext matContext;
-    matContext.scene     = scene;
-    matContext.file      = filename;
-    matContext.modelName = modelName;
+    matContext.scene     = model.scene;
+    matContext.file      = model.filename;
+    matContext.modelName = model.modelName;
     std::unordered_map<std::string, std::string> matNameRemap;
     matNameRemap["default"] = "default";
-    for ( u32 i = 0; i < scene->mNumMaterials; ++i )
+    for ( u32 i = 0; i < model.scene->mNumMaterials; ++i )
     {
-        if ( materialNames[i] != "default" )
+        if ( model.materialNames[i] != "default" )
         {
-            matContext.assimpMat    = scene->mMaterials[i];
-            matContext.localMatName = materialNames[i];
+            matContext.assimpMat    = model.scene->mMaterials[i];
+            matContext.localMatName = model.materialNames[i];
             std::string uniqueMaterialName;
-            OutputMaterial( matContext, outputJSON, uniqueMaterialName );
+            OutputMaterial( matContext, model.json, uniqueMaterialName );
             matNameRemap[matContext.localMatName] = uniqueMaterialName;
         }
     }
 
-    PModel pmodel;
+    for ( PModel::Mesh& mesh : model.pmodel.meshes )
+        mesh.materialName = matNameRemap[mesh.materialName];
 
-    aiNode* root = scene->mRootNode;
-    ParseNode( filename, materialNames, scene, scene->mRootNode, mat4( 1.0f ), pmodel );
+    model.scene = nullptr;
+    model.importer.reset();
+    model.materialMS = Time::GetTimeSince( startTime );
+}
 
+// Like ImportModel, this can run for several files at once
+static bool SaveModel( ModelExport& model )
+{
+    PModel& pmodel    = model.pmodel;
     size_t totalVerts = 0;
     size_t totalTris  = 0;
-    for ( PModel::Mesh& mesh : pmodel.meshes )
+    for ( const PModel::Mesh& mesh : pmodel.meshes )
     {
-        mesh.materialName = matNameRemap[mesh.materialName];
-        totalVerts += mesh.vertices.size();
+        totalVerts += mesh.NumVertices();
         totalTris += mesh.indices.size() / 3;
     }
 
     if ( g_options.printModelInfo )
     {
-        LOG( "Model %s:", filename.c_str() );
+        LOG( "Model %s:", model.filename.c_str() );
         pmodel.PrintInfo();
     }
     else
     {
-        LOG( "Model %s\n\tMeshes: %u, Materials: %u, Triangles: %u\n\tVertices: %u", filename.c_str(), pmodel.meshes.size(),
-            materialNames.size(), totalTris, totalVerts );
+        LOG( "Model %s\n\tMeshes: %u, Materials: %u, Triangles: %u\n\tVertices: %u", model.filename.c_str(), pmodel.meshes.size(),
+            model.materialNames.size(), totalTris, totalVerts );
     }
 
-    std::string outputModelFilename = GetFilenameMinusExtension( filename ) + ".pmodelb";
+    auto startTime                  = Time::GetTimePoint();
+    std::string outputModelFilename = GetFilenameMinusExtension( model.filename ) + ".pmodelb";
     if ( !pmodel.Save( outputModelFilename, g_options.floatPrecision, true ) )
         return false;
+    model.saveMS = Time::GetTimeSince( startTime );
 
     std::string relPath = GetRelativePathToDir( outputModelFilename, g_options.rootDir );
-    outputJSON += "\t{ \"Model\": {\n\t\t\"name\": \"" + modelName + "\",\n\t\t\"filename\": \"" + relPath + "\"\n\t} },\n";
+    model.json += "\t{ \"Model\": {\n\t\t\"name\": \"" + model.modelName + "\",\n\t\t\"filename\": \"" + relPath + "\"\n\t} },\n";
 
-    LOG( "Done processing file %s", filename.c_str() );
+    LOG( "Done processing file %s. Import %.1f ms, PModel build %.1f ms, materials %.1f ms, save %.1f ms", model.filename.c_str(),
+        model.importMS, model.buildMS, model.materialMS, model.saveMS );
 
     return true;
 }
@@ -508,21 +552,63 @@ int main( int argc, char* argv[] )
     }
     AssetDatabase::Init();
 
-    auto startTime         = Time::GetTimePoint();
+    auto startTime = Time::GetTimePoint();
+    BuildTextureSearchIndex();
+    f64 indexMS = Time::GetTimeSince( startTime );
+
+    // The imports, PModel builds, and saves of different files are independent, so those run in parallel. The materials have to be
+    // output in file order though, to keep the unique names stable from run to run. Files are done a chunk at a time, so that only a
+    // few of the assimp scenes and PModels are ever in memory at once
     size_t modelsConverted = 0;
     std::string outputJSON = "[\n";
     outputJSON.reserve( 1024 * 1024 );
-    // Cant run in parallel, since writing the output
-    // #pragma omp parallel for
-    for ( i32 i = 0; i < static_cast<i32>( filesToProcess.size() ); ++i )
-    {
-        std::string json;
-        json.reserve( 2 * 1024 );
-        modelsConverted += ConvertModel( filesToProcess[i], json );
-        outputJSON += json;
+    f64 totalImportMS   = 0;
+    f64 totalBuildMS    = 0;
+    f64 totalMaterialMS = 0;
+    f64 totalSaveMS     = 0;
+    const i32 numFiles  = static_cast<i32>( filesToProcess.size() );
+    const i32 chunkSize = 2 * omp_get_max_threads();
+    for ( i32 chunkStart = 0; chunkStart < numFiles; chunkStart += chunkSize )
+    {
+        const i32 chunkEnd = std::min( chunkStart + chunkSize, numFiles );
+        std::vector<ModelExport> models( chunkEnd - chunkStart );
+
+#pragma omp parallel for schedule( dynamic )
+        for ( i32 i = chunkStart; i < chunkEnd; ++i )
+        {
+            ModelExport& model = models[i - chunkStart];
+            model.filename     = filesToProcess[i];
+            model.success      = ImportModel( model );
+        }
+
+        for ( ModelExport& model : models )
+        {
+            if ( model.success )
+                OutputMaterials( model );
+        }
+
+#pragma omp parallel for schedule( dynamic )
+        for ( i32 i = 0; i < static_cast<i32>( models.size() ); ++i )
+        {
+            if ( models[i].success )
+                models[i].success = SaveModel( models[i] );
+        }
+
+        for ( const ModelExport& model : models )
+        {
+            totalImportMS += model.importMS;
+            totalBuildMS += model.buildMS;
+            totalMaterialMS += model.materialMS;
+            totalSaveMS += model.saveMS;
+            modelsConverted += model.success;
+            outputJSON += model.json;
+        }
     }
 
     LOG( "Models converted: %u in %.2f seconds", modelsConverted, Time::GetTimeSince( startTime ) / 1000.0f );
+    LOG( "Total time per phase (summed over all files): texture index %.1f ms, assimp import %.1f ms, PModel build %.1f ms, "
+         "materials %.1f ms, save %.1f ms",
+        indexMS, totalImportMS, totalBuildMS, totalMaterialMS, totalSaveMS );
     LOG( "Errors: %zu, Warnings: %u", filesToProcess.size() - modelsConverted, g_warnings.load() );
     if ( modelsConverted > 0 )
     {
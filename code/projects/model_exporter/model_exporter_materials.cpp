@@ -3,8 +3,10 @@
 #include "shared/filesystem.hpp"
 #include "shared/string.hpp"
 #include <optional>
+#include <unordered_map>
 
 std::string g_textureSearchDir;
+static std::unordered_map<std::string, std::string> s_textureSearchIndex;
 
 struct ImageInfo
 {
@@ -14,35 +16,42 @@ struct ImageInfo
     std::string type;
 };
 
+void BuildTextureSearchIndex()
+{
+    namespace fs = std::filesystem;
+    s_textureSearchIndex.clear();
+    std::error_code ec;
+    fs::recursive_directory_iterator itEntry( g_textureSearchDir, ec );
+    for ( ; !ec && itEntry != fs::recursive_directory_iterator(); itEntry.increment( ec ) )
+    {
+        std::error_code typeEc;
+        if ( !itEntry->is_regular_file( typeEc ) )
+            continue;
+
+        // Keep the first match, same as the old directory walk would have found
+        s_textureSearchIndex.try_emplace( itEntry->path().filename().string(), itEntry->path().string() );
+    }
+
+    if ( ec )
+        LOG_ERR( "Could not search the texture directory '%s': %s", g_textureSearchDir.c_str(), ec.message().c_str() );
+}
+
 static bool GetAssimpTexturePath( const aiMaterial* assimpMat, aiTextureType texType, std::string& absPathToTex )
 {
     aiString path;
-    namespace fs = std::filesystem;
-    u32 uvSet    = UINT_MAX;
+    u32 uvSet = UINT_MAX;
     if ( assimpMat->GetTexture( texType, 0, &path, NULL, &uvSet, NULL, NULL, NULL ) == AI_SUCCESS )
     {
         std::string name = StripWhitespace( path.data );
         absPathToTex     = name;
         // LOG( "UVSet: %u", uvSet );
 
-        std::string fullPath;
-        std::string basename = GetRelativeFilename( name );
-        for ( auto itEntry = fs::recursive_directory_iterator( g_textureSearchDir ); itEntry != fs::recursive_directory_iterator();
-              ++itEntry )
-        {
-            std::string itFile = itEntry->path().filename().string();
-            if ( basename == itEntry->path().filename().string() )
-            {
-                fullPath = GetAbsolutePath( itEntry->path().string() );
-                break;
-            }
-        }
-
-        if ( fullPath == "" )
+        auto it = s_textureSearchIndex.find( GetRelativeFilename( name ) );
+        if ( it == s_textureSearchIndex.end() )
         {
             return false;
         }
-        absPathToTex = fullPath;
+        absPathToTex = GetAbsolutePath( it->second );
     }
     else
     {
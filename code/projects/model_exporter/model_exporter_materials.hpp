@@ -4,6 +4,10 @@
 
 extern std::string g_textureSearchDir;
 
+// Maps every file basename under g_textureSearchDir to its absolute path, so texture lookups don't have to walk the directory
+// each time. Has to be called once g_textureSearchDir is set, and before any materials get output
+void BuildTextureSearchIndex();
+
 struct MaterialContext
 {
     const aiScene* scene;
@@ -1,7 +1,9 @@
 #include "filesystem.hpp"
 #include "logger.hpp"
+#include <atomic>
 #include <filesystem>
 #include <fstream>
+#include <random>
 
 namespace fs = std::filesystem;
 
@@ -134,6 +136,22 @@ bool CopyFile( const std::string& from, const std::string& to, bool overwriteExi
     return true;
 }
 
+bool RenameFile( const std::string& from, const std::string& to )
+{
+    std::error_code ec;
+    fs::rename( from, to, ec );
+    return !ec;
+}
+
+std::string GetUniqueTmpSuffix()
+{
+    static const unsigned long long processId = std::random_device{}() | ( (unsigned long long)std::random_device{}() << 32 );
+    static std::atomic<unsigned> counter      = 0;
+    char suffix[64];
+    snprintf( suffix, sizeof( suffix ), ".tmp_%016llx_%u", processId, counter++ );
+    return suffix;
+}
+
 void DeleteFile( const std::string& filename )
 {
     std::error_code ec;
@@ -36,6 +36,13 @@ void CreateDirectory( const std::string& dir, bool createParentDirs = true );
 // returns false if there was an error. If overwriteExisting is false, and 'to' exists, returns true
 bool CopyFile( const std::string& from, const std::string& to, bool overwriteExisting );
 
+// Renames 'from' to 'to', replacing 'to' if it already exists. Returns false if there was an error
+bool RenameFile( const std::string& from, const std::string& to );
+
+// Returns a suffix like ".tmp_<random process id>_<counter>" that is unique across threads and processes, even ones on
+// other machines writing to the same shared directory. Used for writing to a temporary file, before renaming it
+std::string GetUniqueTmpSuffix();
+
 // deletes single file or empty folder
 void DeleteFile( const std::string& filename );
 
@@ -1,23 +1,30 @@
 #pragma once
 
 #include "shared/math_vec.hpp"
-#include <functional>
+#include <cstring>
 #include <string>
+#include <type_traits>
+#define XXH_INLINE_ALL
+#include "xxHash/xxhash.h"
 
-template <class T>
-inline void HashCombine( std::size_t& seed, const T& v )
+// Cache names (and so the shared asset cache keys) are built from these hashes, so they need to come out the same with every
+// compiler and standard library. std::hash's output is implementation defined, so plain data gets hashed with xxHash instead
+inline void HashCombineBytes( std::size_t& seed, const void* data, size_t numBytes )
 {
-    std::hash<T> hasher;
-    seed ^= hasher( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+    seed = static_cast<std::size_t>( XXH3_64bits_withSeed( data, numBytes, seed ) );
 }
 
-inline void HashCombine( std::size_t& seed, const char* str )
+template <class T>
+    requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+inline void HashCombine( std::size_t& seed, const T& v )
 {
-    std::string s( str );
-    std::hash<std::string> hasher;
-    seed ^= hasher( s ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+    HashCombineBytes( seed, &v, sizeof( T ) );
 }
 
+inline void HashCombine( std::size_t& seed, const std::string& str ) { HashCombineBytes( seed, str.data(), str.length() ); }
+
+inline void HashCombine( std::size_t& seed, const char* str ) { HashCombineBytes( seed, str, strlen( str ) ); }
+
 inline void HashCombine( std::size_t& seed, vec2 v )
 {
     HashCombine( seed, v.x );
@@ -42,7 +49,9 @@ inline void HashCombine( std::size_t& seed, vec4 v )
 template <class T>
 inline size_t Hash( const T& x )
 {
-    return std::hash<T>{}( x );
+    size_t seed = 0;
+    HashCombine( seed, x );
+    return seed;
 }
 
 inline size_t Hash( const vec2& v )
@@ -156,3 +156,19 @@ void Serializer::Skip( size_t bytes )
         !bytes || ( m_currentReadPos - m_memMappedFile.getData() + bytes <= m_memMappedFile.size() ), "Skipping off the end of the file" );
     m_currentReadPos += bytes;
 }
+
+void Serializer::Align( size_t alignment )
+{
+    if ( m_memMappedFile.isValid() )
+    {
+        size_t offset = m_currentReadPos - m_memMappedFile.getData();
+        Skip( ( alignment - offset % alignment ) % alignment );
+    }
+    else
+    {
+        static constexpr u8 zeros[64] = {};
+        size_t padding                = ( alignment - m_bytesWritten % alignment ) % alignment;
+        PG_ASSERT( padding <= sizeof( zeros ) );
+        Write( zeros, padding );
+    }
+}
@@ -27,6 +27,9 @@ public:
     void Write( const void* buffer, size_t bytes );
     void Read( void* buffer, size_t bytes );
     void Skip( size_t bytes );
+    // Skips (reading) or zero pads (writing) to the next multiple of alignment bytes from the start of the file.
+    // Files are mapped page aligned, so aligned offsets are also aligned pointers when reading
+    void Align( size_t alignment );
 
     template <typename LenType = u32>
     void Write( const std::string& s )
@@ -3,7 +3,9 @@
 
 #if USING( LINUX_PROGRAM )
 // #define addrinfo sockaddr_in
+#include <errno.h>
 #include <string.h>
+#include <sys/select.h>
 #include <unistd.h>
 #define closesocket( x ) close( x )
 #define sprintf_s( ... ) sprintf( __VA_ARGS__ )
@@ -109,7 +111,21 @@ bool ClientSocket::SendData( const void* data, int sizeInBytes )
         return false;
     }
 #else  // #if USING( WINDOWS_PROGRAM )
-    return false;
+    ssize_t iResult = send( m_connectSocket, (const char*)data, sizeInBytes, MSG_NOSIGNAL );
+    if ( iResult == SOCKET_ERROR )
+    {
+        if ( errno == ECONNRESET || errno == EPIPE )
+            LOG_ERR( "ClientSocket::SendData error: the server was closed! Closing" );
+        else
+            LOG_ERR( "Failed to send command to server with error: %d. Closing", errno );
+        Close();
+        return false;
+    }
+    else if ( iResult != sizeInBytes )
+    {
+        LOG_ERR( "ClientSocket::SendData: only sent %d bytes", (int)iResult );
+        return false;
+    }
 #endif // #else // #if USING( WINDOWS_PROGRAM )
     return true;
 }
@@ -121,9 +137,13 @@ int ClientSocket::ReceiveData( void* buffer, int bufferSizeInBytes )
 
 bool ClientSocket::SetNonblockingRecv( int timeoutMilliseconds )
 {
+#if USING( WINDOWS_PROGRAM )
+    DWORD timeout = timeoutMilliseconds;
+#else  // #if USING( WINDOWS_PROGRAM )
     timeval timeout;
-    timeout.tv_sec  = timeoutMilliseconds;
-    timeout.tv_usec = 0;
+    timeout.tv_sec  = timeoutMilliseconds / 1000;
+    timeout.tv_usec = ( timeoutMilliseconds % 1000 ) * 1000;
+#endif // #else // #if USING( WINDOWS_PROGRAM )
     return setsockopt( m_connectSocket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof( timeout ) ) != SOCKET_ERROR;
 }
 
@@ -136,12 +156,12 @@ bool ServerSocket::Open( const char* host, const int port, int clientQueueSize )
     hints.ai_family   = AF_INET;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;
-    hints.ai_flags    = AI_PASSIVE;
+    hints.ai_flags    = host ? 0 : AI_PASSIVE; // no host means every interface
     char portStr[32];
-    sprintf_s( portStr, "%d", htonl( port ) );
+    sprintf_s( portStr, "%d", port );
 
     m_addr      = NULL;
-    int iResult = getaddrinfo( NULL, portStr, &hints, &m_addr );
+    int iResult = getaddrinfo( host, portStr, &hints, &m_addr );
     if ( iResult != 0 )
     {
         LOG_ERR( "getaddrinfo failed with error: %d", iResult );
@@ -159,6 +179,12 @@ bool ServerSocket::Open( const char* host, const int port, int clientQueueSize )
         return false;
     }
 
+#if USING( LINUX_PROGRAM )
+    // allow the engine to rebind right away after a restart, instead of waiting for TIME_WAIT to expire
+    int reuseAddr = 1;
+    setsockopt( m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof( reuseAddr ) );
+#endif // #if USING( LINUX_PROGRAM )
+
     iResult = bind( m_listenSocket, m_addr->ai_addr, (int)m_addr->ai_addrlen );
     if ( iResult == SOCKET_ERROR )
     {
@@ -184,6 +210,18 @@ bool ServerSocket::Open( const char* host, const int port, int clientQueueSize )
     return true;
 }
 
+int ServerSocket::WaitForConnection( int timeoutMilliseconds )
+{
+    fd_set readSet;
+    FD_ZERO( &readSet );
+    FD_SET( m_listenSocket, &readSet );
+    timeval timeout;
+    timeout.tv_sec  = timeoutMilliseconds / 1000;
+    timeout.tv_usec = ( timeoutMilliseconds % 1000 ) * 1000;
+    // the first argument is ignored on windows
+    return select( (int)m_listenSocket + 1, &readSet, NULL, NULL, &timeout );
+}
+
 bool ServerSocket::AcceptConnection( ClientSocket& clientSocket )
 {
     clientSocket.m_connectSocket = accept( m_listenSocket, NULL, NULL );
@@ -200,6 +238,10 @@ bool ServerSocket::Close()
     bool success = true;
     if ( m_listenSocket != INVALID_SOCKET )
     {
+#if USING( LINUX_PROGRAM )
+        // unlike windows, closing the socket doesn't wake up a thread blocked in accept()
+        shutdown( m_listenSocket, SHUT_RDWR );
+#endif // #if USING( LINUX_PROGRAM )
         int iResult = closesocket( m_listenSocket );
         if ( iResult == SOCKET_ERROR )
         {
@@ -48,7 +48,11 @@ public:
     ServerSocket() = default;
     ~ServerSocket();
 
+    // Only listens on the interface that host resolves to. Pass nullptr to listen on every interface
     bool Open( const char* host, const int port, int clientQueueSize = 16 );
+    // Waits up to timeoutMilliseconds for a client to connect. Returns > 0 if AcceptConnection won't block, 0 on a timeout,
+    // and < 0 on errors, which includes getting interrupted by a signal
+    int WaitForConnection( int timeoutMilliseconds );
     bool AcceptConnection( ClientSocket& clientSocket );
     bool Close();
 };